@@ -0,0 +1,135 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// create a tileCount x tileCount grid of height field tiles, each of gridSize x gridSize quads, with a CullNode bounding each tile
+vsg::ref_ptr<vsg::Node> createTerrain(uint32_t tileCount, uint32_t gridSize)
+{
+    auto group = vsg::Group::create();
+    for (uint32_t ty = 0; ty < tileCount; ++ty)
+    {
+        for (uint32_t tx = 0; tx < tileCount; ++tx)
+        {
+            uint32_t numVertices = (gridSize + 1) * (gridSize + 1);
+            auto vertices = vsg::vec3Array::create(numVertices);
+            auto indices = vsg::uintArray::create(gridSize * gridSize * 6);
+
+            auto vertex_itr = vertices->begin();
+            for (uint32_t r = 0; r <= gridSize; ++r)
+            {
+                for (uint32_t c = 0; c <= gridSize; ++c)
+                {
+                    float x = float(tx) + float(c) / float(gridSize);
+                    float y = float(ty) + float(r) / float(gridSize);
+                    *(vertex_itr++) = vsg::vec3(x, y, 0.1f * std::sin(x * 3.0f) * std::cos(y * 2.0f));
+                }
+            }
+
+            auto index_itr = indices->begin();
+            for (uint32_t r = 0; r < gridSize; ++r)
+            {
+                for (uint32_t c = 0; c < gridSize; ++c)
+                {
+                    uint32_t i = r * (gridSize + 1) + c;
+                    *(index_itr++) = i;
+                    *(index_itr++) = i + 1;
+                    *(index_itr++) = i + gridSize + 1;
+                    *(index_itr++) = i + gridSize + 1;
+                    *(index_itr++) = i + 1;
+                    *(index_itr++) = i + gridSize + 2;
+                }
+            }
+
+            auto vid = vsg::VertexIndexDraw::create();
+            vid->assignArrays(vsg::DataList{vertices});
+            vid->assignIndices(indices);
+            vid->indexCount = static_cast<uint32_t>(indices->size());
+            vid->instanceCount = 1;
+
+            vsg::dsphere bound(double(tx) + 0.5, double(ty) + 0.5, 0.0, 0.75);
+            group->addChild(vsg::CullNode::create(bound, vid));
+        }
+    }
+    return group;
+}
+
+template<typename F>
+double time_ms(uint32_t numRepeats, F func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numRepeats; ++i) func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / double(numRepeats);
+}
+
+int main(int argc, char** argv)
+{
+    vsg::CommandLine arguments(&argc, argv);
+    auto numLineSegments = arguments.value<uint32_t>(1000, "--segments");
+    auto tileCount = arguments.value<uint32_t>(8, "--tiles");
+    auto gridSize = arguments.value<uint32_t>(64, "--grid");
+    auto numRepeats = arguments.value<uint32_t>(5, "--repeats");
+    bool useTriangleBVH = !arguments.read("--no-bvh");
+    auto hitMode = arguments.read("--all-hits") ? vsg::Intersector::ALL_HITS : vsg::Intersector::CLOSEST_HIT;
+    if (arguments.errors()) return arguments.writeErrorMessages(std::cerr);
+
+    auto scene = createTerrain(tileCount, gridSize);
+
+    // vertical line segments at random positions over the terrain
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> distribution(0.0, double(tileCount));
+    vsg::MultiLineSegmentIntersector::LineSegments lineSegments(numLineSegments);
+    for (auto& lineSegment : lineSegments)
+    {
+        double x = distribution(generator);
+        double y = distribution(generator);
+        lineSegment.start.set(x, y, 1.0);
+        lineSegment.end.set(x, y, -1.0);
+    }
+
+    size_t separateHits = 0;
+    double separateTime = time_ms(numRepeats, [&]() {
+        separateHits = 0;
+        for (auto& lineSegment : lineSegments)
+        {
+            auto intersector = vsg::LineSegmentIntersector::create(lineSegment.start, lineSegment.end);
+            intersector->hitMode = hitMode;
+            intersector->useTriangleBVH = useTriangleBVH;
+            scene->accept(*intersector);
+            separateHits += intersector->intersections.size();
+        }
+    });
+
+    // the MultiLineSegmentIntersector is reused between repeats, as applications intersecting every frame would
+    auto multiIntersector = vsg::MultiLineSegmentIntersector::create(lineSegments);
+    multiIntersector->hitMode = hitMode;
+    multiIntersector->useTriangleBVH = useTriangleBVH;
+
+    size_t multiHits = 0;
+    double multiTime = time_ms(numRepeats, [&]() {
+        multiIntersector->reset(lineSegments);
+        scene->accept(*multiIntersector);
+        multiIntersector->sort();
+        multiHits = multiIntersector->hits.size();
+    });
+
+    std::cout << numLineSegments << " line segments, " << (tileCount * tileCount) << " tiles of " << (2 * gridSize * gridSize) << " triangles, TriangleBVH " << (useTriangleBVH ? "on" : "off") << std::endl;
+    std::cout << "    separate LineSegmentIntersectors : " << separateTime << "ms, " << separateHits << " hits" << std::endl;
+    std::cout << "    MultiLineSegmentIntersector      : " << multiTime << "ms, " << multiHits << " hits" << std::endl;
+    std::cout << "    speed up " << (separateTime / multiTime) << "x" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+
+// map based MemorySlots as used before the two level segregated fit scheme, kept for comparison
+class MapMemorySlots
+{
+public:
+    using OptionalOffset = std::pair<bool, size_t>;
+
+    explicit MapMemorySlots(size_t availableMemorySize)
+    {
+        insertAvailableSlot(0, availableMemorySize);
+    }
+
+    OptionalOffset reserve(size_t size, size_t alignment)
+    {
+        for (auto itr = _availableMemory.lower_bound(size); itr != _availableMemory.end(); ++itr)
+        {
+            size_t slotSize = itr->first;
+            size_t slotStart = itr->second;
+            size_t slotEnd = slotStart + slotSize;
+            size_t alignedStart = ((slotStart + alignment - 1) / alignment) * alignment;
+            size_t alignedEnd = alignedStart + size;
+            if (alignedEnd <= slotEnd)
+            {
+                removeAvailableSlot(slotStart, slotSize);
+                if (slotStart < alignedStart) insertAvailableSlot(slotStart, alignedStart - slotStart);
+                if (alignedEnd < slotEnd) insertAvailableSlot(alignedEnd, slotEnd - alignedEnd);
+                _reservedMemory.emplace(alignedStart, size);
+                return {true, alignedStart};
+            }
+        }
+        return {false, 0};
+    }
+
+    bool release(size_t offset, size_t)
+    {
+        auto itr = _reservedMemory.find(offset);
+        if (itr == _reservedMemory.end()) return false;
+
+        size_t slotStart = offset;
+        size_t slotEnd = offset + itr->second;
+        _reservedMemory.erase(itr);
+
+        auto next_slot_itr = _offsetSizes.lower_bound(slotStart);
+        if (next_slot_itr != _offsetSizes.begin() && !_offsetSizes.empty())
+        {
+            auto prev_slot_itr = std::prev(next_slot_itr);
+            if (prev_slot_itr->first + prev_slot_itr->second == slotStart)
+            {
+                slotStart = prev_slot_itr->first;
+                removeAvailableSlot(prev_slot_itr->first, prev_slot_itr->second);
+            }
+        }
+        if (next_slot_itr != _offsetSizes.end() && next_slot_itr->first == slotEnd)
+        {
+            slotEnd = next_slot_itr->first + next_slot_itr->second;
+            removeAvailableSlot(next_slot_itr->first, next_slot_itr->second);
+        }
+
+        insertAvailableSlot(slotStart, slotEnd - slotStart);
+        return true;
+    }
+
+protected:
+    std::multimap<size_t, size_t> _availableMemory;
+    std::map<size_t, size_t> _offsetSizes;
+    std::map<size_t, size_t> _reservedMemory;
+
+    void insertAvailableSlot(size_t offset, size_t size)
+    {
+        _offsetSizes.emplace(offset, size);
+        _availableMemory.emplace(size, offset);
+    }
+
+    void removeAvailableSlot(size_t offset, size_t size)
+    {
+        _offsetSizes.erase(offset);
+        auto end = _availableMemory.upper_bound(size);
+        for (auto itr = _availableMemory.lower_bound(size); itr != end; ++itr)
+        {
+            if (itr->second == offset)
+            {
+                _availableMemory.erase(itr);
+                break;
+            }
+        }
+    }
+};
+
+struct Operation
+{
+    bool reserve;
+    size_t size;      // size to reserve
+    size_t alignment; // alignment of reserve
+    size_t index;     // index of the reservation to release
+};
+
+// mix of reserves and releases in random order, with sizes spread logarithmically from 64 bytes to 1MB like the buffers and images of paged tiles.
+// Reserves are favoured until around numLive reservations are held, then releases, so the block stays close to full and fragments as it would when paging.
+std::vector<Operation> createOperations(uint32_t numOperations, uint32_t numLive, uint32_t seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> log2Size(6.0, 20.0);
+    std::uniform_real_distribution<double> probability(0.0, 1.0);
+
+    std::vector<Operation> operations;
+    operations.reserve(numOperations);
+    size_t numReserved = 0;
+    for (uint32_t i = 0; i < numOperations; ++i)
+    {
+        double reserveProbability = (numReserved < numLive) ? 0.75 : 0.25;
+        if (numReserved == 0 || probability(generator) < reserveProbability)
+        {
+            size_t alignment = probability(generator) < 0.5 ? 4 : 256;
+            operations.push_back(Operation{true, static_cast<size_t>(std::exp2(log2Size(generator))), alignment, 0});
+            ++numReserved;
+        }
+        else
+        {
+            operations.push_back(Operation{false, 0, 0, std::uniform_int_distribution<size_t>(0, numReserved - 1)(generator)});
+            --numReserved;
+        }
+    }
+    return operations;
+}
+
+template<class Slots>
+double run(const std::vector<Operation>& operations, size_t blockSize, uint32_t numRounds, size_t& numFailed)
+{
+    numFailed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < numRounds; ++round)
+    {
+        Slots slots(blockSize);
+        std::vector<std::pair<size_t, size_t>> reserved; // offset, size
+        for (auto& operation : operations)
+        {
+            if (operation.reserve)
+            {
+                auto [ok, offset] = slots.reserve(operation.size, operation.alignment);
+                if (ok)
+                    reserved.emplace_back(offset, operation.size);
+                else
+                    ++numFailed;
+            }
+            else if (!reserved.empty())
+            {
+                size_t index = operation.index % reserved.size();
+                slots.release(reserved[index].first, reserved[index].second);
+                reserved[index] = reserved.back();
+                reserved.pop_back();
+            }
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    vsg::CommandLine arguments(&argc, argv);
+    auto numOperations = arguments.value<uint32_t>(200000, "--operations");
+    auto numRounds = arguments.value<uint32_t>(20, "--rounds");
+    auto blockSize = arguments.value<size_t>(64 * 1024 * 1024, "--block-size");
+    auto numLive = arguments.value<uint32_t>(600, "--live");
+    auto seed = arguments.value<uint32_t>(1, "--seed");
+    if (arguments.errors()) return arguments.writeErrorMessages(std::cerr);
+
+    auto operations = createOperations(numOperations, numLive, seed);
+
+    size_t mapFailed = 0, tlsfFailed = 0;
+    double mapTime = run<MapMemorySlots>(operations, blockSize, numRounds, mapFailed);
+    double tlsfTime = run<vsg::MemorySlots>(operations, blockSize, numRounds, tlsfFailed);
+
+    std::cout << numRounds << " rounds of " << numOperations << " reserve/release operations in a " << blockSize << " byte block" << std::endl;
+    std::cout << "    map based MemorySlots  : " << mapTime << "s, " << mapFailed << " failed reserves" << std::endl;
+    std::cout << "    vsg::MemorySlots       : " << tlsfTime << "s, " << tlsfFailed << " failed reserves" << std::endl;
+    std::cout << "    speed up " << (mapTime / tlsfTime) << "x" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <thread>
+#include <vector>
+
+// std::list and mutex based queue as used by ThreadSafeQueue before the lock-free ring buffer, kept for comparison
+template<class T>
+class ListQueue : public vsg::Inherit<vsg::Object, ListQueue<T>>
+{
+public:
+    using value_type = T;
+
+    explicit ListQueue(vsg::ref_ptr<vsg::ActivityStatus> status) :
+        _status(status) {}
+
+    void add(value_type operation)
+    {
+        std::scoped_lock lock(_mutex);
+        _queue.emplace_back(operation);
+        _cv.notify_one();
+    }
+
+    value_type take_when_available()
+    {
+        std::chrono::duration waitDuration = std::chrono::milliseconds(100);
+
+        std::unique_lock lock(_mutex);
+        while (_queue.empty() && _status->active())
+        {
+            _cv.wait_for(lock, waitDuration);
+        }
+
+        if (_status->cancel()) return {};
+
+        auto operation = _queue.front();
+        _queue.erase(_queue.begin());
+        return operation;
+    }
+
+    void wake_waiting() {}
+
+protected:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::list<value_type> _queue;
+    vsg::ref_ptr<vsg::ActivityStatus> _status;
+};
+
+struct CountOperation : public vsg::Inherit<vsg::Operation, CountOperation>
+{
+    uint64_t count = 0;
+
+    void run() override { ++count; }
+};
+
+// numThreads producers each add numOperations operations while numThreads consumers take and run them, return the time taken for all operations to be run.
+template<class Queue>
+double run(uint32_t numThreads, uint32_t numOperations)
+{
+    auto status = vsg::ActivityStatus::create();
+    auto queue = Queue::create(status);
+
+    std::atomic_uint64_t numRun = 0;
+    uint64_t total = uint64_t(numThreads) * numOperations;
+
+    // create the operations up front so their allocation isn't timed
+    std::vector<std::vector<vsg::ref_ptr<vsg::Operation>>> operations(numThreads);
+    for (auto& producerOperations : operations)
+    {
+        for (uint32_t i = 0; i < numOperations; ++i) producerOperations.push_back(CountOperation::create());
+    }
+
+    std::atomic_uint32_t numReady = 0;
+    std::atomic_bool go = false;
+    std::chrono::steady_clock::time_point end;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            ++numReady;
+            while (!go) std::this_thread::yield();
+            for (auto& operation : operations[t]) queue->add(operation);
+        });
+
+        threads.emplace_back([&]() {
+            ++numReady;
+            while (!go) std::this_thread::yield();
+            while (auto operation = queue->take_when_available())
+            {
+                operation->run();
+                if (numRun.fetch_add(1) + 1 == total)
+                {
+                    end = std::chrono::steady_clock::now();
+                    status->set(false);
+                    queue->wake_waiting();
+                }
+            }
+        });
+    }
+
+    while (numReady < threads.size()) std::this_thread::yield();
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+
+    for (auto& thread : threads) thread.join();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    vsg::CommandLine arguments(&argc, argv);
+    auto numOperations = arguments.value<uint32_t>(100000, "--operations");
+    auto maxThreads = arguments.value<uint32_t>(64, "--max-threads");
+    if (arguments.errors()) return arguments.writeErrorMessages(std::cerr);
+
+    std::cout << "producer/consumer threads, list queue operations/s, ThreadSafeQueue operations/s, speed up" << std::endl;
+    for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        double total = double(numThreads) * numOperations;
+        double listTime = run<ListQueue<vsg::ref_ptr<vsg::Operation>>>(numThreads, numOperations);
+        double queueTime = run<vsg::OperationQueue>(numThreads, numOperations);
+        std::cout << numThreads << ", " << (total / listTime) << ", " << (total / queueTime) << ", " << (listTime / queueTime) << std::endl;
+    }
+
+    return 0;
+}
@@ -57,10 +57,12 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 // Node header files
 #include <vsg/nodes/AbsoluteTransform.h>
+#include <vsg/nodes/BatchCullGroup.h>
 #include <vsg/nodes/Bin.h>
 #include <vsg/nodes/Compilable.h>
 #include <vsg/nodes/CullGroup.h>
 #include <vsg/nodes/CullNode.h>
+#include <vsg/nodes/CulledInstanceDraw.h>
 #include <vsg/nodes/DepthSorted.h>
 #include <vsg/nodes/Geometry.h>
 #include <vsg/nodes/Group.h>
@@ -157,6 +159,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/threading/Latch.h>
 #include <vsg/threading/OperationQueue.h>
 #include <vsg/threading/OperationThreads.h>
+#include <vsg/threading/TaskGroup.h>
 #include <vsg/threading/atomics.h>
 
 // User Interface abstraction header files
@@ -230,16 +233,20 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/io/AsciiOutput.h>
 #include <vsg/io/BinaryInput.h>
 #include <vsg/io/BinaryOutput.h>
+#include <vsg/io/CompressionCodec.h>
 #include <vsg/io/DatabasePager.h>
+#include <vsg/io/DirectoryCache.h>
 #include <vsg/io/FileSystem.h>
 #include <vsg/io/Input.h>
 #include <vsg/io/Logger.h>
+#include <vsg/io/MappedFile.h>
 #include <vsg/io/ObjectFactory.h>
 #include <vsg/io/Options.h>
 #include <vsg/io/Output.h>
 #include <vsg/io/Path.h>
 #include <vsg/io/ReaderWriter.h>
 #include <vsg/io/VSG.h>
+#include <vsg/io/compressed_stream.h>
 #include <vsg/io/convert_utf.h>
 #include <vsg/io/glsl.h>
 #include <vsg/io/mem_stream.h>
@@ -260,9 +267,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/utils/Intersector.h>
 #include <vsg/utils/LineSegmentIntersector.h>
 #include <vsg/utils/LoadPagedLOD.h>
+#include <vsg/utils/MultiLineSegmentIntersector.h>
+#include <vsg/utils/PolytopeIntersector.h>
 #include <vsg/utils/ShaderCompiler.h>
 #include <vsg/utils/ShaderSet.h>
 #include <vsg/utils/SharedObjects.h>
+#include <vsg/utils/SphereIntersector.h>
+#include <vsg/utils/TriangleBVH.h>
 
 // Text header files
 #include <vsg/text/CpuLayoutTechnique.h>
@@ -17,6 +17,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/core/Export.h>
 #include <vsg/nodes/Bin.h>
 #include <vsg/nodes/Group.h>
+#include <vsg/threading/OperationThreads.h>
 #include <vsg/vk/CommandBuffer.h>
 
 namespace vsg
@@ -42,6 +43,12 @@ namespace vsg
 
         ref_ptr<RecordTraversal> recordTraversal;
 
+        /// FrameArena for transient data used while recording, assigned by RecordAndSubmitTask and passed on to the RecordTraversal
+        FrameArena* frameArena = nullptr;
+
+        /// when assigned, Views within RenderGraphs have their top level children recorded in parallel on the recordThreads to secondary command buffers.
+        ref_ptr<OperationThreads> recordThreads;
+
         virtual VkCommandBufferLevel level() const;
         virtual void reset();
         virtual void record(CommandBuffers& recordedCommandBuffers, ref_ptr<FrameStamp> frameStamp = {}, ref_ptr<DatabasePager> databasePager = {});
@@ -15,6 +15,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/app/CommandGraph.h>
 #include <vsg/app/TransferTask.h>
 #include <vsg/app/Window.h>
+#include <vsg/core/Allocator.h>
 #include <vsg/io/DatabasePager.h>
 #include <vsg/nodes/Group.h>
 #include <vsg/vk/CommandBuffer.h>
@@ -55,6 +56,9 @@ namespace vsg
 
         ref_ptr<DatabasePager> databasePager;
 
+        /// FrameArena for transient data used while recording and submitting a frame, reset by start()
+        FrameArena frameArena;
+
     protected:
         size_t _currentFrameIndex;
         std::vector<size_t> _indices;
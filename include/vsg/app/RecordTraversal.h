@@ -12,11 +12,14 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/core/Allocator.h>
 #include <vsg/core/Mask.h>
 #include <vsg/core/Object.h>
 #include <vsg/core/type_name.h>
 #include <vsg/maths/mat4.h>
+#include <vsg/vk/vulkan.h>
 
+#include <map>
 #include <set>
 #include <vector>
 
@@ -36,6 +39,7 @@ namespace vsg
     class Transform;
     class MatrixTransform;
     class Command;
+    class NextSubPass;
     class Commands;
     class CommandBuffer;
     class State;
@@ -51,6 +55,7 @@ namespace vsg
     class DirectionalLight;
     class PointLight;
     class SpotLight;
+    class OperationThreads;
 
     VSG_type_name(vsg::RecordTraversal);
 
@@ -75,6 +80,20 @@ namespace vsg
         Mask traversalMask = MASK_ALL;
         Mask overrideMask = MASK_OFF;
 
+        /// when assigned, Views within a RenderGraph are recorded to secondary command buffers, with the View's top level children partitioned across the recordThreads.
+        /// Only RenderGraphs whose children are all Views or NextSubPass are recorded this way, others are recorded inline.
+        ref_ptr<OperationThreads> recordThreads;
+
+        /// Views with fewer top level children than minimumChildrenForParallelRecord are recorded to a single secondary command buffer on the calling thread.
+        uint32_t minimumChildrenForParallelRecord = 2;
+
+        /// secondary command buffers recorded for Views, CommandGraph passes them on with the primary command buffer so they are retained until the submission has completed.
+        std::vector<ref_ptr<CommandBuffer>> secondaryCommandBuffers;
+
+        /// set by RenderGraph when recording its Views to secondary command buffers, a renderPass of VK_NULL_HANDLE disables recording of Views to secondary command buffers.
+        /// The subpass is advanced by each NextSubPass.
+        void setRenderPassInheritance(VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer);
+
         /// get the current State object used to track state and projection/modelview matrices for the current subgraph being traversed
         State* getState() { return _state; }
 
@@ -90,6 +109,10 @@ namespace vsg
         void setDatabasePager(DatabasePager* dp);
         DatabasePager* getDatabasePager() { return _databasePager; }
 
+        /// set the FrameArena used for transient data that is only required during the traversal of a frame, assigned by CommandGraph
+        void setFrameArena(FrameArena* frameArena) { _frameArena = frameArena; }
+        FrameArena* getFrameArena() { return _frameArena; }
+
         void setProjectionAndViewMatrix(const dmat4& projMatrix, const dmat4& viewMatrix);
 
         void apply(const Object& object);
@@ -117,6 +140,7 @@ namespace vsg
         void apply(const StateGroup& object);
         void apply(const Commands& commands);
         void apply(const Command& command);
+        void apply(const NextSubPass& nextSubPass);
 
         // Viewer level nodes
         void apply(const View& view);
@@ -129,14 +153,44 @@ namespace vsg
 
         FrameStamp* _frameStamp = nullptr;
         State* _state = nullptr;
+        FrameArena* _frameArena = nullptr;
 
         // used to handle loading of PagedLOD external children.
         DatabasePager* _databasePager = nullptr;
         CulledPagedLODs* _culledPagedLODs = nullptr;
 
         int32_t _minimumBinNumber = 0;
-        std::vector<ref_ptr<Bin>> _bins;
+        using Bins = std::vector<ref_ptr<Bin>, allocator_frame_arena<ref_ptr<Bin>>>;
+        Bins _bins;
         ref_ptr<ViewDependentState> _viewDependentState;
+
+        // camera motion of each view, used to predict the view for DatabasePager prefetching
+        struct ViewMotion
+        {
+            dvec3 translation;
+            dquat rotation;
+            dvec3 scale;
+            dvec3 velocity;        // smoothed, world units per second
+            dvec3 angularVelocity; // smoothed, rotation axis scaled by radians per second
+            double time = 0.0;
+            uint64_t frameCount = 0;
+            uint32_t numFrames = 0;
+        };
+        std::map<uint32_t, ViewMotion> _viewMotions;
+
+        void traversePagedLOD(const PagedLOD& plod);
+
+        dmat4 predictViewMatrix(const dmat4& viewMatrix);
+        void requestPrefetch(const PagedLOD& plod);
+
+        // render pass that the secondary command buffers recorded for Views continue
+        VkCommandBufferInheritanceInfo _inheritanceInfo;
+
+        // RecordTraversal, command buffers, bins and collected lights/PagedLODs for recording one partition of a View's children
+        struct SubgraphRecord;
+        std::vector<ref_ptr<SubgraphRecord>> _subgraphRecords;
+
+        void recordSecondaryCommandBuffers(const View& view);
     };
 
 } // namespace vsg
@@ -14,8 +14,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <vsg/core/MemorySlots.h>
 
+#include <atomic>
+#include <cstddef>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <type_traits>
 #include <vector>
 
 namespace vsg
@@ -36,6 +41,55 @@ namespace vsg
         ALLOCATOR_AFFINITY_LAST = ALLOCATOR_AFFINITY_NODES + 1
     };
 
+    /** bump pointer allocator for transient data that is only required for the duration of a single frame.
+      * Deallocation is a no-op, instead all allocations are released in bulk by reset(), so memory allocated from a FrameArena must not be used beyond the frame it was allocated in.
+      * Each user, such as RecordAndSubmitTask, has its own FrameArena that it resets at the start of each of its frames.
+      * allocate() is thread safe so may be used from multiple record threads, reset() must only be called when no other threads are using the FrameArena.*/
+    class VSG_DECLSPEC FrameArena
+    {
+    public:
+        explicit FrameArena(size_t in_blockSize = 1024 * 1024);
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+        ~FrameArena();
+
+        /// allocate memory that remains valid until the next reset(), return nullptr if the memory can't be allocated.
+        void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+        /// release all allocations, if more than one block was required during the last frame they are replaced by a single block large enough to hold them all.
+        void reset();
+
+        /// return the total size of allocations since the last reset()
+        size_t totalAllocatedSize() const;
+
+        /// return the total memory size of the blocks held by the FrameArena
+        size_t totalMemorySize() const;
+
+        /// report stats about the FrameArena usage
+        void report(std::ostream& out) const;
+
+        /// minimum size of blocks allocated by the FrameArena
+        size_t blockSize;
+
+        /// number of allocations and largest total allocated size during a frame since the FrameArena was created
+        std::atomic_uint64_t allocationCount = 0;
+        size_t peakAllocatedSize = 0;
+
+    protected:
+        struct Block
+        {
+            uint8_t* memory = nullptr;
+            size_t size = 0;
+            std::atomic_size_t used = 0;
+        };
+
+        Block* createBlock(size_t size);
+
+        mutable std::mutex _mutex;
+        std::vector<Block*> _blocks;
+        std::atomic<Block*> _currentBlock = nullptr;
+    };
+
     /** extensible Allocator that handles allocation and deallocation of scene graph CPU memory,*/
     class VSG_DECLSPEC Allocator
     {
@@ -51,7 +105,11 @@ namespace vsg
         virtual void* allocate(std::size_t size, AllocatorAffinity allocatorAffinity = ALLOCATOR_AFFINITY_OBJECTS);
 
         /// deallocate, returning data to pool.
-        virtual bool deallocate(void* ptr, std::size_t size);
+        /// If the size and allocatorAffinity of the original allocation are known the memory may be retained in the calling thread's cache for reuse by subsequent allocations of the same size.
+        virtual bool deallocate(void* ptr, std::size_t size, AllocatorAffinity allocatorAffinity = ALLOCATOR_AFFINITY_LAST);
+
+        /// return memory held in all the thread caches back to the MemoryBlocks
+        virtual void flushThreadCaches();
 
         /// delete any MemoryBlock that are empty
         virtual size_t deleteEmptyMemoryBlocks();
@@ -72,6 +130,12 @@ namespace vsg
         AllocatorType memoryBlocksAllocatorType = ALLOCATOR_TYPE_NEW_DELETE; // Use new/delete within MemoryBlocks by default
         int memoryTracking = MEMORY_TRACKING_DEFAULT;
 
+        /// use per thread caches of recently deallocated memory so that most allocations/deallocations of small objects don't need to lock the Allocator::mutex
+        bool useThreadCaches = true;
+        size_t threadCacheMaxAllocationSize = 256; // allocations larger than this are always passed to the MemoryBlocks
+        size_t threadCacheMaxSlots = 32;           // maximum number of slots cached per size class, beyond which half are returned to the MemoryBlocks in a batch
+        size_t threadCacheRefillCount = 8;         // number of slots to reserve from the MemoryBlocks in a batch when a thread cache is empty
+
         /// set the MemoryTracking member of the vsg::Allocator and all the MemoryBlocks that it manages.
         void setMemoryTracking(int mt);
 
@@ -119,18 +183,53 @@ namespace vsg
         double allocationTime = 0.0;
         double deallocationTime = 0.0;
 
+        /// statistics collected to help assess the effectiveness of the thread caches
+        std::atomic_uint64_t mutexLockCount = 0;
+        std::atomic_uint64_t mutexContentionCount = 0;
+
+        struct ThreadCacheStats
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t refills = 0;
+            uint64_t flushes = 0;
+            size_t cachedSize = 0;
+
+            ThreadCacheStats& operator+=(const ThreadCacheStats& rhs);
+        };
+
+        /// return the combined statistics of all current thread caches and the threads that have already exited
+        ThreadCacheStats threadCacheStats() const;
+
+        struct ThreadCache;
+
     protected:
         // if you are assigning a custom allocator you must retain the old allocator to manage the memory it allocated and needs to delete
         std::unique_ptr<Allocator> nestedAllocator;
 
         std::vector<std::unique_ptr<MemoryBlocks>> allocatorMemoryBlocks;
+
+        std::vector<ThreadCache*> threadCaches;
+        ThreadCacheStats exitedThreadCacheStats;
+
+        /// lock the mutex, recording whether another thread already held it
+        std::unique_lock<std::mutex> lockMutex();
+
+        // implementation of allocate/deallocate, the mutex must be locked by the caller
+        void* _allocate(std::size_t size, AllocatorAffinity allocatorAffinity);
+        bool _deallocate(void* ptr, std::size_t size);
+
+        ThreadCache* getThreadCache();
+        void flushThreadCache(ThreadCache& threadCache);
+
+        friend struct ThreadCache;
     };
 
     /// allocate memory using vsg::Allocator::instance() if available, otherwise use std::malloc(size)
     extern VSG_DECLSPEC void* allocate(std::size_t size, AllocatorAffinity allocatorAffinity = ALLOCATOR_AFFINITY_OBJECTS);
 
     /// deallocate memory using vsg::Allocator::instance() if available, otherwise use std::free(ptr)
-    extern VSG_DECLSPEC void deallocate(void* ptr, std::size_t size = 0);
+    extern VSG_DECLSPEC void deallocate(void* ptr, std::size_t size = 0, AllocatorAffinity allocatorAffinity = ALLOCATOR_AFFINITY_LAST);
 
     /// std container adapter for allocating with MEMORY_AFFINITY_NODES
     template<typename T>
@@ -149,7 +248,7 @@ namespace vsg
 
         void deallocate(value_type* ptr, std::size_t n)
         {
-            vsg::deallocate(ptr, n * sizeof(value_type));
+            vsg::deallocate(ptr, n * sizeof(value_type), vsg::ALLOCATOR_AFFINITY_NODES);
         }
     };
 
@@ -159,4 +258,49 @@ namespace vsg
     template<class T, class U>
     bool operator!=(const allocator_affinity_nodes<T>&, const allocator_affinity_nodes<U>&) { return false; }
 
+    /// std container adapter for allocating from a FrameArena, containers using it must not be used beyond the frame they are filled in.
+    /// When no FrameArena is assigned allocations are passed to operator new/delete.
+    template<typename T>
+    struct allocator_frame_arena
+    {
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        allocator_frame_arena() noexcept = default;
+
+        explicit allocator_frame_arena(FrameArena* in_frameArena) noexcept :
+            frameArena(in_frameArena) {}
+
+        explicit allocator_frame_arena(FrameArena& in_frameArena) noexcept :
+            frameArena(&in_frameArena) {}
+
+        template<class U>
+        explicit constexpr allocator_frame_arena(const allocator_frame_arena<U>& rhs) noexcept :
+            frameArena(rhs.frameArena) {}
+
+        value_type* allocate(std::size_t n)
+        {
+            if (!frameArena) return static_cast<value_type*>(::operator new(n * sizeof(value_type)));
+
+            auto ptr = frameArena->allocate(n * sizeof(value_type), alignof(value_type));
+            if (!ptr) throw std::bad_alloc();
+            return static_cast<value_type*>(ptr);
+        }
+
+        void deallocate(value_type* ptr, std::size_t)
+        {
+            // memory is released in bulk by FrameArena::reset()
+            if (!frameArena) ::operator delete(ptr);
+        }
+
+        FrameArena* frameArena = nullptr;
+    };
+
+    template<class T, class U>
+    bool operator==(const allocator_frame_arena<T>& lhs, const allocator_frame_arena<U>& rhs) { return lhs.frameArena == rhs.frameArena; }
+
+    template<class T, class U>
+    bool operator!=(const allocator_frame_arena<T>& lhs, const allocator_frame_arena<U>& rhs) { return lhs.frameArena != rhs.frameArena; }
+
 } // namespace vsg
@@ -43,7 +43,7 @@ namespace vsg
             _size(0) {}
 
         Array(const Array& rhs) :
-            Data(rhs.properties, sizeof(value_type)),
+            Data(_copyProperties(rhs.properties), sizeof(value_type)),
             _data(nullptr),
             _size(rhs._size)
         {
@@ -156,7 +156,24 @@ namespace vsg
             {
                 size_t new_total_size = computeValueCountIncludingMipmaps(width_size, 1, 1, properties.maxNumMipmaps);
 
-                if (_data) // if data exists already may be able to reuse it
+                input.alignArray();
+
+                ref_ptr<Object> owner;
+                auto mapped = input.mapArray(new_total_size * sizeof(value_type), alignof(value_type), owner);
+                if (mapped) // reference the values in place, the memory is owned elsewhere so must not be deleted
+                {
+                    _delete();
+                    properties.allocatorType = ALLOCATOR_TYPE_NO_DELETE;
+                    _data = static_cast<value_type*>(const_cast<void*>(mapped));
+                    _dataOwner = owner;
+                }
+                else if (properties.allocatorType == ALLOCATOR_TYPE_NO_DELETE) // existing values are owned elsewhere so allocate new ones
+                {
+                    _delete();
+                    properties.allocatorType = ALLOCATOR_TYPE_VSG_ALLOCATOR;
+                    _data = _allocate(new_total_size);
+                }
+                else if (_data) // if data exists already may be able to reuse it
                 {
                     if (original_total_size != new_total_size) // if existing data is a different size delete old, and create new
                     {
@@ -174,7 +191,7 @@ namespace vsg
                 _size = width_size;
                 _storage = nullptr;
 
-                if (_data) input.read(new_total_size, _data);
+                if (_data && !mapped) input.read(new_total_size, _data);
 
                 dirty();
             }
@@ -194,6 +211,7 @@ namespace vsg
             }
 
             output.writePropertyName("data");
+            output.alignArray();
             output.write(size(), _data);
             output.writeEndOfLine();
         }
@@ -218,7 +236,7 @@ namespace vsg
 
             clear();
 
-            properties = rhs.properties;
+            properties = _copyProperties(rhs.properties);
             _size = rhs._size;
 
             if (_size != 0)
@@ -354,6 +372,8 @@ namespace vsg
                 else if (properties.allocatorType != 0)
                     vsg::deallocate(_data);
             }
+
+            _dataOwner = nullptr;
         }
 
     private:
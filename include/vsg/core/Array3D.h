@@ -44,7 +44,7 @@ namespace vsg
             _depth(0) {}
 
         Array3D(const Array3D& rhs) :
-            Data(rhs.properties, sizeof(value_type)),
+            Data(_copyProperties(rhs.properties), sizeof(value_type)),
             _data(nullptr),
             _width(rhs._width),
             _height(rhs._height),
@@ -138,7 +138,24 @@ namespace vsg
             {
                 size_t new_size = computeValueCountIncludingMipmaps(w, h, d, properties.maxNumMipmaps);
 
-                if (_data) // if data exists already may be able to reuse it
+                input.alignArray();
+
+                ref_ptr<Object> owner;
+                auto mapped = input.mapArray(new_size * sizeof(value_type), alignof(value_type), owner);
+                if (mapped) // reference the values in place, the memory is owned elsewhere so must not be deleted
+                {
+                    _delete();
+                    properties.allocatorType = ALLOCATOR_TYPE_NO_DELETE;
+                    _data = static_cast<value_type*>(const_cast<void*>(mapped));
+                    _dataOwner = owner;
+                }
+                else if (properties.allocatorType == ALLOCATOR_TYPE_NO_DELETE) // existing values are owned elsewhere so allocate new ones
+                {
+                    _delete();
+                    properties.allocatorType = ALLOCATOR_TYPE_VSG_ALLOCATOR;
+                    _data = _allocate(new_size);
+                }
+                else if (_data) // if data exists already may be able to reuse it
                 {
                     if (original_size != new_size) // if existing data is a different size delete old, and create new
                     {
@@ -157,7 +174,7 @@ namespace vsg
                 _depth = d;
                 _storage = nullptr;
 
-                if (_data) input.read(new_size, _data);
+                if (_data && !mapped) input.read(new_size, _data);
 
                 dirty();
             }
@@ -180,6 +197,7 @@ namespace vsg
             }
 
             output.writePropertyName("data");
+            output.alignArray();
             output.write(valueCount(), _data);
             output.writeEndOfLine();
         }
@@ -206,7 +224,7 @@ namespace vsg
 
             clear();
 
-            properties = rhs.properties;
+            properties = _copyProperties(rhs.properties);
             _width = rhs._width;
             _height = rhs._height;
             _depth = rhs._depth;
@@ -361,6 +379,8 @@ namespace vsg
                 else if (properties.allocatorType != 0)
                     vsg::deallocate(_data);
             }
+
+            _dataOwner = nullptr;
         }
 
     private:
@@ -78,6 +78,7 @@ namespace vsg
     class RayTracingPipeline;
     class Draw;
     class DrawIndexed;
+    class DrawIndexedIndirect;
     class ShaderStage;
     class GraphicsPipelineState;
     class VertexInputState;
@@ -342,6 +343,7 @@ namespace vsg
         virtual void apply(const ResourceHints&);
         virtual void apply(const Draw&);
         virtual void apply(const DrawIndexed&);
+        virtual void apply(const DrawIndexedIndirect&);
         virtual void apply(const ClearAttachments&);
         virtual void apply(const ClearColorImage&);
         virtual void apply(const ClearDepthStencilImage&);
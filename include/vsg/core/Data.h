@@ -147,7 +147,7 @@ namespace vsg
 
         /// provide new and delete to enable custom memory management via the vsg::Allocator singleton, using the MEMORY_AFFINTY_DATA
         static void* operator new(size_t count);
-        static void operator delete(void* ptr);
+        static void operator delete(void* ptr, std::size_t size);
 
         size_t sizeofObject() const noexcept override { return sizeof(Data); }
         bool is_compatible(const std::type_info& type) const noexcept override { return typeid(Data) == type || Object::is_compatible(type); }
@@ -213,8 +213,20 @@ namespace vsg
     protected:
         virtual ~Data() {}
 
+        /// properties for copies of data, copies allocate their own values so mustn't inherit ALLOCATOR_TYPE_NO_DELETE from data referencing memory owned elsewhere
+        static Properties _copyProperties(const Properties& rhs)
+        {
+            Properties copy;
+            copy = rhs;
+            if (copy.allocatorType == ALLOCATOR_TYPE_NO_DELETE) copy.allocatorType = ALLOCATOR_TYPE_VSG_ALLOCATOR;
+            return copy;
+        }
+
         ModifiedCount _modifiedCount;
 
+        /// object owning the memory referenced by ALLOCATOR_TYPE_NO_DELETE values, such as the MappedFile of memory mapped .vsgb files, not serialized.
+        ref_ptr<Object> _dataOwner;
+
 #if 1
     public:
         /// deprecated: provided for backwards compatibility, use Properties instead.
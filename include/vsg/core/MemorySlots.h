@@ -14,6 +14,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <vsg/core/Export.h>
 
+#include <cstdint>
 #include <list>
 #include <map>
 #include <ostream>
@@ -31,7 +32,9 @@ namespace vsg
         MEMORY_TRACKING_DEFAULT = MEMORY_TRACKING_NO_CHECKS
     };
 
-    /** class used internally by vsg::Allocator, vsg::DeviceMemory and vsg::Buffer to manage suballocation within a block of CPU or GPU memory.*/
+    /** class used internally by vsg::Allocator, vsg::DeviceMemory and vsg::Buffer to manage suballocation within a block of CPU or GPU memory.
+      * Uses a two level segregated fit scheme (TLSF) so that reserve() and release() are constant time and don't allocate memory on the heap once the internal containers have grown to the required size.
+      * Book keeping is held separately from the managed memory so it may be used for GPU memory that isn't CPU accessible.*/
     class VSG_DECLSPEC MemorySlots
     {
     public:
@@ -43,12 +46,12 @@ namespace vsg
 
         bool release(size_t offset, size_t size);
 
-        bool full() const { return _availableMemory.empty(); }
-        bool empty() const { return totalAvailableSize() == totalMemorySize(); }
+        bool full() const { return _firstLevelBitmap == 0; }
+        bool empty() const { return _totalAvailableSize == _totalMemorySize; }
 
-        size_t maximumAvailableSpace() const { return _availableMemory.empty() ? 0 : _availableMemory.rbegin()->first; }
-        size_t totalAvailableSize() const;
-        size_t totalReservedSize() const;
+        size_t maximumAvailableSpace() const;
+        size_t totalAvailableSize() const { return _totalAvailableSize; }
+        size_t totalReservedSize() const { return _totalReservedSize; }
         size_t totalMemorySize() const { return _totalMemorySize; }
 
         // debug facilities
@@ -58,14 +61,51 @@ namespace vsg
         mutable int memoryTracking = MEMORY_TRACKING_DEFAULT;
 
     protected:
-        std::multimap<size_t, size_t> _availableMemory;
-        std::map<size_t, size_t> _offsetSizes;
-        std::map<size_t, size_t> _reservedMemory;
-
-        void insertAvailableSlot(size_t offset, size_t size);
-        void removeAvailableSlot(size_t offset, size_t size);
+        static constexpr uint32_t npos = ~0u;
+        static constexpr uint32_t secondLevelCountLog2 = 4;
+        static constexpr uint32_t secondLevelCount = 1 << secondLevelCountLog2;
+
+        /// contiguous range of memory, either available or reserved, linked to its physical neighbours and when available to other slots of the same size class.
+        struct Slot
+        {
+            size_t offset = 0;
+            size_t size = 0;
+            uint32_t previous = npos;
+            uint32_t next = npos;
+            uint32_t previousAvailable = npos;
+            uint32_t nextAvailable = npos;
+            bool available = false;
+        };
+
+        std::vector<Slot> _slots;
+        uint32_t _firstSlot = npos;
+        uint32_t _unusedSlots = npos;
+
+        // two level bitmaps of which size classes have available slots, with the heads of each size class's list of available slots
+        uint64_t _firstLevelBitmap = 0;
+        std::vector<uint32_t> _secondLevelBitmaps;
+        std::vector<uint32_t> _availableHeads;
+
+        // open addressing hash map from offset to index of reserved Slot
+        std::vector<std::pair<size_t, uint32_t>> _reservedSlots;
+        size_t _numReservedSlots = 0;
 
         size_t _totalMemorySize;
+        size_t _totalAvailableSize = 0;
+        size_t _totalReservedSize = 0;
+
+        static void mapping(size_t size, uint32_t& fl, uint32_t& sl);
+
+        uint32_t createSlot(size_t offset, size_t size);
+        void destroySlot(uint32_t index);
+
+        void insertAvailableSlot(uint32_t index);
+        void removeAvailableSlot(uint32_t index);
+        uint32_t findAvailableSlot(size_t size, size_t alignment, size_t& alignedStart) const;
+
+        void insertReservedSlot(size_t offset, uint32_t index);
+        uint32_t removeReservedSlot(size_t offset);
+        size_t reservedHash(size_t offset) const;
     };
 
 } // namespace vsg
@@ -58,7 +58,7 @@ namespace vsg
 
         /// provide new and delete to enable custom memory management via the vsg::Allocator singleton, using the MEMORY_AFFINTY_OBJECTS
         static void* operator new(std::size_t count);
-        static void operator delete(void* ptr);
+        static void operator delete(void* ptr, std::size_t size);
 
         virtual std::size_t sizeofObject() const noexcept { return sizeof(Object); }
         virtual const char* className() const noexcept { return type_name<Object>(); }
@@ -78,6 +78,7 @@ namespace vsg
     class RayTracingPipeline;
     class Draw;
     class DrawIndexed;
+    class DrawIndexedIndirect;
     class ShaderStage;
     class GraphicsPipelineState;
     class VertexInputState;
@@ -342,6 +343,7 @@ namespace vsg
         virtual void apply(ResourceHints&);
         virtual void apply(Draw&);
         virtual void apply(DrawIndexed&);
+        virtual void apply(DrawIndexedIndirect&);
         virtual void apply(ClearAttachments&);
         virtual void apply(ClearColorImage&);
         virtual void apply(ClearDepthStencilImage&);
@@ -15,9 +15,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/core/Object.h>
 
 #include <vsg/io/Input.h>
+#include <vsg/io/MappedFile.h>
 #include <vsg/io/Options.h>
 
 #include <fstream>
+#include <unordered_map>
 
 namespace vsg
 {
@@ -35,6 +37,7 @@ namespace vsg
         {
             ObjectID id;
             _input.read(reinterpret_cast<char*>(&id), sizeof(uint32_t));
+            _position += sizeof(uint32_t);
             return id;
         }
 
@@ -42,6 +45,7 @@ namespace vsg
         void _read(size_t num, T* value)
         {
             _input.read(reinterpret_cast<char*>(value), num * sizeof(T));
+            _position += num * sizeof(T);
         }
 
         // read value(s)
@@ -74,8 +78,56 @@ namespace vsg
         /// read object
         vsg::ref_ptr<vsg::Object> read() override;
 
+        /// skip the padding written in front of array values when alignment is set
+        void alignArray() override;
+
+        /// return a pointer to the array values within the mappedFile when they are suitably aligned, assigning the mappedFile to owner
+        const void* mapArray(size_t size, size_t valueAlignment, ref_ptr<Object>& owner) override;
+
+        /// alignment of array values in bytes, relative to the start of the input stream, as declared in the .vsgb header. 0 when array values are not padded.
+        uint32_t alignment = 0;
+
+        /// file that the input stream is reading from, and the offset of the start of the input stream within it, when set array values are referenced in place rather than copied.
+        ref_ptr<MappedFile> mappedFile;
+        size_t mappedOffset = 0;
+
+        struct PrereadObject
+        {
+            ObjectIDMap objectIDMap;
+            size_t end = 0;
+        };
+
+        /// objects read ahead of the sequential read, such as by the parallel reading of indexed .vsgb files, along with the objects read within them.
+        /// When read() reaches one of the ObjectIDs its objects are added to the objectIDMap and the input stream skips to the end position.
+        std::map<ObjectID, PrereadObject> prereadObjects;
+
+        /// when true objects refer to their class by ID, with the class name only read for the first object of each class, as declared in the .vsgb header.
+        bool classIDs = false;
+
+        /// assign the class name for a class ID, looking up the function for creating instances of it.
+        void assignClass(uint32_t classID, const std::string& className);
+
+        /// move to a position relative to the start of the input stream, the input stream must support seeking.
+        void setPosition(size_t position);
+        size_t getPosition() const { return _position; }
+
     protected:
         std::istream& _input;
+        size_t _position = 0;
+
+        struct ClassEntry
+        {
+            std::string name;
+            ObjectFactory::CreateFunction create;
+        };
+
+        std::vector<ClassEntry> _classes;
+        std::string _className;
+
+        // create functions of the classes named by the legacy per object class names, so that each name is only looked up in the ObjectFactory once
+        std::unordered_map<std::string, ObjectFactory::CreateFunction> _createFunctions;
+
+        ref_ptr<Object> _create(const std::string& className, const ObjectFactory::CreateFunction& create);
     };
 
 } // namespace vsg
@@ -16,6 +16,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/io/Output.h>
 
 #include <fstream>
+#include <string_view>
+#include <unordered_map>
 
 namespace vsg
 {
@@ -37,6 +39,7 @@ namespace vsg
         void _write(size_t num, const T* value)
         {
             _output.write(reinterpret_cast<const char*>(value), num * sizeof(T));
+            _position += num * sizeof(T);
         }
 
         // write contiguous array of value(s)
@@ -61,8 +64,52 @@ namespace vsg
         /// write object
         void write(const vsg::Object* object) override;
 
+        /// write padding in front of array values when alignment is set
+        void alignArray() override;
+
+        /// alignment of array values in bytes, relative to the start of the output stream, 0 for no padding.
+        /// The header written in front of the output stream must declare the alignment and be padded to a multiple of it, see VSG::writeHeader(..).
+        uint32_t alignment = 0;
+
+        /// when greater than 0 the positions of self contained objects of at least indexThreshold bytes are recorded so that they can be read in parallel, see writeIndex().
+        /// Self contained objects don't reference objects written before them, only the innermost ones are recorded and the root object is never recorded.
+        size_t indexThreshold = 0;
+
+        struct IndexEntry
+        {
+            uint64_t id = 0;
+            uint64_t begin = 0;
+            uint64_t end = 0;
+        };
+
+        std::vector<IndexEntry> index;
+
+        /// write the recorded index entries, and the class names when classIDs is set, followed by the position of the index, called after the root object has been written.
+        void writeIndex();
+
+        /// when true the class name is only written with the first object of each class, later objects write the class ID assigned to it.
+        /// The header written in front of the output stream must declare class IDs, see VSG::writeHeader(..).
+        bool classIDs = false;
+
     protected:
         std::ostream& _output;
+        size_t _position = 0;
+
+        struct IndexFrame
+        {
+            ObjectID id = 0;
+            size_t begin = 0;
+            ObjectID minReference = 0;
+            bool containsEntry = false;
+        };
+
+        std::vector<IndexFrame> _indexFrames;
+
+        void _writeClass(const char* className);
+
+        // className() returns string literals so views of them remain valid
+        std::unordered_map<std::string_view, uint32_t> _classIDMap;
+        std::vector<std::string_view> _classNames;
     };
 
 } // namespace vsg
@@ -0,0 +1,67 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Inherit.h>
+
+#include <string>
+
+namespace vsg
+{
+
+    /// CompressionCodec is the base class for the codecs used to compress the blocks of compressed .vsgb files, see compressed_ostream and compressed_istream.
+    /// Codecs are looked up by the name recorded in the .vsgb header, so custom codecs must be registered with CompressionCodec::add(..) before they are read or written.
+    class VSG_DECLSPEC CompressionCodec : public Inherit<Object, CompressionCodec>
+    {
+    public:
+        explicit CompressionCodec(const std::string& in_name);
+
+        /// name recorded in the .vsgb header
+        const std::string name;
+
+        /// maximum size of the compressed data for size bytes of input
+        virtual size_t compressBound(size_t size) const = 0;
+
+        /// compress srcSize bytes from src into dst, returning the compressed size or 0 if it doesn't fit in dstCapacity bytes.
+        virtual size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) const = 0;
+
+        /// decompress srcSize bytes from src into exactly dstSize bytes at dst, returning false if the data is malformed.
+        virtual bool decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) const = 0;
+
+        /// register a codec, replacing any previously registered codec with the same name
+        static void add(ref_ptr<CompressionCodec> codec);
+
+        /// return the codec registered with the specified name, or null if none is registered
+        static ref_ptr<CompressionCodec> find(const std::string& name);
+
+    protected:
+        virtual ~CompressionCodec();
+    };
+    VSG_type_name(vsg::CompressionCodec);
+
+    /// LZ4Codec is the built in "lz4" codec, a fast LZ77 compressor that writes the LZ4 block format.
+    class VSG_DECLSPEC LZ4Codec : public Inherit<CompressionCodec, LZ4Codec>
+    {
+    public:
+        LZ4Codec();
+
+        size_t compressBound(size_t size) const override;
+        size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) const override;
+        bool decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) const override;
+
+    protected:
+        virtual ~LZ4Codec();
+    };
+    VSG_type_name(vsg::LZ4Codec);
+
+} // namespace vsg
@@ -20,11 +20,14 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/nodes/PagedLOD.h>
 
 #include <vsg/threading/ActivityStatus.h>
+#include <vsg/threading/OperationQueue.h>
 
 #include <vsg/app/CompileManager.h>
 
 #include <condition_variable>
+#include <functional>
 #include <list>
+#include <ostream>
 #include <thread>
 
 namespace vsg
@@ -65,16 +68,35 @@ namespace vsg
 
         void add(ref_ptr<PagedLOD> plod, const CompileResult& cr);
 
+        /// take the PagedLOD with the highest priority, waiting till one is made available if initially empty
         ref_ptr<PagedLOD> take_when_available();
 
         Nodes take_all(CompileResult& result);
 
+        /// return the number of PagedLOD in the queue
+        size_t size() const;
+
+        /// refresh the priorities of the queued PagedLOD from PagedLOD::priority and remove the PagedLOD that have not been used since the previous frame,
+        /// returning the removed PagedLOD so their requests can be discarded.
+        Nodes update(uint64_t frameCount);
+
     protected:
         virtual ~DatabaseQueue();
 
-        std::mutex _mutex;
+        /// entry in the binary max heap, the priority is a snapshot of PagedLOD::priority taken when added or updated
+        struct Entry
+        {
+            double priority;
+            ref_ptr<PagedLOD> plod;
+
+            bool operator<(const Entry& rhs) const { return priority < rhs.priority; }
+        };
+
+        void siftUp(size_t index);
+
+        mutable std::mutex _mutex;
         std::condition_variable _cv;
-        Nodes _queue;
+        std::vector<Entry> _queue;
         CompileResult _compileResult;
         ref_ptr<ActivityStatus> _status;
     };
@@ -96,10 +118,67 @@ namespace vsg
 
         virtual void updateSceneGraph(FrameStamp* frameStamp, CompileResult& cr);
 
+        /// print the queue depths and per stage statistics
+        void report(std::ostream& out) const;
+
         ref_ptr<const Options> options;
 
         ref_ptr<CompileManager> compileManager;
 
+        /// number of threads that read files into memory ahead of the read threads, 0 has the read threads read directly from file.
+        /// Files are decoded from memory using Options::extensionHint, so ReaderWriters used must support reading from memory, otherwise they fall back to reading from file.
+        uint32_t numIOThreads = 0;
+
+        /// number of threads that read/decode the subgraphs.
+        uint32_t numReadThreads = 4;
+
+        /// number of threads that compile the loaded subgraphs, 0 has the read threads compile the subgraphs they read.
+        uint32_t numCompileThreads = 2;
+
+        /// maximum number of bytes of file data read by the I/O threads that are waiting to be decoded before the I/O threads wait for the read threads to catch up.
+        size_t maxInFlightBytes = 256 * 1024 * 1024;
+
+        /// maximum number of loaded subgraphs waiting to be compiled before the read threads wait for the compile threads to catch up.
+        uint32_t maxCompileQueueSize = 16;
+
+        /// when enabled RecordTraversal extrapolates each view's camera motion prefetchTime seconds ahead and requests, at reduced priority,
+        /// the PagedLOD children that will become visible in the predicted view. Requests are discarded once the PagedLOD is no longer predicted.
+        bool prefetch = false;
+        double prefetchTime = 0.5;
+        double prefetchPriorityScale = 0.1;
+
+        /// weight given to the latest frame when smoothing the camera's linear and angular velocity, lower values average over more frames.
+        double prefetchSmoothing = 0.25;
+
+        /// maximum rotation, in radians, and translation, in world coordinates, that the predicted view may move from the current view.
+        double prefetchMaxAngle = radians(45.0);
+        double prefetchMaxDistance = 1000.0;
+
+        /// number of prefetch requests made, and discarded because the PagedLOD stopped being predicted to become visible.
+        std::atomic_uint64_t numPrefetchRequests{0};
+        std::atomic_uint64_t numPrefetchDiscarded{0};
+
+        /// number of times a PagedLOD's high res child became visible with it already loaded, and without it loaded so the low res child was shown instead.
+        std::atomic_uint64_t numHighResHits{0};
+        std::atomic_uint64_t numHighResMisses{0};
+
+        /// timing statistics for a stage of the paging pipeline
+        struct Statistics
+        {
+            std::atomic_uint64_t count{0};
+            std::atomic_uint64_t totalTime{0}; // nanoseconds
+            std::atomic_uint64_t maxTime{0};   // nanoseconds
+
+            void add(uint64_t time);
+            double averageTime() const { return count > 0 ? (static_cast<double>(totalTime) / static_cast<double>(count)) * 1e-6 : 0.0; } // milliseconds
+        };
+
+        Statistics ioStatistics;
+        Statistics readStatistics;
+        Statistics compileStatistics;
+
+        std::atomic_size_t inFlightBytes{0};
+
         std::atomic_uint numActiveRequests{0};
         std::atomic_uint64_t frameCount;
 
@@ -108,6 +187,20 @@ namespace vsg
         /// for systems with smaller GPU memory limits you may need to reduce the targetMaxNumPagedLODWithHighResSubgraphs to keep memory usage within available limits.
         uint32_t targetMaxNumPagedLODWithHighResSubgraphs = 1500;
 
+        /// CPU and GPU memory budgets for the loaded high res subgraphs, 0 for no limit. When exceeded the least recently used and most distant inactive
+        /// high res subgraphs are expired first. CPU memory is the Data::dataSize() of the Data referenced by a subgraph, GPU memory is the BufferInfo ranges
+        /// and Image memory requirements of the subgraph once compiled. Resources shared between subgraphs are counted for each subgraph that uses them.
+        uint64_t targetMaxCPUMemory = 0;
+        uint64_t targetMaxGPUMemory = 0;
+
+        /// weighting of a PagedLOD's last lod distance, as multiples of its bounding sphere radius, relative to the number of frames since its high res child
+        /// was last used when ranking the inactive high res subgraphs for expiry.
+        double expiryDistanceWeight = 1.0;
+
+        /// memory used by the merged high res subgraphs, as measured for the targetMaxCPUMemory and targetMaxGPUMemory budgets.
+        std::atomic_uint64_t totalCPUMemoryUsage{0};
+        std::atomic_uint64_t totalGPUMemoryUsage{0};
+
         std::mutex pendingPagedLODMutex;
 
         ref_ptr<PagedLODContainer> pagedLODContainer;
@@ -117,12 +210,35 @@ namespace vsg
 
         void requestDiscarded(PagedLOD* plod);
 
+        /// file contents read by the I/O threads for the read threads to decode
+        struct FileData;
+        using FileDataQueue = ThreadSafeQueue<ref_ptr<FileData>>;
+
+        bool beginRead(PagedLOD* plod);
+        ref_ptr<Object> read(FileData& fileData);
+        void compile(ref_ptr<PagedLOD> plod);
+
+        void runIOThread();
+        void runReadThread();
+        void runCompileThread();
+
+        /// wait till the predicate returns true or the pager is stopped, return false if stopped.
+        bool waitUntil(const std::function<bool()>& predicate);
+        void notifyWaiting();
+
         ref_ptr<ActivityStatus> _status;
 
         ref_ptr<DatabaseQueue> _requestQueue;
+        ref_ptr<FileDataQueue> _fileDataQueue;
+        ref_ptr<DatabaseQueue> _compileQueue;
         ref_ptr<DatabaseQueue> _toMergeQueue;
 
+        std::mutex _waitMutex;
+        std::condition_variable _waitCV;
+
+        std::list<std::thread> _ioThreads;
         std::list<std::thread> _readThreads;
+        std::list<std::thread> _compileThreads;
     };
     VSG_type_name(vsg::DatabasePager);
 
@@ -0,0 +1,63 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsg/core/Inherit.h>
+#include <vsg/io/Path.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace vsg
+{
+
+    /// DirectoryCache caches the contents of directories so that vsg::findFile(filename, options) checks files exist with hash lookups rather than a file system query for each entry of Options::paths.
+    /// Directories are listed with vsg::getDirectoryContents(..) the first time they are searched, directories that don't exist are cached as empty so repeated misses are cheap too.
+    /// Changes to the file system after a directory has been listed aren't seen until it is invalidated. Assign to Options::directoryCache to enable.
+    class VSG_DECLSPEC DirectoryCache : public Inherit<Object, DirectoryCache>
+    {
+    public:
+        DirectoryCache();
+
+        /// return true if the file or directory exists, listing its parent directory on first use.
+        bool fileExists(const Path& path);
+
+        /// return the full filename path if filename can be found in the list of paths, otherwise return empty Path{}.
+        Path findFile(const Path& filename, const Paths& paths);
+
+        /// discard the cached contents of directory so that it's listed again when next searched.
+        void invalidate(const Path& directory);
+
+        /// discard the cached contents of all directories.
+        void clear();
+
+        /// return the number of directories cached.
+        size_t size() const;
+
+    protected:
+        virtual ~DirectoryCache();
+
+        using Key = Path::string_type;
+        using Contents = std::unordered_set<Key>;
+
+        std::shared_ptr<const Contents> _getContents(const Key& directory);
+
+        mutable std::mutex _mutex;
+        std::unordered_map<Key, std::shared_ptr<const Contents>> _directories;
+    };
+    VSG_type_name(vsg::DirectoryCache);
+
+} // namespace vsg
@@ -54,6 +54,15 @@ namespace vsg
     /// If options is null and the filename can be found using its existing path that filename is returned, otherwise empty Path{} is returned.
     extern VSG_DECLSPEC Path findFile(const Path& filename, const Options* options);
 
+    /// return the time the file was last modified, in seconds since the epoch, or 0 if the file doesn't exist.
+    extern VSG_DECLSPEC int64_t fileModificationTime(const Path& path);
+
+    /// rename a file, replacing any existing file at newPath so other threads and processes never see a partially written newPath. Return true on success.
+    extern VSG_DECLSPEC bool renameFile(const Path& oldPath, const Path& newPath);
+
+    /// remove a file, return true on success.
+    extern VSG_DECLSPEC bool removeFile(const Path& path);
+
     /// make a directory, return true if path already exists or full path has been created successfully, return false on failure.
     extern VSG_DECLSPEC bool makeDirectory(const Path& path);
 
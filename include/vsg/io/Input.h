@@ -68,6 +68,13 @@ namespace vsg
         // read object
         virtual ref_ptr<Object> read() = 0;
 
+        /// skip any padding in front of the values of an array, used by formats that align array values in the stream.
+        virtual void alignArray() {}
+
+        /// return a pointer to size bytes of array values that can be referenced in place rather than copied, advancing the input past them, or nullptr if the values should be read.
+        /// owner is assigned the object that owns the memory, which the array must reference to keep the values valid.
+        virtual const void* mapArray(size_t /*size*/, size_t /*alignment*/, ref_ptr<Object>& /*owner*/) { return nullptr; }
+
         // map char to int8_t
         void read(size_t num, char* value) { read(num, reinterpret_cast<int8_t*>(value)); }
         void read(size_t num, bool* value) { read(num, reinterpret_cast<int8_t*>(value)); }
@@ -0,0 +1,54 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Inherit.h>
+#include <vsg/io/Path.h>
+
+namespace vsg
+{
+
+    /// MappedFile maps the contents of a file into memory so that it can be read, or referenced in place, without copying it through a stream.
+    /// Pages are mapped copy-on-write so data referencing the mapping may be modified without changing the file.
+    /// Used by BinaryInput to reference array values of .vsgb files in place, arrays referencing the mapping hold a reference to the MappedFile to keep it valid.
+    class VSG_DECLSPEC MappedFile : public Inherit<Object, MappedFile>
+    {
+    public:
+        MappedFile();
+        explicit MappedFile(const Path& in_filename);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// mapping is not serialized, read/write are no-ops
+        void read(Input&) override {}
+        void write(Output&) const override {}
+
+        bool valid() const { return _data != nullptr; }
+
+        const uint8_t* data() const { return _data; }
+        size_t size() const { return _size; }
+
+        Path filename;
+
+    protected:
+        virtual ~MappedFile();
+
+        uint8_t* _data = nullptr;
+        size_t _size = 0;
+        void* _fileHandle = nullptr;
+        void* _mappingHandle = nullptr;
+    };
+    VSG_type_name(vsg::MappedFile);
+
+} // namespace vsg
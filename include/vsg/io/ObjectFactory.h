@@ -33,6 +33,10 @@ namespace vsg
         using CreateFunction = std::function<vsg::ref_ptr<vsg::Object>()>;
         using CreateMap = std::map<std::string, CreateFunction>;
 
+        /// return the function for creating instances of the named class, empty if the class isn't registered.
+        /// Used by readers to look up each class once and then create its instances directly.
+        virtual CreateFunction getCreateFunction(const std::string& className) const;
+
         CreateMap& getCreateMap() { return _createMap; }
         const CreateMap& getCreateMap() const { return _createMap; }
 
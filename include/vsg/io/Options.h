@@ -24,6 +24,7 @@ namespace vsg
     class ReaderWriter;
     class OperationThreads;
     class CommandLine;
+    class DirectoryCache;
     class ShaderSet;
 
     using ReaderWriters = std::vector<ref_ptr<ReaderWriter>>;
@@ -72,6 +73,14 @@ namespace vsg
         using FindFileCallback = std::function<Path(const Path& filename, const Options* options)>;
         FindFileCallback findFileCallback;
 
+        /// when assigned vsg::findFile(filename, options) checks files exist using the cached directory contents rather than querying the file system, see vsg::DirectoryCache.
+        ref_ptr<DirectoryCache> directoryCache;
+
+        /// local directory that vsg::read(..) caches objects loaded from other formats in as .vsgb files, so later reads of the same file or URL skip parsing the source format.
+        /// Safe to share between threads and processes, see vsg::fileCachePath(..) and vsg::fileCacheStatistics().
+        /// Entries are keyed on the resolved filename and a hash of the Options that affect loading, see vsg::fileCacheKey(..), other state used by ReaderWriters isn't checked.
+        /// A cached entry is reused while it isn't older than the local source file, compared using modification times with 1 second resolution, so a source modified
+        /// within the same second it was cached may not be reloaded. Local files that can't be found bypass the cache, while URLs are cached without ever being revalidated.
         Path fileCache;
 
         Path extensionHint;
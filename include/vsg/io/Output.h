@@ -50,6 +50,9 @@ namespace vsg
         /// write end of line character if required.
         virtual void writeEndOfLine() = 0;
 
+        /// write any padding required in front of the values of an array, used by formats that align array values in the stream.
+        virtual void alignArray() {}
+
         /// write contiguous array of value(s)
         virtual void write(size_t num, const int8_t* value) = 0;
         virtual void write(size_t num, const uint8_t* value) = 0;
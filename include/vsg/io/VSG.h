@@ -12,13 +12,18 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/io/BinaryInput.h>
 #include <vsg/io/ReaderWriter.h>
 
+#include <functional>
+#include <memory>
 #include <sstream>
 
 namespace vsg
 {
 
+    class CompressionCodec;
+
     /// ReaderWriter for reading and writing native VSG ascii and binary files.
     class VSG_DECLSPEC VSG : public Inherit<ReaderWriter, VSG>
     {
@@ -29,11 +34,40 @@ namespace vsg
         vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options = {}) const override;
         vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> = {}) const override;
 
+        /// read a .vsgb or .vsgt file that has already been located, without checking the extension or searching Options::paths.
+        /// Used by vsg::read(..) to load files from Options::fileCache.
+        vsg::ref_ptr<vsg::Object> readFile(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const;
+
         bool write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
         bool write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options = {}) const override;
 
+        bool readOptions(Options& options, CommandLine& arguments) const override;
+
         bool getFeatures(Features& features) const override;
 
+        /// Options::setValue(VSG::map_file, true) memory maps .vsgb files when reading so that aligned array values are referenced in place rather than copied.
+        /// Arrays referencing the mapped values hold a reference to the MappedFile, so the file remains mapped for as long as they exist, copies of them allocate their own values.
+        static constexpr const char* map_file = "map_file";
+
+        /// Options::setValue(VSG::array_alignment, uint32_t(alignment)) pads array values to alignment bytes when writing .vsgb files, 0 for no padding.
+        /// Padded files can only be read by versions of the VSG that support the alignment declared in the header.
+        static constexpr const char* array_alignment = "array_alignment";
+
+        /// Options::setValue(VSG::compression_codec, std::string(name)) writes .vsgb files compressed in blocks with the named CompressionCodec, such as the built in "lz4".
+        /// The codec is recorded in the header so compressed files are decompressed automatically when read.
+        static constexpr const char* compression_codec = "compression_codec";
+
+        /// Options::setValue(VSG::compression_block_size, uint32_t(size)) sets the uncompressed size of the blocks written to compressed .vsgb files.
+        static constexpr const char* compression_block_size = "compression_block_size";
+
+        /// Options::setValue(VSG::index_threshold, uint32_t(size)) appends an index of the self contained objects of at least size bytes to .vsgb files, such as large subgraphs and arrays.
+        /// When reading indexed files from a filename or memory with Options::operationThreads assigned the indexed objects are read in parallel, then linked in by the sequential read of the root object.
+        static constexpr const char* index_threshold = "index_threshold";
+
+        /// Options::setValue(VSG::class_ids, true) writes each class name to .vsgb files once, with later objects of the class referring to it by a small integer ID.
+        /// Off by default as versions of the VSG that predate class IDs can't read these files, they write the class name of every object.
+        static constexpr const char* class_ids = "class_ids";
+
         ObjectFactory* getObjectFactory() { return _objectFactory; }
         const ObjectFactory* getObjectFactory() const { return _objectFactory; }
 
@@ -46,10 +80,36 @@ namespace vsg
 
         using FormatInfo = std::pair<FormatType, VsgVersion>;
 
-        FormatInfo readHeader(std::istream& fin) const;
-        void writeHeader(std::ostream& fout, const FormatInfo& formatInfo) const;
+        /// settings declared by binary headers after the version
+        struct BinaryHeader
+        {
+            /// alignment of array values, when greater than 1 the header is padded to a multiple of it so array values are aligned relative to the start of the file.
+            uint32_t alignment = 0;
+
+            /// name of the CompressionCodec the data following the header is compressed with, empty when not compressed.
+            std::string codec;
+
+            /// an object index follows the root object
+            bool indexed = false;
+
+            /// objects refer to their class by ID after the first object of the class
+            bool classIDs = false;
+        };
+
+        /// read the header, assigning the settings declared by binary headers to binaryHeader when provided.
+        FormatInfo readHeader(std::istream& fin, BinaryHeader* binaryHeader = nullptr) const;
+
+        /// write the header, binary headers declare the settings in binaryHeader.
+        void writeHeader(std::ostream& fout, const FormatInfo& formatInfo, const BinaryHeader& binaryHeader = {}) const;
 
     protected:
+        /// function that opens an additional input stream positioned at the start of the data following the header
+        using OpenPayload = std::function<std::unique_ptr<std::istream>()>;
+
+        ref_ptr<Object> _readBinary(std::istream& fin, ref_ptr<const Options> options, const Path& filename, const VsgVersion& version, const BinaryHeader& binaryHeader, const OpenPayload& openPayload) const;
+        void _readIndexedObjects(BinaryInput& input, std::istream& payload, ref_ptr<const CompressionCodec> codec, const OpenPayload& openPayload) const;
+        bool _writeBinary(const Object* object, std::ostream& fout, ref_ptr<const Options> options, const VsgVersion& version, uint32_t alignment) const;
+
         ref_ptr<ObjectFactory> _objectFactory;
     };
     VSG_type_name(vsg::VSG);
@@ -0,0 +1,93 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/CompressionCodec.h>
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace vsg
+{
+
+    /// Output stream that compresses the data written to it in independent blocks written to an underlying output stream.
+    /// Each block is written as its uncompressed and compressed sizes as uint32_t followed by the compressed bytes, blocks that don't compress are stored as is with both sizes equal.
+    /// A block with both sizes 0 marks the end of the blocks, followed by the block index, see compressed_istream.
+    class VSG_DECLSPEC compressed_ostream : public std::ostream
+    {
+    public:
+        compressed_ostream(std::ostream& output, ref_ptr<const CompressionCodec> codec, size_t blockSize = 262144);
+        ~compressed_ostream();
+
+        /// compress and write the remaining data followed by the block index, called by the destructor if not called explicitly.
+        void finish();
+
+    private:
+        struct compress_buffer : public std::streambuf
+        {
+            compress_buffer(std::ostream& in_output, ref_ptr<const CompressionCodec> in_codec, size_t blockSize);
+
+            int_type overflow(int_type c) override;
+            bool writeBlock();
+            void finish();
+
+            std::ostream& output;
+            ref_ptr<const CompressionCodec> codec;
+            std::vector<char> buffer;
+            std::vector<uint8_t> compressed;
+            std::vector<uint64_t> blockIndex;
+            uint64_t compressedPosition = 0;
+            uint64_t uncompressedPosition = 0;
+            bool finished = false;
+        };
+
+        compress_buffer _buffer;
+    };
+
+    /// Input stream that decompresses the blocks written by compressed_ostream.
+    /// Reading is sequential, decompressing one block at a time. Seeking is supported when the underlying input stream is seekable,
+    /// using the block index at the end of the compressed data so only the block containing the new position is decompressed.
+    class VSG_DECLSPEC compressed_istream : public std::istream
+    {
+    public:
+        compressed_istream(std::istream& input, ref_ptr<const CompressionCodec> codec);
+
+    private:
+        struct decompress_buffer : public std::streambuf
+        {
+            decompress_buffer(std::istream& in_input, ref_ptr<const CompressionCodec> in_codec);
+
+            int_type underflow() override;
+            pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+            pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+            bool readBlock();
+            bool readIndex();
+
+            std::istream& input;
+            ref_ptr<const CompressionCodec> codec;
+            std::streampos start;
+            std::vector<char> buffer;
+            std::vector<uint8_t> compressed;
+            uint64_t blockStart = 0;
+            bool endOfBlocks = false;
+
+            // pairs of compressed and uncompressed offsets of each block, followed by the total compressed and uncompressed sizes
+            std::vector<uint64_t> blockIndex;
+        };
+
+        decompress_buffer _buffer;
+    };
+
+} // namespace vsg
@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <atomic>
 #include <istream>
 #include <vsg/core/Inherit.h>
 #include <vsg/io/FileSystem.h>
@@ -23,6 +24,25 @@ namespace vsg
     /** convenience method for reading objects from file.*/
     extern VSG_DECLSPEC ref_ptr<Object> read(const Path& filename, ref_ptr<const Options> options = {});
 
+    /// statistics of the use of Options::fileCache by vsg::read(..), updated atomically so may be read while other threads are loading.
+    struct FileCacheStatistics
+    {
+        std::atomic_uint64_t hits{0};
+        std::atomic_uint64_t misses{0};
+        std::atomic_uint64_t writes{0};
+        std::atomic_uint64_t failedWrites{0};
+    };
+
+    /// return the statistics of Options::fileCache use across all vsg::read(..) calls.
+    extern VSG_DECLSPEC FileCacheStatistics& fileCacheStatistics();
+
+    /// return a hash of the Options that affect what the ReaderWriters load, i.e. extensionHint, coordinate conventions, ReaderWriter and ShaderSet names and the values assigned with Options::setValue(..)
+    extern VSG_DECLSPEC uint64_t fileCacheKey(const Options* options);
+
+    /// return the .vsgb file within fileCache that vsg::read(..) caches the object loaded from filename or URL as, i.e. fileCache/server/path/file.gltf.vsgb,
+    /// or when options are supplied fileCache/server/path/file.gltf.<fileCacheKey(options)>.vsgb so that reads with different Options don't share entries.
+    extern VSG_DECLSPEC Path fileCachePath(const Path& fileCache, const Path& filename, const Options* options = nullptr);
+
     /** convenience method for reading objects from files.*/
     extern VSG_DECLSPEC PathObjects read(const Paths& filenames, ref_ptr<const Options> options = {});
 
@@ -0,0 +1,49 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/nodes/Group.h>
+
+namespace vsg
+{
+
+    /// BatchCullGroup is a Group whose children are view frustum culled in batches during the RecordTraversal.
+    /// The bounds of CullNode, CullGroup, LOD and PagedLOD children are gathered into separate x, y, z and radius arrays so they can be tested against the frustum
+    /// several at a time, CullNode and CullGroup children that pass are traversed without repeating their own test, unless State::coherentCulling is enabled
+    /// in which case they are passed on to RecordTraversal::apply() to update their cullingPlaneHint and the planeMask for their subgraph. Other children are always traversed.
+    /// updateBounds() must be called after the bounds of the children are modified. Children added or replaced since updateBounds() was last called are traversed without batch culling.
+    class VSG_DECLSPEC BatchCullGroup : public Inherit<Group, BatchCullGroup>
+    {
+    public:
+        explicit BatchCullGroup(size_t numChildren = 0);
+
+        using Group::traverse;
+        void traverse(RecordTraversal& visitor) const override;
+
+        void read(Input& input) override;
+
+        /// gather the bounds of the children into the arrays used for batch culling
+        void updateBounds();
+
+    protected:
+        virtual ~BatchCullGroup();
+
+        std::vector<double> _x;
+        std::vector<double> _y;
+        std::vector<double> _z;
+        std::vector<double> _radius;
+        std::vector<const Node*> _boundChildren;
+    };
+    VSG_type_name(vsg::BatchCullGroup);
+
+} // namespace vsg
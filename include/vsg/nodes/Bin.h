@@ -20,6 +20,8 @@ namespace vsg
 
     /// Bin node is used internally by RecordTraversal/View to collect and then sort command nodes assigned to the bin,
     /// then recorded to the command buffer in the sorted order.
+    /// STATE_SORT orders the nodes by their state commands so that consecutive nodes share pipelines and descriptor sets,
+    /// state commands shared with the previously recorded node are left in place rather than being bound again.
     class VSG_DECLSPEC Bin : public Inherit<Node, Bin>
     {
     public:
@@ -27,7 +29,8 @@ namespace vsg
         {
             NO_SORT,
             ASCENDING,
-            DESCENDING
+            DESCENDING,
+            STATE_SORT
         };
 
         Bin();
@@ -42,13 +45,38 @@ namespace vsg
 
         void add(State* state, double value, const Node* node);
 
+        /// append the elements of another bin, used to combine the bins filled by RecordTraversals recording subgraphs in parallel.
+        void merge(const Bin& bin);
+
         int32_t binNumber = 0;
         SortOrder sortOrder = NO_SORT;
 
+        /// sorted bins with at least this many elements are sorted with a radix sort, smaller bins use std::sort.
+        uint32_t radixSortThreshold = 256;
+
+        /// start sorting from the previous frame's order and use an insertion sort when few elements have changed place.
+        /// Assumes the elements are added in the same order each frame, as they are when the scene graph is unchanged.
+        bool incrementalSort = false;
+
+        /// when greater than 1 STATE_SORT first orders the nodes front to back into this many depth ranges, then by state within each range.
+        uint32_t depthBuckets = 0;
+
+        /// number of state commands pushed during the last traversal
+        uint32_t getNumStateCommandsPushed() const { return _numStateCommandsPushed; }
+
+        /// number of state commands left in place during the last traversal because they were shared with the previous node, each one a bind saved.
+        uint32_t getNumStateCommandsShared() const { return _numStateCommandsShared; }
+
     protected:
         virtual ~Bin();
 
+        void sort() const;
+        void radixSort() const;
+        bool insertionSort(size_t maxMoves) const;
+        void stateSort() const;
+
         std::vector<dmat4> _matrices;
+        std::vector<uint64_t> _matrixIDs;
         std::vector<const StateCommand*> _stateCommands;
 
         struct Element
@@ -63,6 +91,11 @@ namespace vsg
 
         using KeyIndex = std::pair<float, uint32_t>;
         mutable std::vector<KeyIndex> _binElements;
+        mutable std::vector<KeyIndex> _sortBuffer;
+        mutable std::vector<uint32_t> _previousOrder;
+
+        mutable uint32_t _numStateCommandsPushed = 0;
+        mutable uint32_t _numStateCommandsShared = 0;
     };
     VSG_type_name(vsg::Bin);
 
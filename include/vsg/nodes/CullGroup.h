@@ -15,6 +15,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/maths/sphere.h>
 #include <vsg/nodes/Group.h>
 
+#include <atomic>
+
 namespace vsg
 {
 
@@ -30,6 +32,9 @@ namespace vsg
 
         dsphere bound;
 
+        /// frustum plane that last culled the bound, tested first when State::coherentCulling is enabled
+        mutable std::atomic_uint8_t cullingPlaneHint{0};
+
     protected:
         virtual ~CullGroup();
     };
@@ -0,0 +1,100 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/commands/BindIndexBuffer.h>
+#include <vsg/commands/BindVertexBuffers.h>
+#include <vsg/commands/DrawIndexedIndirect.h>
+#include <vsg/core/Array.h>
+#include <vsg/maths/sphere.h>
+#include <vsg/nodes/Node.h>
+
+#include <mutex>
+
+namespace vsg
+{
+
+    /** CulledInstanceDraw draws many instances of a single indexed mesh, view frustum culling the instances individually on the CPU during the RecordTraversal.
+      * The transforms of the visible instances are packed into a per instance vertex array and drawn with a single vkCmdDrawIndexedIndirect.
+      * The instance matrices are bound at firstBinding + arrays.size() and must be declared in the pipeline's vertex input state with VK_VERTEX_INPUT_RATE_INSTANCE.
+      * The instances are grouped into spatially coherent clusters so that clusters outside the frustum are culled without testing their instances.
+      * Each time the node is recorded in a frame it is assigned its own slot in the instance and indirect buffers, up to maxViews,
+      * so Views and repeated occurrences of the node in the scene graph don't overwrite each other, further recordings draw all the instances unculled.
+      * update() must be called after any of the settings are changed and before the node is compiled.*/
+    class VSG_DECLSPEC CulledInstanceDraw : public Inherit<Node, CulledInstanceDraw>
+    {
+    public:
+        CulledInstanceDraw();
+
+        void traverse(Visitor& visitor) override;
+        void traverse(ConstVisitor& visitor) const override;
+        void traverse(RecordTraversal& visitor) const override;
+
+        void read(Input& input) override;
+        void write(Output& output) const override;
+
+        // mesh settings
+        uint32_t firstBinding = 0;
+        DataList arrays;
+        ref_ptr<Data> indices;
+        uint32_t indexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t vertexOffset = 0;
+
+        /// bound of the mesh in its local coordinate frame
+        dsphere bound;
+
+        /// per instance transforms
+        ref_ptr<mat4Array> instanceMatrices;
+
+        /// maximum number of times the node is recorded in a frame with the instances culled, one per View when the node only appears once in each View's subgraph.
+        /// Slots are reset each frame using the RecordTraversal's FrameStamp.
+        uint32_t maxViews = 1;
+
+        /// set up the instance bounds and the internal commands used to bind and draw the mesh
+        void update();
+
+    protected:
+        virtual ~CulledInstanceDraw();
+
+        uint32_t _nextSlot(uint64_t frameCount) const;
+
+        // instance bounds, ordered by cluster, with _order mapping back to the index in instanceMatrices
+        std::vector<uint32_t> _order;
+        std::vector<double> _x;
+        std::vector<double> _y;
+        std::vector<double> _z;
+        std::vector<double> _radius;
+
+        // cluster bounds, the instances of cluster i are in the range _clusterOffsets[i] to _clusterOffsets[i+1]
+        std::vector<uint32_t> _clusterOffsets;
+        std::vector<double> _clusterX;
+        std::vector<double> _clusterY;
+        std::vector<double> _clusterZ;
+        std::vector<double> _clusterRadius;
+
+        ref_ptr<mat4Array> _visibleMatrices;
+        ref_ptr<uintArray> _indirectCommands;
+
+        ref_ptr<BindVertexBuffers> _bindCulledInstances;
+        ref_ptr<BindVertexBuffers> _bindAllInstances;
+        ref_ptr<BindIndexBuffer> _bindIndexBuffer;
+        ref_ptr<DrawIndexedIndirect> _drawIndexedIndirect;
+
+        mutable std::mutex _slotMutex;
+        mutable uint64_t _slotFrameCount = 0;
+        mutable uint32_t _numSlotsUsed = 0;
+    };
+    VSG_type_name(vsg::CulledInstanceDraw);
+
+} // namespace vsg
@@ -18,6 +18,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 
 namespace vsg
 {
@@ -60,6 +61,9 @@ namespace vsg
         dsphere bound;
         Children children;
 
+        /// frustum plane that last culled the bound, tested first when State::coherentCulling is enabled
+        mutable std::atomic_uint8_t cullingPlaneHint{0};
+
         void addChild(const Child& lodChild) { children.push_back(lodChild); }
 
     protected:
@@ -27,7 +27,7 @@ namespace vsg
 
         /// provide new and delete to enable custom memory management via the vsg::Allocator singleton, using the MEMORY_NODES_OBJECTS
         static void* operator new(std::size_t count);
-        static void operator delete(void* ptr);
+        static void operator delete(void* ptr, std::size_t size);
 
     protected:
         virtual ~Node();
@@ -84,8 +84,19 @@ namespace vsg
         mutable std::atomic<double> priority{0.0};
 
         mutable std::atomic_uint64_t frameHighResLastUsed{0};
+        mutable std::atomic_uint64_t frameHighResLastPredicted{0}; // last frame the DatabasePager's prefetch predicted the high res child would be visible
         mutable std::atomic_uint requestCount{0};
 
+        // lod distance computed by the last record traversal to visit this PagedLOD, used by the DatabasePager to decide which high res children to expire first.
+        mutable std::atomic<double> lastLodDistance{0.0};
+
+        // frustum plane that last culled the bound, tested first when State::coherentCulling is enabled
+        mutable std::atomic_uint8_t cullingPlaneHint{0};
+
+        // CPU and GPU memory used by the high res child, assigned by the DatabasePager once the child has been compiled.
+        mutable uint64_t cpuMemoryUsage = 0;
+        mutable uint64_t gpuMemoryUsage = 0;
+
         enum RequestStatus : unsigned int
         {
             NoRequest = 0,
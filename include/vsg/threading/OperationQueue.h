@@ -16,12 +16,20 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/threading/ActivityStatus.h>
 #include <vsg/threading/Latch.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <list>
+#include <memory>
+#include <mutex>
 
 namespace vsg
 {
 
-    /// Template thread safe queue
+    /// Template thread safe queue.
+    /// Objects are held in a fixed capacity lock-free multi-producer/multi-consumer ring buffer, using the algorithm by Dmitry Vyukov,
+    /// so add() and take() don't need to lock a mutex or allocate memory. If the ring buffer is full, additional objects are held in
+    /// an overflow list protected by a mutex until the ring buffer has been drained. Threads calling take_when_available() on an empty queue
+    /// are parked on a condition variable and woken by add().
     template<class T>
     class ThreadSafeQueue : public Inherit<Object, ThreadSafeQueue<T>>
     {
@@ -29,9 +37,16 @@ namespace vsg
         using value_type = T;
         using container_type = std::list<value_type>;
 
-        explicit ThreadSafeQueue(ref_ptr<ActivityStatus> status) :
+        explicit ThreadSafeQueue(ref_ptr<ActivityStatus> status, size_t capacity = 1024) :
             _status(status)
         {
+            // round capacity up to a power of two so that the index can be mapped to a cell with a mask
+            size_t numCells = 2;
+            while (numCells < capacity) numCells <<= 1;
+
+            _cells.reset(new Cell[numCells]);
+            _mask = numCells - 1;
+            for (size_t i = 0; i < numCells; ++i) _cells[i].sequence.store(i, std::memory_order_relaxed);
         }
 
         ActivityStatus* getStatus() { return _status; }
@@ -40,9 +55,8 @@ namespace vsg
         /// add a single object to the back of the queue
         void add(value_type operation)
         {
-            std::scoped_lock lock(_mutex);
-            _queue.emplace_back(operation);
-            _cv.notify_one();
+            push(std::move(operation));
+            notify(1);
         }
 
         /// add multiple objects to the back of the queue
@@ -50,81 +64,221 @@ namespace vsg
         void add(Iterator begin, Iterator end)
         {
             size_t numAdditions = 0;
-            std::scoped_lock lock(_mutex);
             for (auto itr = begin; itr != end; ++itr)
             {
-                _queue.emplace_back(*itr);
+                push(*itr);
                 ++numAdditions;
             }
 
-            if (numAdditions == 1)
-                _cv.notify_one();
-            else if (numAdditions > 1)
-                _cv.notify_all();
+            notify(numAdditions);
         }
 
         /// return true if the queue is empty.
         bool empty() const
         {
-            std::unique_lock lock(_mutex);
-            return _queue.empty();
+            return _dequeuePosition.load(std::memory_order_acquire) == _enqueuePosition.load(std::memory_order_acquire) && _numOverflow.load() == 0;
+        }
+
+        /// return the number of objects in the queue, only approximate while other threads are adding or taking objects.
+        size_t size() const
+        {
+            size_t dequeuePosition = _dequeuePosition.load(std::memory_order_acquire);
+            size_t enqueuePosition = _enqueuePosition.load(std::memory_order_acquire);
+            return ((enqueuePosition > dequeuePosition) ? (enqueuePosition - dequeuePosition) : 0) + _numOverflow.load();
         }
 
         /// take all available objects from the queue
         container_type take_all()
         {
-            std::unique_lock lock(_mutex);
-
             container_type objects;
-            objects.swap(_queue);
-
+            value_type object;
+            while (pop(object))
+            {
+                objects.emplace_back(std::move(object));
+            }
             return objects;
         }
 
         /// take the head from the queue of objects, return null pointer if none are available
         value_type take()
         {
-            std::unique_lock lock(_mutex);
+            value_type object;
+            pop(object);
+            return object;
+        }
 
-            if (_queue.empty()) return {};
+        /// take the head of the queue, waiting till one is made available if initially empty
+        value_type take_when_available()
+        {
+            return take_when_available([]() { return false; });
+        }
+
+        /// take the head of the queue, waiting till one is made available if initially empty,
+        /// or return nothing if stop_waiting() returns true when checked after a call to wake_waiting().
+        template<typename Predicate>
+        value_type take_when_available(Predicate stop_waiting)
+        {
+            // if the threads we are associated with should no longer be running go for a quick exit and return nothing.
+            if (_status->cancel()) return {};
 
-            auto operation = _queue.front();
+            value_type object;
+            if (pop(object)) return object;
 
-            _queue.erase(_queue.begin());
+            std::chrono::duration waitDuration = std::chrono::milliseconds(100);
 
-            return operation;
+            ++_numWaiting;
+            {
+                std::unique_lock lock(_mutex);
+
+                // wait until the conditional variable signals that an operation has been added, the timeout ensures changes to the ActivityStatus are seen
+                while (_status->active() && !pop_ring(object) && !pop_overflow(object) && !stop_waiting())
+                {
+                    // debug("Waiting on condition variable");
+                    _cv.wait_for(lock, waitDuration);
+                }
+            }
+            --_numWaiting;
+
+            return object;
         }
 
-        /// take the head of the queue, waiting till one is made available if initially empty
-        value_type take_when_available()
+        /// wake all threads waiting in take_when_available() so they re-check their stop_waiting predicate.
+        /// The state the predicate checks must be updated before calling wake_waiting().
+        void wake_waiting()
         {
-            std::chrono::duration waitDuration = std::chrono::milliseconds(100);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_numWaiting.load() == 0) return;
+
+            std::scoped_lock lock(_mutex);
+            _cv.notify_all();
+        }
 
-            std::unique_lock lock(_mutex);
+    protected:
+        struct Cell
+        {
+            std::atomic_size_t sequence;
+            value_type value;
+        };
 
-            // wait until the conditional variable signals that an operation has been added
-            while (_queue.empty() && _status->active())
+        // attempt to add object to the ring buffer, return false if it's full.
+        bool push_ring(value_type& object)
+        {
+            size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+            for (;;)
             {
-                // debug("Waiting on condition variable");
-                _cv.wait_for(lock, waitDuration);
+                Cell& cell = _cells[position & _mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (diff == 0)
+                {
+                    if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        cell.value = std::move(object);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = _enqueuePosition.load(std::memory_order_relaxed);
+                }
             }
+        }
 
-            // if the threads we are associated with should no longer be running go for a quick exit and return nothing.
-            if (_status->cancel())
+        // attempt to take object from the ring buffer, return false if it's empty.
+        bool pop_ring(value_type& object)
+        {
+            size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+            for (;;)
             {
-                return {};
+                Cell& cell = _cells[position & _mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+                if (diff == 0)
+                {
+                    if (_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        object = std::move(cell.value);
+                        cell.value = {};
+                        cell.sequence.store(position + _mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = _dequeuePosition.load(std::memory_order_relaxed);
+                }
             }
+        }
+
+        void push(value_type object)
+        {
+            // once objects are in the overflow list, subsequent objects are also added to it so that they aren't taken ahead of earlier objects
+            if (_numOverflow.load() == 0 && push_ring(object)) return;
 
-            // remove and return the head of the queue
-            auto operation = _queue.front();
-            _queue.erase(_queue.begin());
-            return operation;
+            std::scoped_lock lock(_mutex);
+            _overflow.emplace_back(std::move(object));
+            ++_numOverflow;
         }
 
-    protected:
+        // attempt to take object from the overflow list, the _mutex must be locked by the caller.
+        bool pop_overflow(value_type& object)
+        {
+            if (_overflow.empty()) return false;
+
+            object = std::move(_overflow.front());
+            _overflow.pop_front();
+            --_numOverflow;
+            return true;
+        }
+
+        bool pop(value_type& object)
+        {
+            if (pop_ring(object)) return true;
+            if (_numOverflow.load() == 0) return false;
+
+            std::scoped_lock lock(_mutex);
+            return pop_overflow(object);
+        }
+
+        void notify(size_t numAdditions)
+        {
+            if (numAdditions == 0) return;
+
+            // make sure the additions are visible before checking for waiting threads, pairs with the increment of _numWaiting in take_when_available()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_numWaiting.load() == 0) return;
+
+            std::scoped_lock lock(_mutex);
+            if (numAdditions == 1)
+                _cv.notify_one();
+            else
+                _cv.notify_all();
+        }
+
+        std::unique_ptr<Cell[]> _cells;
+        size_t _mask = 0;
+        // explicit padding keeps the producer and consumer positions on separate cache lines, alignas(64) can't be used as vsg::allocate doesn't honour over-aligned Objects
+        char _padding0[64];
+        std::atomic_size_t _enqueuePosition = 0;
+        char _padding1[64 - sizeof(std::atomic_size_t)];
+        std::atomic_size_t _dequeuePosition = 0;
+        char _padding2[64 - sizeof(std::atomic_size_t)];
+
+        std::atomic_uint32_t _numWaiting = 0;
+        std::atomic_size_t _numOverflow = 0;
+        container_type _overflow;
+
         mutable std::mutex _mutex;
         std::condition_variable _cv;
-        container_type _queue;
         ref_ptr<ActivityStatus> _status;
     };
 
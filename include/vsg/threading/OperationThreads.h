@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/threading/Affinity.h>
 #include <vsg/threading/OperationQueue.h>
 
 #include <thread>
@@ -19,9 +20,10 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 namespace vsg
 {
 
-    /// OperationThreads provides a collection of std::threads that share a single OperationQueue.
-    /// Each thread polls the queue for vsg::Operation to process, when one is available it's removed
-    /// from the queue and its Operation::run() method is called.
+    /// OperationThreads provides a collection of std::threads that schedule vsg::Operation using work stealing.
+    /// Operations added from outside the worker threads go to the shared OperationQueue, while operations added
+    /// by an Operation running on a worker thread go to that worker's own deque where they are run last in first out,
+    /// idle workers steal the oldest operations from the other workers' deques before waiting on the shared queue.
     class VSG_DECLSPEC OperationThreads : public Inherit<Object, OperationThreads>
     {
     public:
@@ -29,21 +31,32 @@ namespace vsg
         OperationThreads(const OperationThreads&) = delete;
         OperationThreads& operator=(const OperationThreads& rhs) = delete;
 
-        void add(ref_ptr<Operation> operation)
-        {
-            queue->add(operation);
-        }
+        /// add operation, when called from one of the worker threads it's added to that thread's deque otherwise it's added to the shared queue.
+        void add(ref_ptr<Operation> operation);
+
+        /// add operation that should only be run by a worker thread whose affinity overlaps with the specified affinity.
+        /// If no worker thread matches the operation is added as normal.
+        void add(ref_ptr<Operation> operation, const Affinity& affinity);
 
         template<typename Iterator>
         void add(Iterator begin, Iterator end)
         {
-            queue->add(begin, end);
+            for (auto itr = begin; itr != end; ++itr)
+            {
+                add(*itr);
+            }
         }
 
+        /// set the CPU affinity of the worker threads, assigning the cpus in turn to each thread.
+        void setAffinity(const Affinity& affinity);
+
         /// use this thread to run operations till the queue is empty as well
         /// this thread will consume and run operations in parallel with any threads associated with this OperationThreads.
         void run();
 
+        /// run a single operation if one is available, return true if an operation was run.
+        bool run_one();
+
         /// stop threads
         void stop();
 
@@ -54,6 +67,10 @@ namespace vsg
 
     protected:
         virtual ~OperationThreads();
+
+        /// per thread deques and scheduling state, shared with the worker threads so they remain valid if the OperationThreads is released by an operation running on one of them.
+        struct Scheduler;
+        ref_ptr<Scheduler> _scheduler;
     };
     VSG_type_name(vsg::OperationThreads)
 
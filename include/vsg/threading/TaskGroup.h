@@ -0,0 +1,59 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/threading/OperationThreads.h>
+
+namespace vsg
+{
+
+    /// TaskGroup tracks a set of operations run on an OperationThreads so that the caller can wait for them to complete,
+    /// or schedule continuation operations to run once they have. A TaskGroup can have a parent group, the parent is not
+    /// complete until the child group's operations and continuations have completed.
+    class VSG_DECLSPEC TaskGroup : public Inherit<Object, TaskGroup>
+    {
+    public:
+        explicit TaskGroup(ref_ptr<OperationThreads> in_operationThreads, ref_ptr<TaskGroup> in_parent = {});
+
+        ref_ptr<OperationThreads> operationThreads;
+        ref_ptr<TaskGroup> parent;
+
+        /// add operation to the group and schedule it on the operationThreads, if an affinity is specified the operation is pinned to a matching worker thread.
+        void run(ref_ptr<Operation> operation, const Affinity& affinity = {});
+
+        /// schedule continuation once all the group's operations have completed, if the group has already completed the continuation is scheduled immediately.
+        /// Continuations are run as part of the parent group when one is assigned.
+        void then(ref_ptr<Operation> continuation);
+
+        /// return true if all the group's operations have completed
+        bool done() const { return _pending.load() == 0; }
+
+        /// wait for the group's operations to complete, the calling thread helps run available operations rather than blocking.
+        void wait();
+
+    protected:
+        virtual ~TaskGroup();
+
+        struct Task;
+
+        void increment();
+        void decrement();
+
+        std::atomic_uint32_t _pending = 0;
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::vector<ref_ptr<Operation>> _continuations;
+    };
+    VSG_type_name(vsg::TaskGroup)
+
+} // namespace vsg
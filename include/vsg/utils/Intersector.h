@@ -14,12 +14,28 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <vsg/nodes/Node.h>
 #include <vsg/state/ArrayState.h>
+#include <vsg/threading/OperationThreads.h>
+#include <vsg/utils/TriangleBVH.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
 
 namespace vsg
 {
 
+    /// IndexRatio is a pair of index and ratio used to specify the baricentric coords of primitives that have been intersected.
+    struct IndexRatio
+    {
+        uint32_t index;
+        double ratio;
+    };
+
+    using IndexRatios = std::vector<IndexRatio>;
+
     /// Intersector is a base class for intersecting the scene graph.
-    /// The LineSegmentIntersector subclass adds support for line segment intersections.
+    /// The LineSegmentIntersector, MultiLineSegmentIntersector, PolytopeIntersector and SphereIntersector subclasses add support for intersections with specific primitives.
     class VSG_DECLSPEC Intersector : public Inherit<ConstVisitor, Intersector>
     {
     public:
@@ -28,10 +44,26 @@ namespace vsg
 
         Intersector(ref_ptr<ArrayState> initialArrayState = {});
 
+        /// ALL_HITS collects every intersection, CLOSEST_HIT only retains the closest intersection and culls subgraphs that can't contain a closer one,
+        /// ANY_HIT stops the traversal at the first intersection found.
+        enum HitMode
+        {
+            ALL_HITS,
+            CLOSEST_HIT,
+            ANY_HIT
+        };
+
+        HitMode hitMode = ALL_HITS;
+
+        /// return true if the traversal has been stopped early, i.e. a hit has been found in ANY_HIT mode, including by another subgraph Intersector of a parallel traversal.
+        bool done() const { return _done || (_sharedHits && _sharedHits->done.load(std::memory_order_relaxed)); }
+
         //
         // handle traverse of the scene graph
         //
         void apply(const Node& node) override;
+        void apply(const Group& group) override;
+        void apply(const QuadGroup& group) override;
         void apply(const StateGroup& stategroup) override;
         void apply(const Transform& transform) override;
         void apply(const LOD& lod) override;
@@ -71,6 +103,24 @@ namespace vsg
         /// intersect with a vkCmdDrawIndexed primitive
         virtual bool intersectDrawIndexed(uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance, uint32_t instanceCount) = 0;
 
+        /// create an Intersector, with the same intersection primitives and settings, for intersecting a subgraph on another thread, return null if parallel traversal isn't supported.
+        /// Subgraphs are traversed serially when the Intersector created isn't of the same type as this Intersector, so subclasses inheriting this method don't lose their overrides.
+        virtual ref_ptr<Intersector> createSubgraphIntersector() { return {}; }
+
+        /// merge the results of the Intersectors created by createSubgraphIntersector(), called in the order of the subgraphs once all have completed.
+        virtual void mergeSubgraphIntersectors(const std::vector<ref_ptr<Intersector>>& /*subgraphIntersectors*/) {}
+
+        /// when assigned, the children of Group and QuadGroup nodes are intersected in parallel on the operationThreads, nesting up to parallelDepth levels of Group/QuadGroup.
+        ref_ptr<OperationThreads> operationThreads;
+        uint32_t parallelDepth = 2;
+
+        /// use a TriangleBVH, built on first use and cached in the triangleBVHCache, to accelerate intersections with indexed meshes of at least minimumTrianglesForBVH triangles.
+        bool useTriangleBVH = true;
+        uint32_t minimumTrianglesForBVH = 1024;
+
+        /// cache of TriangleBVH, defaults to TriangleBVHCache::instance() so that they are reused by later Intersectors.
+        ref_ptr<TriangleBVHCache> triangleBVHCache;
+
         /// get the current local to world matrix stack
         std::vector<dmat4>& localToWorldStack() { return arrayStateStack.back()->localToWorldStack; }
 
@@ -78,12 +128,83 @@ namespace vsg
         std::vector<dmat4>& worldToLocalStack() { return arrayStateStack.back()->worldToLocalStack; }
 
     protected:
+        /// return the TriangleBVH for the current indices and the specified vertices and range, building it if it doesn't exist or is out of date, or null if not applicable.
+        ref_ptr<const TriangleBVH> getOrCreateTriangleBVH(ref_ptr<const vec3Array> vertices, uint32_t firstIndex, uint32_t indexCount);
+
+        /// intersect the children in parallel using subgraph Intersectors, return false if the children need to be traversed serially.
+        bool traverseInParallel(const ref_ptr<Node>* first, const ref_ptr<Node>* last);
+
+        /// stop the traversal, along with the other subgraph Intersectors of a parallel traversal.
+        void stopTraversal();
+
+        /// return the distance of the closest hit found by this Intersector or by the other subgraph Intersectors of a parallel traversal, where lower distances are closer.
+        template<class T>
+        double closestHit(const std::vector<ref_ptr<T>>& intersections, double T::*distance) const
+        {
+            double closest = _sharedHits ? _sharedHits->closest.load(std::memory_order_relaxed) : std::numeric_limits<double>::max();
+            if (!intersections.empty()) closest = std::min(closest, (*intersections.front()).*distance);
+            return closest;
+        }
+
+        /// return true if a hit at distance d should be recorded for the hitMode, in CLOSEST_HIT and ANY_HIT modes clearing the intersection that it replaces.
+        template<class T>
+        bool recordHit(std::vector<ref_ptr<T>>& intersections, double T::*distance, double d)
+        {
+            if (hitMode != ALL_HITS)
+            {
+                if (done() || (hitMode == CLOSEST_HIT && d >= closestHit(intersections, distance))) return false;
+
+                intersections.clear();
+                if (hitMode == ANY_HIT)
+                    stopTraversal();
+                else
+                    shareClosestHit(d);
+            }
+
+            ++_numRecordedHits;
+            return true;
+        }
+
+        /// append the intersections of the subgraph Intersectors of type I and sort all intersections by distance so results don't depend on thread timing.
+        template<class I, class T>
+        void mergeIntersections(std::vector<ref_ptr<T>>& intersections, double T::*distance, const std::vector<ref_ptr<Intersector>>& subgraphIntersectors)
+        {
+            for (auto& intersector : subgraphIntersectors)
+            {
+                if (auto si = intersector.cast<I>())
+                {
+                    intersections.insert(intersections.end(), si->intersections.begin(), si->intersections.end());
+                }
+            }
+
+            std::stable_sort(intersections.begin(), intersections.end(), [distance](const ref_ptr<T>& lhs, const ref_ptr<T>& rhs) { return (*lhs).*distance < (*rhs).*distance; });
+
+            if (hitMode != ALL_HITS && intersections.size() > 1) intersections.resize(1);
+        }
+
+        /// hit state shared by the subgraph Intersectors of a parallel traversal, so that an ANY_HIT in one subgraph stops the others
+        /// and CLOSEST_HIT subgraphs cull against the closest hit found in any of them.
+        struct SharedHits
+        {
+            std::atomic_bool done{false};
+            std::atomic<double> closest{std::numeric_limits<double>::max()};
+        };
+
+        /// lower the closest hit shared with the other subgraph Intersectors of a parallel traversal to distance.
+        void shareClosestHit(double distance);
+
         ArrayStateStack arrayStateStack;
 
         ref_ptr<const ushortArray> ushort_indices;
         ref_ptr<const uintArray> uint_indices;
 
         NodePath _nodePath;
+        uint32_t _parallelLevel = 0;
+        bool _done = false;
+        std::shared_ptr<SharedHits> _sharedHits;
+
+        // number of hits recorded, including those replacing an earlier hit, so intersectDraw()/intersectDrawIndexed() can report whether they recorded a hit
+        size_t _numRecordedHits = 0;
     };
     VSG_type_name(vsg::Intersector);
 
@@ -18,15 +18,6 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 namespace vsg
 {
 
-    /// IndexRatio is a pair of index and ratio used to specify the baricentric coords of primitives that have been intersected.
-    struct IndexRatio
-    {
-        uint32_t index;
-        double ratio;
-    };
-
-    using IndexRatios = std::vector<IndexRatio>;
-
     /// LineSegmentIntersector is an Intersector subclass that provides support for computing intersections between a line segment and geometry in the scene graph.
     class VSG_DECLSPEC LineSegmentIntersector : public Inherit<Intersector, LineSegmentIntersector>
     {
@@ -59,6 +50,13 @@ namespace vsg
 
         ref_ptr<Intersection> add(const dvec3& coord, double ratio, const IndexRatios& indexRatios, uint32_t instanceIndex);
 
+        /// create a LineSegmentIntersector for the same line segment to intersect a subgraph in parallel,
+        /// subclasses must override to intersect subgraphs in parallel, otherwise the traversal is serial
+        ref_ptr<Intersector> createSubgraphIntersector() override;
+
+        /// append the subgraph intersections and sort all intersections by ratio so results don't depend on thread timing
+        void mergeSubgraphIntersectors(const std::vector<ref_ptr<Intersector>>& subgraphIntersectors) override;
+
         void pushTransform(const Transform& transform) override;
         void popTransform() override;
 
@@ -0,0 +1,130 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/utils/Intersector.h>
+
+namespace vsg
+{
+
+    /// MultiLineSegmentIntersector is an Intersector subclass that computes intersections between many line segments and the scene graph in a single traversal.
+    /// Bounding sphere tests narrow the set of active segments for each subgraph, transforms are inverted once for all segments,
+    /// triangles are tested against packets of 4 segments at a time and hits are recorded in flat containers that retain their capacity between traversals.
+    /// CLOSEST_HIT and ANY_HIT modes apply to each line segment, retaining at most one hit per line segment, with ANY_HIT stopping once all line segments have a hit.
+    class VSG_DECLSPEC MultiLineSegmentIntersector : public Inherit<Intersector, MultiLineSegmentIntersector>
+    {
+    public:
+        struct LineSegment
+        {
+            dvec3 start;
+            dvec3 end;
+        };
+
+        using LineSegments = std::vector<LineSegment>;
+
+        explicit MultiLineSegmentIntersector(const LineSegments& in_lineSegments = {}, ref_ptr<ArrayState> initialArrayData = {});
+
+        struct Hit
+        {
+            uint32_t lineSegmentIndex = 0;
+            uint32_t instanceIndex = 0;
+            double ratio = 0.0;
+            dvec3 localIntersection;
+            dvec3 worldIntersection;
+            uint32_t indices[3] = {0, 0, 0};
+            double indexRatios[3] = {0.0, 0.0, 0.0};
+
+            // range of the NodePath within nodePaths
+            uint32_t nodePathOffset = 0;
+            uint32_t nodePathSize = 0;
+        };
+
+        using Hits = std::vector<Hit>;
+        Hits hits;
+
+        /// node paths of all hits stored end to end, hits from the same draw command share a single node path.
+        NodePath nodePaths;
+
+        /// return the NodePath of the specified hit
+        NodePath nodePath(const Hit& hit) const;
+
+        /// assign new line segments in world coordinates, clearing any hits while retaining the capacity of containers so the intersector can be reused without allocations.
+        void reset(const LineSegments& in_lineSegments);
+
+        /// sort hits by line segment index then ratio, in CLOSEST_HIT and ANY_HIT modes only the first hit of each line segment is retained.
+        void sort();
+
+        /// create a MultiLineSegmentIntersector for the currently active line segments to intersect a subgraph in parallel,
+        /// subclasses must override to intersect subgraphs in parallel, otherwise the traversal is serial
+        ref_ptr<Intersector> createSubgraphIntersector() override;
+
+        /// append the subgraph hits and sort all hits so results don't depend on thread timing
+        void mergeSubgraphIntersectors(const std::vector<ref_ptr<Intersector>>& subgraphIntersectors) override;
+
+        const LineSegments& lineSegments() const { return _lineSegmentStack.front(); }
+
+        void pushTransform(const Transform& transform) override;
+        void popTransform() override;
+
+        /// check for intersection with sphere, narrowing the active line segments for the subgraph
+        bool intersects(const dsphere& bs) override;
+
+        bool intersectDraw(uint32_t firstVertex, uint32_t vertexCount, uint32_t firstInstance, uint32_t instanceCount) override;
+        bool intersectDrawIndexed(uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance, uint32_t instanceCount) override;
+
+    protected:
+        /// structure of arrays for up to 4 line segments in local coordinates
+        struct Packet
+        {
+            double sx[4], sy[4], sz[4];
+            double dx[4], dy[4], dz[4];
+            uint32_t lineSegmentIndex[4];
+            uint32_t count = 0;
+        };
+
+        /// range of _activeIndices that holds the line segments that intersect the bound of a node in the NodePath
+        struct ActiveLevel
+        {
+            const Node* node = nullptr;
+            size_t depth = 0;
+            size_t offset = 0;
+            size_t count = 0;
+        };
+
+        static constexpr uint32_t invalidHitIndex = 0xffffffff;
+
+        bool _active(uint32_t lineSegmentIndex, double entryRatio) const;
+        void _updateHitIndices();
+        void _popInactiveLevels();
+        void _assignPackets();
+        void _intersectTriangle(const Packet& packet, const vec3Array& vertices, uint32_t i0, uint32_t i1, uint32_t i2, uint32_t instanceIndex);
+
+        std::vector<LineSegments> _lineSegmentStack;
+        size_t _transformDepth = 0;
+
+        std::vector<uint32_t> _activeIndices;
+        std::vector<ActiveLevel> _activeLevels;
+
+        // closest hit ratio and index in hits of each line segment's hit, used by CLOSEST_HIT and ANY_HIT modes
+        std::vector<double> _closestRatios;
+        std::vector<uint32_t> _hitIndices;
+        size_t _numLineSegmentsHit = 0;
+
+        std::vector<Packet> _packets;
+        dmat4 _localToWorld;
+        uint32_t _currentNodePathOffset = 0;
+        bool _currentNodePathAssigned = false;
+    };
+    VSG_type_name(vsg::MultiLineSegmentIntersector);
+
+} // namespace vsg
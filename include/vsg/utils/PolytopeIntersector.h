@@ -0,0 +1,89 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/app/Camera.h>
+#include <vsg/utils/Intersector.h>
+
+namespace vsg
+{
+
+    /// PolytopeIntersector is an Intersector subclass that provides support for computing intersections between a convex polytope and geometry in the scene graph,
+    /// such as rubber band selection of the geometry within a region of a window or frustum queries.
+    class VSG_DECLSPEC PolytopeIntersector : public Inherit<Intersector, PolytopeIntersector>
+    {
+    public:
+        /// convex polytope defined by planes with normals pointing inwards
+        using Polytope = std::vector<dplane>;
+
+        PolytopeIntersector(const Polytope& in_polytope, ref_ptr<ArrayState> initialArrayData = {});
+
+        /// create the polytope for the window region from (xMin, yMin) to (xMax, yMax) viewed by the camera, the near plane is the first plane.
+        PolytopeIntersector(const Camera& camera, double xMin, double yMin, double xMax, double yMax, ref_ptr<ArrayState> initialArrayData = {});
+
+        class VSG_DECLSPEC Intersection : public Inherit<Object, Intersection>
+        {
+        public:
+            Intersection() {}
+            Intersection(const dvec3& in_localIntersection, const dvec3& in_worldIntersection, double in_distance, const dmat4& in_localToWorld, const NodePath& in_nodePath, const DataList& in_arrays, const IndexRatios& in_indexRatios, uint32_t in_instanceIndex);
+
+            /// center of the part of the primitive that is inside the polytope
+            dvec3 localIntersection;
+            dvec3 worldIntersection;
+
+            /// distance of worldIntersection from the first plane of the polytope, used to select the closest hit
+            double distance = 0.0;
+
+            dmat4 localToWorld;
+            NodePath nodePath;
+            DataList arrays;
+            IndexRatios indexRatios;
+            uint32_t instanceIndex = 0;
+
+            // return true if Intersection is valid
+            operator bool() const { return !nodePath.empty(); }
+        };
+
+        using Intersections = std::vector<ref_ptr<Intersection>>;
+        Intersections intersections;
+
+        ref_ptr<Intersection> add(const dvec3& coord, const IndexRatios& indexRatios, uint32_t instanceIndex);
+
+        /// create a PolytopeIntersector for the same polytope to intersect a subgraph in parallel,
+        /// subclasses must override to intersect subgraphs in parallel, otherwise the traversal is serial
+        ref_ptr<Intersector> createSubgraphIntersector() override;
+
+        /// append the subgraph intersections and sort all intersections by distance so results don't depend on thread timing
+        void mergeSubgraphIntersectors(const std::vector<ref_ptr<Intersector>>& subgraphIntersectors) override;
+
+        void pushTransform(const Transform& transform) override;
+        void popTransform() override;
+
+        /// check for intersection with sphere
+        bool intersects(const dsphere& bs) override;
+
+        bool intersectDraw(uint32_t firstVertex, uint32_t vertexCount, uint32_t firstInstance, uint32_t instanceCount) override;
+        bool intersectDrawIndexed(uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance, uint32_t instanceCount) override;
+
+    protected:
+        bool _intersectTriangle(const vec3Array& vertices, uint32_t i0, uint32_t i1, uint32_t i2, uint32_t instanceIndex);
+
+        std::vector<Polytope> _polytopeStack;
+
+        // polygons of barycentric coordinates used when clipping triangles against the polytope
+        std::vector<dvec3> _polygon;
+        std::vector<dvec3> _clippedPolygon;
+    };
+    VSG_type_name(vsg::PolytopeIntersector);
+
+} // namespace vsg
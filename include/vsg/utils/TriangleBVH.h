@@ -0,0 +1,209 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Array.h>
+#include <vsg/core/observer_ptr.h>
+#include <vsg/maths/vec3.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace vsg
+{
+
+    /// TriangleBVH is a bounding volume hierarchy over the triangles of an indexed triangle list, used to accelerate intersection testing of large meshes.
+    /// Built lazily by Intersector and cached in a TriangleBVHCache, outside of the scene graph, it is rebuilt when the vertex or index arrays are modified.
+    class VSG_DECLSPEC TriangleBVH : public Inherit<Object, TriangleBVH>
+    {
+    public:
+        TriangleBVH();
+
+        /// node of the hierarchy, leaves have count > 0 and reference triangles[first, first + count), internal nodes have their first child at the following node and second child at first.
+        struct BVHNode
+        {
+            vec3 min;
+            uint32_t first = 0;
+            vec3 max;
+            uint32_t count = 0;
+        };
+
+        std::vector<BVHNode> nodes;
+
+        /// position in the index array of the first index of each triangle, ordered so each leaf references a contiguous range.
+        std::vector<uint32_t> triangles;
+
+        /// maximum number of triangles in a leaf node
+        uint32_t maxTrianglesPerLeaf = 4;
+
+        /// build the hierarchy for the triangles in indices[firstIndex, firstIndex + indexCount)
+        void build(ref_ptr<const vec3Array> in_vertices, ref_ptr<const Data> in_indices, uint32_t in_firstIndex, uint32_t in_indexCount);
+
+        /// return true if the hierarchy was built from the specified arrays and range, and the arrays haven't been modified since.
+        bool valid(const vec3Array* in_vertices, const Data* in_indices, uint32_t in_firstIndex, uint32_t in_indexCount) const;
+
+        /// traverse the hierarchy, skipping subtrees whose bounds fail boundsTest(node), and call callback(i) with the index array position of each triangle in the leaves reached.
+        /// If callback returns bool, returning false stops the traversal.
+        template<typename B, typename F>
+        void traverse(B boundsTest, F callback) const
+        {
+            if (nodes.empty()) return;
+
+            uint32_t stack[64];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = 0;
+
+            while (stackSize > 0)
+            {
+                const BVHNode& node = nodes[stack[--stackSize]];
+                if (!boundsTest(node)) continue;
+
+                if (node.count > 0)
+                {
+                    for (uint32_t t = node.first; t < node.first + node.count; ++t)
+                    {
+                        if constexpr (std::is_same_v<std::invoke_result_t<F, uint32_t>, bool>)
+                        {
+                            if (!callback(triangles[t])) return;
+                        }
+                        else
+                        {
+                            callback(triangles[t]);
+                        }
+                    }
+                }
+                else
+                {
+                    stack[stackSize++] = node.first;
+                    stack[stackSize++] = static_cast<uint32_t>(&node - nodes.data()) + 1;
+                }
+            }
+        }
+
+        /// call callback(i) with the index array position of each triangle whose leaf bounds are crossed by the line segment from start to end.
+        template<typename F>
+        void intersect(const dvec3& start, const dvec3& end, F callback) const
+        {
+            dvec3 d = end - start;
+            dvec3 inv_d(d.x != 0.0 ? 1.0 / d.x : 0.0, d.y != 0.0 ? 1.0 / d.y : 0.0, d.z != 0.0 ? 1.0 / d.z : 0.0);
+
+            auto intersects = [&](const BVHNode& node) -> bool {
+                double tmin = 0.0, tmax = 1.0;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    if (d[axis] == 0.0)
+                    {
+                        if (start[axis] < node.min[axis] || start[axis] > node.max[axis]) return false;
+                        continue;
+                    }
+
+                    double t0 = (double(node.min[axis]) - start[axis]) * inv_d[axis];
+                    double t1 = (double(node.max[axis]) - start[axis]) * inv_d[axis];
+                    if (t0 > t1) std::swap(t0, t1);
+                    if (t0 > tmin) tmin = t0;
+                    if (t1 < tmax) tmax = t1;
+                    if (tmin > tmax) return false;
+                }
+                return true;
+            };
+
+            traverse(intersects, callback);
+        }
+
+        /// hierarchy is rebuilt on demand so isn't serialized, read/write are no-ops
+        void read(Input&) override {}
+        void write(Output&) const override {}
+
+        /// return true if the vertex or index array the hierarchy was built from has been deleted, so it can no longer be used.
+        bool orphaned() const;
+
+    protected:
+        virtual ~TriangleBVH();
+
+        // observed rather than referenced so that caching the hierarchy doesn't keep the arrays in memory
+        observer_ptr<const vec3Array> _vertices;
+        observer_ptr<const Data> _indices;
+        uint32_t _firstIndex = 0;
+        uint32_t _indexCount = 0;
+        ModifiedCount _verticesModifiedCount;
+        ModifiedCount _indicesModifiedCount;
+    };
+    VSG_type_name(vsg::TriangleBVH);
+
+    /// TriangleBVHCache maps vertex and index arrays and the range of indices drawn to the TriangleBVH built for them.
+    /// Entries are independent of the nodes that draw them, so draw commands shared between different arrays each get their own TriangleBVH,
+    /// and each entry is built under its own lock so intersections with other meshes aren't blocked while a TriangleBVH is built.
+    /// The cache doesn't keep the arrays in memory, entries are discarded by prune() once their arrays have been deleted, or least recently used first when there are more than maxEntries.
+    /// prune() is called every pruneInterval lookups.
+    class VSG_DECLSPEC TriangleBVHCache : public Inherit<Object, TriangleBVHCache>
+    {
+    public:
+        TriangleBVHCache();
+
+        /// return the TriangleBVH for the triangles in indices[firstIndex, firstIndex + indexCount), building it on first use or once the arrays have been modified.
+        ref_ptr<const TriangleBVH> getOrCreate(ref_ptr<const vec3Array> vertices, ref_ptr<const Data> indices, uint32_t firstIndex, uint32_t indexCount);
+
+        /// number of calls to getOrCreate() between each automatic prune()
+        uint32_t pruneInterval = 256;
+
+        /// maximum number of entries retained by prune()
+        size_t maxEntries = 4096;
+
+        /// discard entries whose arrays have been deleted, then the least recently used entries over maxEntries.
+        void prune();
+
+        /// discard all entries.
+        void clear();
+
+        /// return the number of entries
+        size_t size() const;
+
+        /// default TriangleBVHCache used by Intersector
+        static ref_ptr<TriangleBVHCache>& instance();
+
+    protected:
+        virtual ~TriangleBVHCache();
+
+        struct Key
+        {
+            const vec3Array* vertices = nullptr;
+            const Data* indices = nullptr;
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+
+            bool operator<(const Key& rhs) const
+            {
+                if (vertices != rhs.vertices) return std::less<const vec3Array*>()(vertices, rhs.vertices);
+                if (indices != rhs.indices) return std::less<const Data*>()(indices, rhs.indices);
+                if (firstIndex != rhs.firstIndex) return firstIndex < rhs.firstIndex;
+                return indexCount < rhs.indexCount;
+            }
+        };
+
+        struct Entry
+        {
+            std::mutex mutex;
+            ref_ptr<TriangleBVH> bvh;
+            uint64_t lastUsed = 0;
+        };
+
+        mutable std::mutex _mutex;
+        std::map<Key, std::shared_ptr<Entry>> _entries;
+        uint64_t _lookupCount = 0;
+    };
+    VSG_type_name(vsg::TriangleBVHCache);
+
+} // namespace vsg
@@ -37,6 +37,8 @@ namespace vsg
         Device* getDevice() { return _device; }
         const Device* getDevice() const { return _device; }
 
+        const uint32_t queueFamilyIndex;
+
     protected:
         virtual ~CommandPool();
 
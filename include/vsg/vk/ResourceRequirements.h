@@ -122,6 +122,7 @@ namespace vsg
         void apply(const VertexIndexDraw& vid) override;
         void apply(const BindVertexBuffers& bvb) override;
         void apply(const BindIndexBuffer& bib) override;
+        void apply(const DrawIndexedIndirect& dii) override;
 
         inline void apply(ref_ptr<BufferInfo> bufferInfo)
         {
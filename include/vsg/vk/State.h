@@ -19,6 +19,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/vk/CommandBuffer.h>
 
 #include <array>
+#include <atomic>
+#include <bitset>
 #include <map>
 #include <stack>
 
@@ -80,6 +82,7 @@ namespace vsg
         {
             // make sure there is an initial matrix
             matrixStack.emplace(mat4());
+            idStack.emplace(nextID++);
             dirty = true;
         }
 
@@ -89,10 +92,17 @@ namespace vsg
         uint32_t offset = 0;
         bool dirty = false;
 
+        /// identifiers of the matrices on the stack, each matrix pushed or set is given a new identifier so that users
+        /// can detect that two entries share the same matrix without comparing the matrix values.
+        std::stack<uint64_t> idStack;
+        uint64_t nextID = 1;
+
         inline void set(const mat4& matrix)
         {
             matrixStack = {};
             matrixStack.emplace(matrix);
+            idStack = {};
+            idStack.emplace(nextID++);
             dirty = true;
         }
 
@@ -100,36 +110,46 @@ namespace vsg
         {
             matrixStack = {};
             matrixStack.emplace(matrix);
+            idStack = {};
+            idStack.emplace(nextID++);
             dirty = true;
         }
 
         inline void push(const mat4& matrix)
         {
             matrixStack.emplace(matrix);
+            idStack.emplace(nextID++);
             dirty = true;
         }
         inline void push(const dmat4& matrix)
         {
             matrixStack.emplace(matrix);
+            idStack.emplace(nextID++);
             dirty = true;
         }
         inline void push(const Transform& transform)
         {
             matrixStack.emplace(transform.transform(matrixStack.top()));
+            idStack.emplace(nextID++);
             dirty = true;
         }
 
         inline void push(const MatrixTransform& transform)
         {
             matrixStack.emplace(matrixStack.top() * transform.matrix);
+            idStack.emplace(nextID++);
             dirty = true;
         }
 
         const dmat4& top() const { return matrixStack.top(); }
 
+        /// identifier of the top matrix, unique within this MatrixStack
+        uint64_t topID() const { return idStack.top(); }
+
         inline void pop()
         {
             matrixStack.pop();
+            idStack.pop();
             dirty = true;
         }
 
@@ -207,6 +227,31 @@ namespace vsg
                          mv[3][2] * inv_scale);
         }
 
+        /// test the sphere against the planes in planeMask, starting with planeHint and cycling through the rest. On rejection planeHint is set to the rejecting plane,
+        /// otherwise planes that the sphere is wholly inside are removed from planeMask as they don't need to be tested for bounds contained within the sphere.
+        template<typename T>
+        bool intersect(const t_sphere<T>& s, uint32_t& planeMask, uint32_t& planeHint, uint32_t& numPlaneTests) const
+        {
+            auto negative_radius = -s.radius;
+            uint32_t plane = planeHint < POLYTOPE_SIZE ? planeHint : 0;
+            uint32_t mask = planeMask;
+            for (uint32_t n = 0; n < POLYTOPE_SIZE; ++n, plane = (plane + 1) % POLYTOPE_SIZE)
+            {
+                if ((mask & (1u << plane)) == 0) continue;
+
+                ++numPlaneTests;
+                auto d = distance(face[plane], s.center);
+                if (d < negative_radius)
+                {
+                    planeHint = plane;
+                    return false;
+                }
+                if (d >= s.radius) mask &= ~(1u << plane);
+            }
+            planeMask = mask;
+            return true;
+        }
+
         template<typename T>
         bool intersect(const t_sphere<T>& s) const
         {
@@ -221,6 +266,26 @@ namespace vsg
                 if (distance(face[5], s.center) < negative_radius) return false;
             return true;
         }
+
+        /// test count spheres, with centers and radii held in separate arrays, against the frustum, setting visible[i] to 1 if sphere i intersects the frustum and 0 if it's outside.
+        /// The loops are free of branches so the compiler can vectorize them to test 4 or 8 spheres at a time.
+        template<typename T>
+        void intersect(const T* x, const T* y, const T* z, const T* radius, size_t count, uint8_t* visible) const
+        {
+            for (size_t i = 0; i < count; ++i) visible[i] = 1;
+
+            for (int p = 0; p < POLYTOPE_SIZE; ++p)
+            {
+                const T nx = static_cast<T>(face[p].n.x);
+                const T ny = static_cast<T>(face[p].n.y);
+                const T nz = static_cast<T>(face[p].n.z);
+                const T d = static_cast<T>(face[p].p);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    visible[i] &= static_cast<uint8_t>((nx * x[i] + ny * y[i] + nz * z[i] + d) >= -radius[i]);
+                }
+            }
+        }
     };
 
     /// vsg::State is used by vsg::RecordTraversal to manage state stacks, projection and modelview matrices and frustum stacks.
@@ -244,8 +309,26 @@ namespace vsg
         using FrustumStack = std::stack<Frustum>;
         FrustumStack _frustumStack;
 
+        /// when prefetch is true a second frustum stack is maintained for the view predicted by the DatabasePager's prefetching,
+        /// _predictionMatrix maps from the current view's eye coords to the predicted view's eye coords.
+        bool prefetch = false;
+        dmat4 _predictionMatrix;
+        FrustumStack _predictedFrustumStack;
+
         bool dirty;
 
+        /// when coherentCulling is true the frustum plane that culled a CullGroup, CullNode, LOD or PagedLOD's bound in a previous frame is tested first,
+        /// and planes that a bound is wholly inside aren't tested for the bounds in its subgraph, which requires bounds to contain the bounds of their subgraph.
+        bool coherentCulling = false;
+
+        /// planes of the frustum still to be tested in the current subgraph when coherentCulling is enabled
+        static constexpr uint32_t allPlanesMask = (1u << POLYTOPE_SIZE) - 1;
+        uint32_t planeMask = allPlanesMask;
+
+        /// number of sphere against plane tests done and skipped by coherent culling
+        uint64_t numPlaneTests = 0;
+        uint64_t numPlaneTestsSkipped = 0;
+
         StateStacks stateStacks;
 
         MatrixStack projectionMatrixStack{0};
@@ -261,8 +344,11 @@ namespace vsg
 
             modelviewMatrixStack.set(viewMatrix);
 
-            // clear frustum stack
+            planeMask = allPlanesMask;
+
+            // clear frustum stacks
             while (!_frustumStack.empty()) _frustumStack.pop();
+            while (!_predictedFrustumStack.empty()) _predictedFrustumStack.pop();
 
             // push frustum in world coords
             pushFrustum();
@@ -288,17 +374,32 @@ namespace vsg
         {
             _frustumStack.push(Frustum(_frustumProjected, modelviewMatrixStack.top()));
             _frustumStack.top().computeLodScale(projectionMatrixStack.top(), modelviewMatrixStack.top());
+
+            if (prefetch)
+            {
+                auto predicted_mv = _predictionMatrix * modelviewMatrixStack.top();
+                _predictedFrustumStack.push(Frustum(_frustumProjected, predicted_mv));
+                _predictedFrustumStack.top().computeLodScale(projectionMatrixStack.top(), predicted_mv);
+            }
         }
 
         inline void applyFrustum()
         {
             _frustumStack.top().set(_frustumProjected, modelviewMatrixStack.top());
             _frustumStack.top().computeLodScale(projectionMatrixStack.top(), modelviewMatrixStack.top());
+
+            if (prefetch)
+            {
+                auto predicted_mv = _predictionMatrix * modelviewMatrixStack.top();
+                _predictedFrustumStack.top().set(_frustumProjected, predicted_mv);
+                _predictedFrustumStack.top().computeLodScale(projectionMatrixStack.top(), predicted_mv);
+            }
         }
 
         inline void popFrustum()
         {
             _frustumStack.pop();
+            if (prefetch) _predictedFrustumStack.pop();
         }
 
         template<typename T>
@@ -307,6 +408,30 @@ namespace vsg
             return _frustumStack.top().intersect(s);
         }
 
+        /// intersect a batch of spheres held in separate arrays with the current frustum, see Frustum::intersect.
+        template<typename T>
+        void intersect(const T* x, const T* y, const T* z, const T* radius, size_t count, uint8_t* visible) const
+        {
+            _frustumStack.top().intersect(x, y, z, radius, count, visible);
+        }
+
+        /// intersect the sphere with the current frustum, using and updating the planeHint and planeMask when coherentCulling is enabled.
+        template<typename T>
+        bool intersect(const t_sphere<T>& s, std::atomic_uint8_t& planeHint)
+        {
+            if (!coherentCulling) return _frustumStack.top().intersect(s);
+
+            uint32_t hint = planeHint.load(std::memory_order_relaxed);
+            uint32_t numTests = 0;
+            numPlaneTestsSkipped += POLYTOPE_SIZE - static_cast<uint32_t>(std::bitset<POLYTOPE_SIZE>(planeMask).count());
+
+            bool result = _frustumStack.top().intersect(s, planeMask, hint, numTests);
+            numPlaneTests += numTests;
+
+            if (!result) planeHint.store(static_cast<uint8_t>(hint), std::memory_order_relaxed);
+            return result;
+        }
+
         template<typename T>
         T lodDistance(const t_sphere<T>& s) const
         {
@@ -316,6 +441,27 @@ namespace vsg
             const auto& lodScale = frustum.lodScale;
             return std::abs(lodScale[0] * s.x + lodScale[1] * s.y + lodScale[2] * s.z + lodScale[3]);
         }
+
+        /// return the lod distance of the sphere, or -1.0 if it's outside the frustum, using and updating the planeHint and planeMask when coherentCulling is enabled.
+        template<typename T>
+        T lodDistance(const t_sphere<T>& s, std::atomic_uint8_t& planeHint)
+        {
+            if (!intersect(s, planeHint)) return -1.0;
+
+            const auto& lodScale = _frustumStack.top().lodScale;
+            return std::abs(lodScale[0] * s.x + lodScale[1] * s.y + lodScale[2] * s.z + lodScale[3]);
+        }
+
+        /// return the lod distance of the sphere in the predicted view, or -1.0 if it's outside the predicted frustum. Only valid when prefetch is true.
+        template<typename T>
+        T predictedLodDistance(const t_sphere<T>& s) const
+        {
+            const auto& frustum = _predictedFrustumStack.top();
+            if (!frustum.intersect(s)) return -1.0;
+
+            const auto& lodScale = frustum.lodScale;
+            return std::abs(lodScale[0] * s.x + lodScale[1] * s.y + lodScale[2] * s.z + lodScale[3]);
+        }
     };
 
 } // namespace vsg
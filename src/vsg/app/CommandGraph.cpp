@@ -69,7 +69,10 @@ void CommandGraph::record(CommandBuffers& recordedCommandBuffers, ref_ptr<FrameS
 
     recordTraversal->setFrameStamp(frameStamp);
     recordTraversal->setDatabasePager(databasePager);
+    recordTraversal->setFrameArena(frameArena);
     recordTraversal->clearBins();
+    recordTraversal->recordThreads = recordThreads;
+    recordTraversal->secondaryCommandBuffers.clear();
 
     ref_ptr<CommandBuffer> commandBuffer;
     for (auto& cb : _commandBuffers)
@@ -116,6 +119,10 @@ void CommandGraph::record(CommandBuffers& recordedCommandBuffers, ref_ptr<FrameS
 
     vkEndCommandBuffer(vk_commandBuffer);
 
+    // secondary command buffers recorded for Views are retained along with the primary command buffer until the submission completes
+    recordedCommandBuffers.insert(recordedCommandBuffers.end(), recordTraversal->secondaryCommandBuffers.begin(), recordTraversal->secondaryCommandBuffers.end());
+    recordTraversal->secondaryCommandBuffers.clear();
+
     recordedCommandBuffers.push_back(commandBuffer);
 }
 
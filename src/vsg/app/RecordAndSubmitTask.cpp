@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <vsg/app/RecordAndSubmitTask.h>
 #include <vsg/app/View.h>
+#include <vsg/core/Allocator.h>
 #include <vsg/io/Logger.h>
 #include <vsg/ui/ApplicationEvent.h>
 #include <vsg/vk/State.h>
@@ -103,6 +104,10 @@ VkResult RecordAndSubmitTask::start()
 
         current_fence->resetFenceAndDependencies();
     }
+
+    // transient allocations are only used until the previous frame's submission so can be released
+    frameArena.reset();
+
     return VK_SUCCESS;
 }
 
@@ -110,6 +115,7 @@ VkResult RecordAndSubmitTask::record(CommandBuffers& recordedCommandBuffers, ref
 {
     for (auto& commandGraph : commandGraphs)
     {
+        commandGraph->frameArena = &frameArena;
         commandGraph->record(recordedCommandBuffers, frameStamp, databasePager);
     }
 
@@ -131,10 +137,11 @@ VkResult RecordAndSubmitTask::finish(CommandBuffers& recordedCommandBuffers)
     }
 
     // convert VSG CommandBuffer to Vulkan handles and add to the Fence's list of dependent CommandBuffers
-    std::vector<VkCommandBuffer> vk_commandBuffers;
-    std::vector<VkSemaphore> vk_waitSemaphores;
-    std::vector<VkPipelineStageFlags> vk_waitStages;
-    std::vector<VkSemaphore> vk_signalSemaphores;
+    // the Vulkan handles are only required until the submission so can use the FrameArena.
+    std::vector<VkCommandBuffer, allocator_frame_arena<VkCommandBuffer>> vk_commandBuffers{allocator_frame_arena<VkCommandBuffer>(frameArena)};
+    std::vector<VkSemaphore, allocator_frame_arena<VkSemaphore>> vk_waitSemaphores{allocator_frame_arena<VkSemaphore>(frameArena)};
+    std::vector<VkPipelineStageFlags, allocator_frame_arena<VkPipelineStageFlags>> vk_waitStages{allocator_frame_arena<VkPipelineStageFlags>(frameArena)};
+    std::vector<VkSemaphore, allocator_frame_arena<VkSemaphore>> vk_signalSemaphores{allocator_frame_arena<VkSemaphore>(frameArena)};
 
     auto current_fence = fence();
 
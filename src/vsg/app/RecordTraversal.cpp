@@ -14,6 +14,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/app/View.h>
 #include <vsg/commands/Command.h>
 #include <vsg/commands/Commands.h>
+#include <vsg/commands/NextSubPass.h>
 #include <vsg/io/DatabasePager.h>
 #include <vsg/io/Logger.h>
 #include <vsg/io/Options.h>
@@ -31,6 +32,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/nodes/QuadGroup.h>
 #include <vsg/nodes/StateGroup.h>
 #include <vsg/nodes/Switch.h>
+#include <vsg/threading/TaskGroup.h>
 #include <vsg/threading/atomics.h>
 #include <vsg/ui/ApplicationEvent.h>
 #include <vsg/vk/CommandBuffer.h>
@@ -41,9 +43,160 @@ using namespace vsg;
 
 #define INLINE_TRAVERSE 0
 
+struct RecordTraversal::SubgraphRecord : public Object
+{
+    ref_ptr<RecordTraversal> recordTraversal;
+    ref_ptr<CulledPagedLODs> culledPagedLODs;
+    ref_ptr<ViewDependentState> viewDependentState;
+    std::vector<ref_ptr<Bin>> bins;
+
+    std::vector<ref_ptr<CommandBuffer>> commandBuffers;
+    ref_ptr<CommandBuffer> commandBuffer;
+
+    const ref_ptr<Node>* first = nullptr;
+    const ref_ptr<Node>* last = nullptr;
+
+    // set up the RecordTraversal to continue from the parent's state and begin a secondary command buffer that inherits the parent's render pass
+    void begin(RecordTraversal& parent, const View& view)
+    {
+        auto parentState = parent._state;
+        auto parentCommandBuffer = parentState->_commandBuffer;
+
+        if (!recordTraversal) recordTraversal = RecordTraversal::create(nullptr, static_cast<uint32_t>(parentState->stateStacks.size() - 1));
+
+        auto& rt = *recordTraversal;
+        rt.traversalMask = parent.traversalMask;
+        rt.overrideMask = parent.overrideMask;
+        rt.setFrameStamp(parent._frameStamp);
+        rt.setDatabasePager(parent._databasePager);
+        rt.setFrameArena(parent._frameArena);
+
+        // collect culled PagedLODs locally as the DatabasePager's containers aren't thread safe, merged into the parent's once recording has completed
+        if (rt._culledPagedLODs) rt._culledPagedLODs->unref();
+        rt._culledPagedLODs = nullptr;
+        if (parent._culledPagedLODs)
+        {
+            if (!culledPagedLODs) culledPagedLODs = CulledPagedLODs::create();
+            culledPagedLODs->clear();
+            rt._culledPagedLODs = culledPagedLODs.get();
+            rt._culledPagedLODs->ref();
+        }
+
+        // local bins matching the parent's bins
+        bins.resize(parent._bins.size());
+        for (size_t i = 0; i < bins.size(); ++i)
+        {
+            auto& parentBin = parent._bins[i];
+            auto& bin = bins[i];
+            if (!parentBin)
+                bin = {};
+            else if (!bin || bin->binNumber != parentBin->binNumber || bin->sortOrder != parentBin->sortOrder)
+                bin = Bin::create(parentBin->binNumber, parentBin->sortOrder);
+            else
+                bin->clear();
+        }
+        rt._minimumBinNumber = parent._minimumBinNumber;
+        rt._bins.assign(bins.begin(), bins.end());
+
+        // local lights, merged into the View's ViewDependentState once recording has completed
+        if (view.viewDependentState)
+        {
+            if (!viewDependentState) viewDependentState = ViewDependentState::create(0, 0);
+            viewDependentState->clear();
+            rt._viewDependentState = viewDependentState;
+        }
+        else
+        {
+            rt._viewDependentState = {};
+        }
+
+        // secondary command buffers don't inherit state so the parent's state stacks are recorded again
+        auto state = rt._state;
+        state->stateStacks = parentState->stateStacks;
+        for (auto& stateStack : state->stateStacks) stateStack.dirty = stateStack.size() > 0;
+        state->prefetch = parentState->prefetch;
+        state->coherentCulling = parentState->coherentCulling;
+        state->_predictionMatrix = parentState->_predictionMatrix;
+        state->setProjectionAndViewMatrix(parentState->projectionMatrixStack.top(), parentState->modelviewMatrixStack.top());
+        state->dirty = true;
+
+        commandBuffer = {};
+        for (auto& cb : commandBuffers)
+        {
+            if (cb->numDependentSubmissions() == 0)
+            {
+                commandBuffer = cb;
+                break;
+            }
+        }
+        if (!commandBuffer)
+        {
+            // CommandBuffer::reset() resets its whole CommandPool, so like CommandGraph each CommandBuffer has its own CommandPool to avoid resetting ones still in flight
+            auto commandPool = CommandPool::create(parentCommandBuffer->getDevice(), parentCommandBuffer->getCommandPool()->queueFamilyIndex);
+            commandBuffer = commandPool->allocate(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            commandBuffers.push_back(commandBuffer);
+        }
+        else
+        {
+            commandBuffer->reset();
+        }
+
+        commandBuffer->numDependentSubmissions().fetch_add(1);
+        commandBuffer->viewID = parentCommandBuffer->viewID;
+        commandBuffer->traversalMask = parentCommandBuffer->traversalMask;
+        commandBuffer->overrideMask = parentCommandBuffer->overrideMask;
+        commandBuffer->viewDependentState = parentCommandBuffer->viewDependentState;
+
+        state->_commandBuffer = commandBuffer;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &parent._inheritanceInfo;
+
+        vkBeginCommandBuffer(*commandBuffer, &beginInfo);
+    }
+
+    void end(RecordTraversal& parent)
+    {
+        vkEndCommandBuffer(*commandBuffer);
+
+        auto state = recordTraversal->_state;
+        parent._state->numPlaneTests += state->numPlaneTests;
+        parent._state->numPlaneTestsSkipped += state->numPlaneTestsSkipped;
+        state->numPlaneTests = 0;
+        state->numPlaneTestsSkipped = 0;
+
+        parent.secondaryCommandBuffers.push_back(commandBuffer);
+    }
+};
+
+struct RecordSubgraphs : public Operation
+{
+    RecordSubgraphs(RecordTraversal& in_recordTraversal, const ref_ptr<Node>* in_first, const ref_ptr<Node>* in_last) :
+        recordTraversal(in_recordTraversal),
+        first(in_first),
+        last(in_last) {}
+
+    void run() override
+    {
+        for (auto itr = first; itr != last; ++itr)
+        {
+            (*itr)->accept(recordTraversal);
+        }
+    }
+
+    RecordTraversal& recordTraversal;
+    const ref_ptr<Node>* first;
+    const ref_ptr<Node>* last;
+};
+
 RecordTraversal::RecordTraversal(CommandBuffer* in_commandBuffer, uint32_t in_maxSlot, std::set<Bin*> in_bins) :
     _state(new State(in_commandBuffer, in_maxSlot))
 {
+    _inheritanceInfo = {};
+    _inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
     if (_frameStamp) _frameStamp->ref();
     if (_state) _state->ref();
 
@@ -108,9 +261,109 @@ void RecordTraversal::setDatabasePager(DatabasePager* dp)
 
 void RecordTraversal::setProjectionAndViewMatrix(const dmat4& projMatrix, const dmat4& viewMatrix)
 {
+    _state->prefetch = _databasePager && _databasePager->prefetch && _frameStamp;
+    if (_state->prefetch)
+    {
+        _state->_predictionMatrix = predictViewMatrix(viewMatrix) * inverse(viewMatrix);
+    }
+
     _state->setProjectionAndViewMatrix(projMatrix, viewMatrix);
 }
 
+dmat4 RecordTraversal::predictViewMatrix(const dmat4& viewMatrix)
+{
+    auto& motion = _viewMotions[_state->_commandBuffer->viewID];
+    if (motion.frameCount != _frameStamp->frameCount || motion.numFrames == 0)
+    {
+        dvec3 translation, scale;
+        dquat rotation;
+        if (!decompose(inverse(viewMatrix), translation, rotation, scale))
+        {
+            motion.numFrames = 0;
+            return viewMatrix;
+        }
+
+        double time = std::chrono::duration<double>(_frameStamp->time.time_since_epoch()).count();
+        double dt = time - motion.time;
+        if (motion.numFrames > 0 && dt > 0.0)
+        {
+            // velocity and angular rate over the last frame, taking the shortest path between the two orientations
+            auto delta = rotation * conjugate(motion.rotation);
+            if (delta.w < 0.0) delta = delta * -1.0;
+
+            dvec3 axis(delta.x, delta.y, delta.z);
+            double sin_half_angle = length(axis);
+            dvec3 angularVelocity;
+            if (sin_half_angle > 0.0) angularVelocity = axis * (2.0 * std::atan2(sin_half_angle, delta.w) / (sin_half_angle * dt));
+
+            dvec3 velocity = (translation - motion.translation) / dt;
+
+            // exponentially smooth the velocities so that per frame jitter isn't magnified by the extrapolation
+            double s = (motion.numFrames == 1) ? 1.0 : _databasePager->prefetchSmoothing;
+            motion.velocity = mix(motion.velocity, velocity, s);
+            motion.angularVelocity = mix(motion.angularVelocity, angularVelocity, s);
+        }
+
+        motion.translation = translation;
+        motion.rotation = rotation;
+        motion.scale = scale;
+        motion.time = time;
+        motion.frameCount = _frameStamp->frameCount;
+        ++motion.numFrames;
+    }
+
+    if (motion.numFrames < 2) return viewMatrix;
+
+    // extrapolate the camera prefetchTime ahead at its smoothed velocities, clamping the angle and distance moved
+    double prefetchTime = _databasePager->prefetchTime;
+
+    auto offset = motion.velocity * prefetchTime;
+    double distance = length(offset);
+    if (distance > _databasePager->prefetchMaxDistance) offset *= (_databasePager->prefetchMaxDistance / distance);
+
+    auto predicted_rotation = motion.rotation;
+    double angularRate = length(motion.angularVelocity);
+    if (angularRate > 0.0)
+    {
+        double angle = std::min(angularRate * prefetchTime, _databasePager->prefetchMaxAngle);
+        predicted_rotation = dquat(angle, motion.angularVelocity / angularRate) * motion.rotation;
+    }
+
+    return inverse(vsg::translate(motion.translation + offset) * vsg::rotate(predicted_rotation) * vsg::scale(motion.scale));
+}
+
+void RecordTraversal::requestPrefetch(const PagedLOD& plod)
+{
+    const auto& child = plod.children[0];
+    if (child.node) return;
+
+    // check if the high res child will be visible in the predicted view
+    const auto& sphere = plod.bound;
+    auto lodDistance = _state->predictedLodDistance(sphere);
+    if (lodDistance < 0.0) return;
+
+    auto cutoff = lodDistance * child.minimumScreenHeightRatio;
+    if (sphere.r <= cutoff) return;
+
+    plod.frameHighResLastPredicted.exchange(_frameStamp->frameCount);
+
+    auto priority = _databasePager->prefetchPriorityScale * sphere.r / cutoff;
+    exchange_if_greater(plod.priority, priority);
+
+    if (plod.requestCount.fetch_add(1) == 0)
+    {
+        ++_databasePager->numPrefetchRequests;
+        _databasePager->request(ref_ptr<PagedLOD>(const_cast<PagedLOD*>(&plod)));
+    }
+}
+
+void RecordTraversal::setRenderPassInheritance(VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer)
+{
+    _inheritanceInfo.renderPass = renderPass;
+    _inheritanceInfo.subpass = subpass;
+    _inheritanceInfo.framebuffer = framebuffer;
+}
+
 void RecordTraversal::clearBins()
 {
     for (auto& bin : _bins)
@@ -148,33 +401,41 @@ void RecordTraversal::apply(const QuadGroup& quadGroup)
 void RecordTraversal::apply(const LOD& lod)
 {
     const auto& sphere = lod.bound;
+    auto planeMask = _state->planeMask;
 
     // check if lod bounding sphere is in view frustum.
-    auto lodDistance = _state->lodDistance(sphere);
-    if (lodDistance < 0.0)
+    auto lodDistance = _state->lodDistance(sphere, lod.cullingPlaneHint);
+    if (lodDistance >= 0.0)
     {
-        return;
-    }
-
-    for (auto& child : lod.children)
-    {
-        auto cutoff = lodDistance * child.minimumScreenHeightRatio;
-        bool child_visible = sphere.r > cutoff;
-        if (child_visible)
+        for (auto& child : lod.children)
         {
-            child.node->accept(*this);
-            return;
+            auto cutoff = lodDistance * child.minimumScreenHeightRatio;
+            bool child_visible = sphere.r > cutoff;
+            if (child_visible)
+            {
+                child.node->accept(*this);
+                break;
+            }
         }
     }
+
+    _state->planeMask = planeMask;
 }
 
 void RecordTraversal::apply(const PagedLOD& plod)
+{
+    auto planeMask = _state->planeMask;
+    traversePagedLOD(plod);
+    _state->planeMask = planeMask;
+}
+
+void RecordTraversal::traversePagedLOD(const PagedLOD& plod)
 {
     const auto& sphere = plod.bound;
     auto frameCount = _frameStamp->frameCount;
 
     // check if lod bounding sphere is in view frustum.
-    auto lodDistance = _state->lodDistance(sphere);
+    auto lodDistance = _state->lodDistance(sphere, plod.cullingPlaneHint);
     if (lodDistance < 0.0)
     {
         if ((frameCount - plod.frameHighResLastUsed) > 1 && _culledPagedLODs)
@@ -182,9 +443,13 @@ void RecordTraversal::apply(const PagedLOD& plod)
             _culledPagedLODs->highresCulled.emplace_back(&plod);
         }
 
+        if (_state->prefetch) requestPrefetch(plod);
+
         return;
     }
 
+    plod.lastLodDistance.store(lodDistance, std::memory_order_relaxed);
+
     // check the high res child to see if it's visible
     {
         const auto& child = plod.children[0];
@@ -194,9 +459,18 @@ void RecordTraversal::apply(const PagedLOD& plod)
         if (child_visible)
         {
             auto previousHighResUsed = plod.frameHighResLastUsed.exchange(frameCount);
-            if (_culledPagedLODs && ((frameCount - previousHighResUsed) > 1))
+            if ((frameCount - previousHighResUsed) > 1)
             {
-                _culledPagedLODs->newHighresRequired.emplace_back(&plod);
+                if (_culledPagedLODs) _culledPagedLODs->newHighresRequired.emplace_back(&plod);
+
+                // record whether the high res child was ready when it became visible
+                if (_databasePager)
+                {
+                    if (child.node)
+                        ++_databasePager->numHighResHits;
+                    else
+                        ++_databasePager->numHighResMisses;
+                }
             }
 
             if (child.node)
@@ -228,6 +502,8 @@ void RecordTraversal::apply(const PagedLOD& plod)
             {
                 _culledPagedLODs->highresCulled.emplace_back(&plod);
             }
+
+            if (_state->prefetch) requestPrefetch(plod);
         }
     }
 
@@ -248,20 +524,24 @@ void RecordTraversal::apply(const PagedLOD& plod)
 
 void RecordTraversal::apply(const CullGroup& cullGroup)
 {
-    if (_state->intersect(cullGroup.bound))
+    auto planeMask = _state->planeMask;
+    if (_state->intersect(cullGroup.bound, cullGroup.cullingPlaneHint))
     {
         // debug("Passed node");
         cullGroup.traverse(*this);
     }
+    _state->planeMask = planeMask;
 }
 
 void RecordTraversal::apply(const CullNode& cullNode)
 {
-    if (_state->intersect(cullNode.bound))
+    auto planeMask = _state->planeMask;
+    if (_state->intersect(cullNode.bound, cullNode.cullingPlaneHint))
     {
         //debug("Passed node");
         cullNode.traverse(*this);
     }
+    _state->planeMask = planeMask;
 }
 
 void RecordTraversal::apply(const DepthSorted& depthSorted)
@@ -392,6 +672,20 @@ void RecordTraversal::apply(const Command& command)
     command.record(*(_state->_commandBuffer));
 }
 
+void RecordTraversal::apply(const NextSubPass& nextSubPass)
+{
+    if (_inheritanceInfo.renderPass != VK_NULL_HANDLE && _state->_commandBuffer->level() == VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+    {
+        // subsequent Views are recorded to secondary command buffers for the next subpass
+        ++_inheritanceInfo.subpass;
+        vkCmdNextSubpass(*(_state->_commandBuffer), VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    }
+    else
+    {
+        nextSubPass.record(*(_state->_commandBuffer));
+    }
+}
+
 void RecordTraversal::apply(const View& view)
 {
     // note, View::accept() updates the RecordTraversal's traversalMask
@@ -402,7 +696,8 @@ void RecordTraversal::apply(const View& view)
 
     // cache the previous bins
     int32_t cached_minimumBinNumber = _minimumBinNumber;
-    decltype(_bins) cached_bins;
+    // the View's bins are only required during this traversal so use the FrameArena when available
+    Bins cached_bins{allocator_frame_arena<ref_ptr<Bin>>(_frameArena)};
     cached_bins.swap(_bins);
     auto cached_viewDependentState = _viewDependentState;
 
@@ -453,17 +748,20 @@ void RecordTraversal::apply(const View& view)
                 }
             }
         }
+    }
 
-        view.traverse(*this);
+    if (_inheritanceInfo.renderPass != VK_NULL_HANDLE && _state->_commandBuffer->level() == VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+    {
+        recordSecondaryCommandBuffers(view);
     }
     else
     {
         view.traverse(*this);
-    }
 
-    for (auto& bin : view.bins)
-    {
-        bin->accept(*this);
+        for (auto& bin : view.bins)
+        {
+            bin->accept(*this);
+        }
     }
 
     if (_viewDependentState)
@@ -477,3 +775,91 @@ void RecordTraversal::apply(const View& view)
     _state->_commandBuffer->traversalMask = cached_traversalMask;
     _viewDependentState = cached_viewDependentState;
 }
+
+void RecordTraversal::recordSecondaryCommandBuffers(const View& view)
+{
+    // partition the View's children into contiguous ranges so that merged bins and the order of the secondary command buffers match a serial traversal
+    size_t numChildren = view.children.size();
+    size_t numPartitions = 1;
+    if (recordThreads && numChildren >= std::max(minimumChildrenForParallelRecord, 2u))
+    {
+        numPartitions = std::min(numChildren, recordThreads->threads.size() + 1);
+    }
+
+    // an extra SubgraphRecord is used to record the bins
+    while (_subgraphRecords.size() < numPartitions + 1) _subgraphRecords.emplace_back(new SubgraphRecord);
+
+    const ref_ptr<Node>* children = view.children.data();
+    for (size_t p = 0; p < numPartitions; ++p)
+    {
+        auto& subgraphRecord = *_subgraphRecords[p];
+        subgraphRecord.first = children + (numChildren * p) / numPartitions;
+        subgraphRecord.last = children + (numChildren * (p + 1)) / numPartitions;
+        subgraphRecord.begin(*this, view);
+    }
+
+    if (numPartitions > 1)
+    {
+        auto taskGroup = TaskGroup::create(recordThreads);
+        for (size_t p = 0; p < numPartitions; ++p)
+        {
+            auto& subgraphRecord = *_subgraphRecords[p];
+            taskGroup->run(ref_ptr<Operation>(new RecordSubgraphs(*subgraphRecord.recordTraversal, subgraphRecord.first, subgraphRecord.last)));
+        }
+        taskGroup->wait();
+    }
+    else
+    {
+        auto& subgraphRecord = *_subgraphRecords[0];
+        for (auto itr = subgraphRecord.first; itr != subgraphRecord.last; ++itr)
+        {
+            (*itr)->accept(*subgraphRecord.recordTraversal);
+        }
+    }
+
+    std::vector<VkCommandBuffer, allocator_frame_arena<VkCommandBuffer>> vk_commandBuffers{allocator_frame_arena<VkCommandBuffer>(_frameArena)};
+
+    // merge the results of each partition in order
+    for (size_t p = 0; p < numPartitions; ++p)
+    {
+        auto& subgraphRecord = *_subgraphRecords[p];
+        subgraphRecord.end(*this);
+        vk_commandBuffers.push_back(*subgraphRecord.commandBuffer);
+
+        if (_culledPagedLODs && subgraphRecord.culledPagedLODs)
+        {
+            auto& culled = *subgraphRecord.culledPagedLODs;
+            _culledPagedLODs->highresCulled.insert(_culledPagedLODs->highresCulled.end(), culled.highresCulled.begin(), culled.highresCulled.end());
+            _culledPagedLODs->newHighresRequired.insert(_culledPagedLODs->newHighresRequired.end(), culled.newHighresRequired.begin(), culled.newHighresRequired.end());
+        }
+
+        if (_viewDependentState && subgraphRecord.viewDependentState)
+        {
+            auto& vds = *subgraphRecord.viewDependentState;
+            _viewDependentState->ambientLights.insert(_viewDependentState->ambientLights.end(), vds.ambientLights.begin(), vds.ambientLights.end());
+            _viewDependentState->directionalLights.insert(_viewDependentState->directionalLights.end(), vds.directionalLights.begin(), vds.directionalLights.end());
+            _viewDependentState->pointLights.insert(_viewDependentState->pointLights.end(), vds.pointLights.begin(), vds.pointLights.end());
+            _viewDependentState->spotLights.insert(_viewDependentState->spotLights.end(), vds.spotLights.begin(), vds.spotLights.end());
+        }
+
+        for (size_t i = 0; i < _bins.size(); ++i)
+        {
+            if (_bins[i] && subgraphRecord.bins[i]) _bins[i]->merge(*subgraphRecord.bins[i]);
+        }
+    }
+
+    // record the merged bins after the subgraphs
+    if (!view.bins.empty())
+    {
+        auto& binRecord = *_subgraphRecords[numPartitions];
+        binRecord.begin(*this, view);
+        for (auto& bin : view.bins)
+        {
+            bin->accept(*binRecord.recordTraversal);
+        }
+        binRecord.end(*this);
+        vk_commandBuffers.push_back(*binRecord.commandBuffer);
+    }
+
+    vkCmdExecuteCommands(*_state->_commandBuffer, static_cast<uint32_t>(vk_commandBuffers.size()), vk_commandBuffers.data());
+}
@@ -12,10 +12,12 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <vsg/app/RenderGraph.h>
 #include <vsg/app/View.h>
+#include <vsg/commands/NextSubPass.h>
 #include <vsg/io/Logger.h>
 #include <vsg/io/Options.h>
 #include <vsg/nodes/Bin.h>
 #include <vsg/state/MultisampleState.h>
+#include <vsg/threading/OperationThreads.h>
 #include <vsg/vk/Context.h>
 #include <vsg/vk/State.h>
 
@@ -139,12 +141,24 @@ void RenderGraph::accept(RecordTraversal& recordTraversal) const
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
+    // when recording in parallel the Views record their subgraphs to secondary command buffers that continue this render pass,
+    // only possible when all the children are Views or NextSubPass, otherwise fall back to recording inline
+    bool recordSecondary = recordTraversal.recordThreads.valid() && contents == VK_SUBPASS_CONTENTS_INLINE;
+    for (auto itr = children.begin(); recordSecondary && itr != children.end(); ++itr)
+    {
+        recordSecondary = !*itr || (*itr)->cast<View>() || (*itr)->cast<NextSubPass>();
+    }
+
     VkCommandBuffer vk_commandBuffer = *(recordTraversal.getState()->_commandBuffer);
-    vkCmdBeginRenderPass(vk_commandBuffer, &renderPassInfo, contents);
+    vkCmdBeginRenderPass(vk_commandBuffer, &renderPassInfo, recordSecondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : contents);
+
+    if (recordSecondary) recordTraversal.setRenderPassInheritance(renderPassInfo.renderPass, 0, renderPassInfo.framebuffer);
 
     // traverse the subgraph to place commands into the command buffer.
     traverse(recordTraversal);
 
+    if (recordSecondary) recordTraversal.setRenderPassInheritance(VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
+
     vkCmdEndRenderPass(vk_commandBuffer);
 }
 
@@ -19,6 +19,72 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 using namespace vsg;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// vsg::Allocator::ThreadCache
+//
+namespace
+{
+    // trivially destructible so remains valid to test after the thread_local ThreadCache has been destroyed
+    thread_local bool s_threadCacheDestroyed = false;
+} // namespace
+
+/// per thread cache of recently deallocated memory slots, organized by AllocatorAffinity and size class.
+/// The ThreadCache::mutex is normally only locked by the owning thread so is uncontended, when both the Allocator::mutex and ThreadCache::mutex are required the Allocator::mutex must be locked first.
+struct Allocator::ThreadCache
+{
+    static constexpr size_t granularity = 8;
+
+    std::mutex mutex;
+    std::atomic<Allocator*> allocator = nullptr;
+    std::vector<std::vector<std::vector<void*>>> slots;
+    ThreadCacheStats stats;
+
+    std::vector<void*>& slotsFor(AllocatorAffinity allocatorAffinity, size_t size)
+    {
+        size_t sizeClass = size / granularity;
+        if (allocatorAffinity >= slots.size()) slots.resize(allocatorAffinity + 1);
+        auto& sizeClasses = slots[allocatorAffinity];
+        if (sizeClass >= sizeClasses.size()) sizeClasses.resize(sizeClass + 1);
+        return sizeClasses[sizeClass];
+    }
+
+    /// return all cached memory to the Allocator currently bound to and unregister from it.
+    void detach()
+    {
+        auto previous = allocator.load();
+        if (!previous) return;
+
+        std::scoped_lock<std::mutex> lock(previous->mutex);
+        std::scoped_lock<std::mutex> cacheLock(mutex);
+
+        previous->flushThreadCache(*this);
+        previous->exitedThreadCacheStats += stats;
+        stats = {};
+
+        auto itr = std::find(previous->threadCaches.begin(), previous->threadCaches.end(), this);
+        if (itr != previous->threadCaches.end()) previous->threadCaches.erase(itr);
+
+        allocator = nullptr;
+    }
+
+    ~ThreadCache()
+    {
+        detach();
+        s_threadCacheDestroyed = true;
+    }
+};
+
+Allocator::ThreadCacheStats& Allocator::ThreadCacheStats::operator+=(const ThreadCacheStats& rhs)
+{
+    hits += rhs.hits;
+    misses += rhs.misses;
+    refills += rhs.refills;
+    flushes += rhs.flushes;
+    cachedSize += rhs.cachedSize;
+    return *this;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // vsg::Allocator
@@ -46,6 +112,16 @@ Allocator::~Allocator()
     {
         info("~Allocator() ", this);
     }
+
+    // return the memory held by thread caches and unbind them so they aren't used after this Allocator is destroyed
+    std::scoped_lock<std::mutex> lock(mutex);
+    for (auto threadCache : threadCaches)
+    {
+        std::scoped_lock<std::mutex> cacheLock(threadCache->mutex);
+        flushThreadCache(*threadCache);
+        threadCache->allocator = nullptr;
+    }
+    threadCaches.clear();
 }
 
 std::unique_ptr<Allocator>& Allocator::instance()
@@ -88,12 +164,74 @@ void Allocator::report(std::ostream& out) const
             out << std::endl;
         }
     }
+
+    ThreadCacheStats stats = exitedThreadCacheStats;
+    for (auto threadCache : threadCaches)
+    {
+        std::scoped_lock<std::mutex> cacheLock(threadCache->mutex);
+        stats += threadCache->stats;
+    }
+
+    uint64_t lockCount = mutexLockCount.load();
+    uint64_t contentionCount = mutexContentionCount.load();
+    out << "mutex locks = " << lockCount << ", contended = " << contentionCount;
+    if (lockCount > 0) out << " (" << (double(contentionCount) / double(lockCount)) * 100.0 << "%)";
+    out << std::endl;
+
+    uint64_t cacheRequests = stats.hits + stats.misses;
+    out << "threadCaches = " << threadCaches.size() << ", hits = " << stats.hits << ", misses = " << stats.misses;
+    if (cacheRequests > 0) out << " (" << (double(stats.hits) / double(cacheRequests)) * 100.0 << "% hit rate)";
+    out << ", refills = " << stats.refills << ", flushes = " << stats.flushes << ", cachedSize = " << stats.cachedSize << std::endl;
 }
 
 void* Allocator::allocate(std::size_t size, AllocatorAffinity allocatorAffinity)
 {
-    std::scoped_lock<std::mutex> lock(mutex);
+    // round up to a multiple of the thread cache granularity so that any small allocation can be safely reused from a thread cache
+    size = ((size + ThreadCache::granularity - 1) / ThreadCache::granularity) * ThreadCache::granularity;
+
+    if (useThreadCaches && size > 0 && size <= threadCacheMaxAllocationSize && allocatorAffinity < ALLOCATOR_AFFINITY_LAST && memoryTracking == MEMORY_TRACKING_NO_CHECKS)
+    {
+        if (auto threadCache = getThreadCache())
+        {
+            std::unique_lock<std::mutex> cacheLock(threadCache->mutex);
+            auto& slots = threadCache->slotsFor(allocatorAffinity, size);
+            if (!slots.empty())
+            {
+                void* ptr = slots.back();
+                slots.pop_back();
+                threadCache->stats.cachedSize -= size;
+                ++(threadCache->stats.hits);
+                return ptr;
+            }
+            ++(threadCache->stats.misses);
+            cacheLock.unlock();
+
+            // thread cache empty so reserve a batch of slots from the MemoryBlocks with a single lock of the mutex
+            auto lock = lockMutex();
+            cacheLock.lock();
+
+            void* ptr = _allocate(size, allocatorAffinity);
+            if (ptr && threadCacheRefillCount > 1)
+            {
+                for (size_t i = 1; i < threadCacheRefillCount && slots.size() < threadCacheMaxSlots; ++i)
+                {
+                    void* slot_ptr = _allocate(size, allocatorAffinity);
+                    if (!slot_ptr) break;
+                    slots.push_back(slot_ptr);
+                    threadCache->stats.cachedSize += size;
+                }
+                ++(threadCache->stats.refills);
+            }
+            return ptr;
+        }
+    }
+
+    auto lock = lockMutex();
+    return _allocate(size, allocatorAffinity);
+}
 
+void* Allocator::_allocate(std::size_t size, AllocatorAffinity allocatorAffinity)
+{
     if (allocatorType == ALLOCATOR_TYPE_NEW_DELETE)
     {
         return operator new(size);
@@ -104,7 +242,7 @@ void* Allocator::allocate(std::size_t size, AllocatorAffinity allocatorAffinity)
     }
 
     // create a MemoryBlocks entry if one doesn't already exist
-    if (allocatorAffinity > allocatorMemoryBlocks.size())
+    if (allocatorAffinity >= allocatorMemoryBlocks.size())
     {
         if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
         {
@@ -132,7 +270,7 @@ void* Allocator::allocate(std::size_t size, AllocatorAffinity allocatorAffinity)
         }
     }
 
-    void* ptr = Allocator::allocate(size, allocatorAffinity);
+    void* ptr = operator new(size);
     if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
     {
         info("Allocator::allocate(", size, ", ", int(allocatorAffinity), ") ptr = ", ptr);
@@ -140,10 +278,50 @@ void* Allocator::allocate(std::size_t size, AllocatorAffinity allocatorAffinity)
     return ptr;
 }
 
-bool Allocator::deallocate(void* ptr, std::size_t size)
+bool Allocator::deallocate(void* ptr, std::size_t size, AllocatorAffinity allocatorAffinity)
 {
-    std::scoped_lock<std::mutex> lock(mutex);
+    // memory from a nestedAllocator may not have been rounded up to the thread cache granularity so can't be cached
+    if (useThreadCaches && size > 0 && size <= threadCacheMaxAllocationSize && allocatorAffinity < ALLOCATOR_AFFINITY_LAST && memoryTracking == MEMORY_TRACKING_NO_CHECKS && !nestedAllocator)
+    {
+        if (auto threadCache = getThreadCache())
+        {
+            size = ((size + ThreadCache::granularity - 1) / ThreadCache::granularity) * ThreadCache::granularity;
+
+            std::unique_lock<std::mutex> cacheLock(threadCache->mutex);
+            auto& slots = threadCache->slotsFor(allocatorAffinity, size);
+            if (slots.size() < threadCacheMaxSlots)
+            {
+                slots.push_back(ptr);
+                threadCache->stats.cachedSize += size;
+                return true;
+            }
+            cacheLock.unlock();
+
+            // thread cache full so return half of the cached slots to the MemoryBlocks with a single lock of the mutex
+            auto lock = lockMutex();
+            cacheLock.lock();
+
+            size_t keep = threadCacheMaxSlots / 2;
+            for (size_t i = keep; i < slots.size(); ++i)
+            {
+                _deallocate(slots[i], size);
+                threadCache->stats.cachedSize -= size;
+            }
+            slots.resize(keep);
+            ++(threadCache->stats.flushes);
+
+            slots.push_back(ptr);
+            threadCache->stats.cachedSize += size;
+            return true;
+        }
+    }
 
+    auto lock = lockMutex();
+    return _deallocate(ptr, size);
+}
+
+bool Allocator::_deallocate(void* ptr, std::size_t size)
+{
     for (auto& memoryBlocks : allocatorMemoryBlocks)
     {
         if (memoryBlocks)
@@ -175,8 +353,89 @@ bool Allocator::deallocate(void* ptr, std::size_t size)
     return false;
 }
 
+std::unique_lock<std::mutex> Allocator::lockMutex()
+{
+    mutexLockCount.fetch_add(1, std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        mutexContentionCount.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+    return lock;
+}
+
+Allocator::ThreadCache* Allocator::getThreadCache()
+{
+    // the thread_local ThreadCache can't be used once it has been destroyed at thread exit
+    if (s_threadCacheDestroyed) return nullptr;
+
+    thread_local ThreadCache s_threadCache;
+
+    if (s_threadCache.allocator.load() != this)
+    {
+        // thread cache is still bound to a previous Allocator so return any memory it holds before binding to this Allocator
+        s_threadCache.detach();
+
+        std::scoped_lock<std::mutex> lock(mutex);
+        std::scoped_lock<std::mutex> cacheLock(s_threadCache.mutex);
+
+        threadCaches.push_back(&s_threadCache);
+        s_threadCache.allocator = this;
+    }
+    return &s_threadCache;
+}
+
+void Allocator::flushThreadCache(ThreadCache& threadCache)
+{
+    for (size_t affinity = 0; affinity < threadCache.slots.size(); ++affinity)
+    {
+        auto& sizeClasses = threadCache.slots[affinity];
+        for (size_t sizeClass = 0; sizeClass < sizeClasses.size(); ++sizeClass)
+        {
+            auto& slots = sizeClasses[sizeClass];
+            size_t size = sizeClass * ThreadCache::granularity;
+            for (auto ptr : slots)
+            {
+                _deallocate(ptr, size);
+                threadCache.stats.cachedSize -= size;
+            }
+            slots.clear();
+        }
+    }
+    ++(threadCache.stats.flushes);
+}
+
+void Allocator::flushThreadCaches()
+{
+    auto lock = lockMutex();
+
+    for (auto threadCache : threadCaches)
+    {
+        std::scoped_lock<std::mutex> cacheLock(threadCache->mutex);
+        flushThreadCache(*threadCache);
+    }
+}
+
+Allocator::ThreadCacheStats Allocator::threadCacheStats() const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+
+    ThreadCacheStats combined = exitedThreadCacheStats;
+    for (auto threadCache : threadCaches)
+    {
+        std::scoped_lock<std::mutex> cacheLock(threadCache->mutex);
+        combined += threadCache->stats;
+    }
+    return combined;
+}
+
 size_t Allocator::deleteEmptyMemoryBlocks()
 {
+    // memory held in thread caches prevents MemoryBlocks from being empty so return it first
+    flushThreadCaches();
+
     std::scoped_lock<std::mutex> lock(mutex);
 
     size_t memoryDeleted = 0;
@@ -497,6 +756,138 @@ size_t Allocator::MemoryBlocks::totalMemorySize() const
     return size;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// vsg::FrameArena
+//
+FrameArena::FrameArena(size_t in_blockSize) :
+    blockSize(in_blockSize)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    for (auto block : _blocks)
+    {
+        std::free(block->memory);
+        delete block;
+    }
+}
+
+FrameArena::Block* FrameArena::createBlock(size_t size)
+{
+    auto memory = static_cast<uint8_t*>(std::malloc(size));
+    if (!memory) return nullptr;
+
+    auto block = new Block;
+    block->memory = memory;
+    block->size = size;
+    _blocks.push_back(block);
+    return block;
+}
+
+void* FrameArena::allocate(std::size_t size, std::size_t alignment)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (alignment == 0) alignment = 1;
+
+    for (;;)
+    {
+        Block* block = _currentBlock.load();
+        if (block)
+        {
+            // bump the used count of the current block, retrying if another thread has allocated from it in the meantime
+            size_t used = block->used.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto address = reinterpret_cast<std::uintptr_t>(block->memory) + used;
+                size_t alignedStart = used + (alignment - (address % alignment)) % alignment;
+                size_t alignedEnd = alignedStart + size;
+                if (alignedEnd > block->size) break;
+
+                if (block->used.compare_exchange_weak(used, alignedEnd, std::memory_order_relaxed))
+                {
+                    return block->memory + alignedStart;
+                }
+            }
+        }
+
+        // current block is full so add a new block
+        std::scoped_lock<std::mutex> lock(_mutex);
+        if (_currentBlock.load() != block) continue; // another thread has already added a new block
+
+        auto newBlock = createBlock(std::max(blockSize, size + alignment));
+        if (!newBlock)
+        {
+            warn("FrameArena::allocate(", size, ", ", alignment, ") failed to allocate block.");
+            return nullptr;
+        }
+
+        _currentBlock = newBlock;
+    }
+}
+
+void FrameArena::reset()
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    size_t allocated = 0;
+    size_t memorySize = 0;
+    for (auto block : _blocks)
+    {
+        allocated += block->used;
+        memorySize += block->size;
+    }
+    peakAllocatedSize = std::max(peakAllocatedSize, allocated);
+
+    if (_blocks.size() > 1)
+    {
+        // replace the blocks required for the last frame with a single block so that subsequent similar frames only need the one block
+        for (auto block : _blocks)
+        {
+            std::free(block->memory);
+            delete block;
+        }
+        _blocks.clear();
+
+        _currentBlock = createBlock(memorySize);
+    }
+    else if (!_blocks.empty())
+    {
+        _blocks.front()->used = 0;
+    }
+}
+
+size_t FrameArena::totalAllocatedSize() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    size_t size = 0;
+    for (auto block : _blocks) size += block->used;
+    return size;
+}
+
+size_t FrameArena::totalMemorySize() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    size_t size = 0;
+    for (auto block : _blocks) size += block->size;
+    return size;
+}
+
+void FrameArena::report(std::ostream& out) const
+{
+    size_t numBlocks = 0;
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        numBlocks = _blocks.size();
+    }
+
+    out << "FrameArena " << numBlocks << " blocks, totalAllocatedSize = " << totalAllocatedSize() << ", totalMemorySize = " << totalMemorySize() << ", peakAllocatedSize = " << peakAllocatedSize << ", allocationCount = " << allocationCount.load() << std::endl;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // vsg::allocate and vsg::deallocate convenience functions that map to using the Allocator singleton.
@@ -506,7 +897,7 @@ void* vsg::allocate(std::size_t size, AllocatorAffinity allocatorAffinity)
     return Allocator::instance()->allocate(size, allocatorAffinity);
 }
 
-void vsg::deallocate(void* ptr, std::size_t size)
+void vsg::deallocate(void* ptr, std::size_t size, AllocatorAffinity allocatorAffinity)
 {
-    Allocator::instance()->deallocate(ptr, size);
+    Allocator::instance()->deallocate(ptr, size, allocatorAffinity);
 }
@@ -46,9 +46,9 @@ void* Data::operator new(std::size_t count)
     return vsg::allocate(count, vsg::ALLOCATOR_AFFINITY_DATA);
 }
 
-void Data::operator delete(void* ptr)
+void Data::operator delete(void* ptr, std::size_t size)
 {
-    vsg::deallocate(ptr);
+    vsg::deallocate(ptr, size, vsg::ALLOCATOR_AFFINITY_DATA);
 }
 
 int Data::compare(const Object& rhs_object) const
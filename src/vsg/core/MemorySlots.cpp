@@ -16,6 +16,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/io/Options.h>
 
 #include <algorithm>
+#include <limits>
+
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#endif
 
 using namespace vsg;
 
@@ -23,24 +28,61 @@ using namespace vsg;
 //
 // MemorySlots
 //
+namespace
+{
+    inline uint32_t mostSignificantBit(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<uint32_t>(index);
+#else
+        return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+    }
+
+    inline uint32_t leastSignificantBit(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<uint32_t>(index);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+    }
+} // namespace
+
 MemorySlots::MemorySlots(size_t availableMemorySize, int in_memoryTracking) :
-    memoryTracking(in_memoryTracking)
+    memoryTracking(in_memoryTracking),
+    _totalMemorySize(availableMemorySize)
 {
     if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
     {
         info("MemorySlots::MemorySlots(", availableMemorySize, ") ", this);
     }
 
-    insertAvailableSlot(0, availableMemorySize);
+    // only allocate the size classes that can be used for the available memory
+    uint32_t fl = 0, sl = 0;
+    mapping(std::max(availableMemorySize, size_t(1)), fl, sl);
+    _secondLevelBitmaps.resize(fl + 1, 0);
+    _availableHeads.resize((fl + 1) * secondLevelCount, npos);
+
+    _slots.reserve(16);
+    _reservedSlots.resize(16, {0, npos});
 
-    _totalMemorySize = availableMemorySize;
+    if (availableMemorySize > 0)
+    {
+        _firstSlot = createSlot(0, availableMemorySize);
+        insertAvailableSlot(_firstSlot);
+    }
 }
 
 MemorySlots::~MemorySlots()
 {
     if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
     {
-        if (_availableMemory.size() == 1)
+        if (empty())
         {
             info("MemorySlots::~MemorySlots() ", this, ", all slots restored correctly.");
         }
@@ -56,149 +98,371 @@ MemorySlots::~MemorySlots()
     }
 }
 
-size_t MemorySlots::totalAvailableSize() const
+void MemorySlots::mapping(size_t size, uint32_t& fl, uint32_t& sl)
 {
-    size_t totalSize = 0;
-    for (const auto& sizeOffset : _availableMemory)
+    // sizes below secondLevelCount map linearly into the first level, larger sizes are split into secondLevelCount subdivisions of each power of two
+    if (size < secondLevelCount)
+    {
+        fl = 0;
+        sl = static_cast<uint32_t>(size);
+    }
+    else
     {
-        totalSize += sizeOffset.first;
+        uint32_t msb = mostSignificantBit(size);
+        fl = msb - secondLevelCountLog2 + 1;
+        sl = static_cast<uint32_t>(size >> (msb - secondLevelCountLog2)) ^ secondLevelCount;
     }
-    return totalSize;
 }
 
-size_t MemorySlots::totalReservedSize() const
+size_t MemorySlots::maximumAvailableSpace() const
 {
-    size_t totalSize = 0;
-    for (const auto& sizeOffset : _reservedMemory)
+    if (_firstLevelBitmap == 0) return 0;
+
+    uint32_t fl = mostSignificantBit(_firstLevelBitmap);
+    uint32_t sl = mostSignificantBit(_secondLevelBitmaps[fl]);
+
+    size_t maxSize = 0;
+    for (uint32_t index = _availableHeads[fl * secondLevelCount + sl]; index != npos; index = _slots[index].nextAvailable)
     {
-        totalSize += sizeOffset.second;
+        maxSize = std::max(maxSize, _slots[index].size);
     }
-    return totalSize;
+    return maxSize;
 }
 
 bool MemorySlots::check() const
 {
-    if (_availableMemory.size() != _offsetSizes.size())
+    size_t availableSize = 0;
+    size_t reservedSize = 0;
+    size_t numReserved = 0;
+    size_t expectedOffset = 0;
+    bool previousAvailable = false;
+    bool valid = true;
+
+    for (uint32_t index = _firstSlot; index != npos; index = _slots[index].next)
     {
-        warn("MemorySlots::check() _availableMemory.size() ", _availableMemory.size(), " != _offsetSizes.size() ", _offsetSizes.size());
+        auto& slot = _slots[index];
+        if (slot.offset != expectedOffset)
+        {
+            warn("MemorySlots::check() ", this, " slot offset ", slot.offset, " doesn't abut previous slot end ", expectedOffset);
+            valid = false;
+        }
+
+        if (slot.available)
+        {
+            if (previousAvailable)
+            {
+                warn("MemorySlots::check() ", this, " adjacent available slots at ", slot.offset, " not merged");
+                valid = false;
+            }
+            availableSize += slot.size;
+        }
+        else
+        {
+            reservedSize += slot.size;
+            ++numReserved;
+        }
+
+        previousAvailable = slot.available;
+        expectedOffset = slot.offset + slot.size;
     }
 
-    size_t availableSize = 0;
-    for (auto& offsetSize : _offsetSizes)
+    if (numReserved != _numReservedSlots)
     {
-        availableSize += offsetSize.second;
+        warn("MemorySlots::check() ", this, " number of reserved slots ", numReserved, " != _numReservedSlots ", _numReservedSlots);
+        valid = false;
     }
 
-    size_t reservedSize = 0;
-    for (auto& offsetSize : _reservedMemory)
+    if (availableSize != _totalAvailableSize || reservedSize != _totalReservedSize)
     {
-        reservedSize += offsetSize.second;
+        warn("MemorySlots::check() ", this, " availableSize (", availableSize, ") != _totalAvailableSize (", _totalAvailableSize, ") or reservedSize (", reservedSize, ") != _totalReservedSize (", _totalReservedSize, ")");
+        valid = false;
     }
 
     size_t computedSize = availableSize + reservedSize;
     if (computedSize != _totalMemorySize)
     {
         warn("MemorySlots::check() ", this, " failed, computedSize (", computedSize, ") != _totalMemorySize (", _totalMemorySize, ")");
-        warn_stream([&](auto& fout) { report(fout); });
-
-        return false;
+        valid = false;
     }
 
-    return true;
+    if (!valid) warn_stream([&](auto& fout) { report(fout); });
+
+    return valid;
 }
 
 void MemorySlots::report(std::ostream& out) const
 {
     out << "MemorySlots::report() " << this << std::endl;
-    for (auto& [offset, size] : _offsetSizes)
+    for (uint32_t index = _firstSlot; index != npos; index = _slots[index].next)
     {
-        out << "    available " << offset << ", " << size << std::endl;
+        auto& slot = _slots[index];
+        if (slot.available) out << "    available " << slot.offset << ", " << slot.size << std::endl;
     }
 
-    for (auto& [offset, size] : _reservedMemory)
+    for (uint32_t index = _firstSlot; index != npos; index = _slots[index].next)
+    {
+        auto& slot = _slots[index];
+        if (!slot.available) out << "    reserved " << std::dec << slot.offset << ", " << slot.size << std::endl;
+    }
+}
+
+uint32_t MemorySlots::createSlot(size_t offset, size_t size)
+{
+    uint32_t index;
+    if (_unusedSlots != npos)
+    {
+        // reuse a previously destroyed Slot
+        index = _unusedSlots;
+        _unusedSlots = _slots[index].next;
+        _slots[index] = Slot{};
+    }
+    else
     {
-        out << "    reserved " << std::dec << offset << ", " << size << std::endl;
+        index = static_cast<uint32_t>(_slots.size());
+        _slots.emplace_back();
     }
+
+    auto& slot = _slots[index];
+    slot.offset = offset;
+    slot.size = size;
+    return index;
 }
 
-void MemorySlots::insertAvailableSlot(size_t offset, size_t size)
+void MemorySlots::destroySlot(uint32_t index)
 {
-    _offsetSizes.emplace(offset, size);
-    _availableMemory.emplace(size, offset);
+    _slots[index].next = _unusedSlots;
+    _unusedSlots = index;
 }
 
-void MemorySlots::removeAvailableSlot(size_t offset, size_t size)
+void MemorySlots::insertAvailableSlot(uint32_t index)
 {
-    _offsetSizes.erase(offset);
-    auto end = _availableMemory.upper_bound(size);
-    for (auto itr = _availableMemory.lower_bound(size); itr != end; ++itr)
+    auto& slot = _slots[index];
+
+    uint32_t fl = 0, sl = 0;
+    mapping(slot.size, fl, sl);
+
+    auto& head = _availableHeads[fl * secondLevelCount + sl];
+    slot.available = true;
+    slot.previousAvailable = npos;
+    slot.nextAvailable = head;
+    if (head != npos) _slots[head].previousAvailable = index;
+    head = index;
+
+    _firstLevelBitmap |= (uint64_t(1) << fl);
+    _secondLevelBitmaps[fl] |= (1u << sl);
+
+    _totalAvailableSize += slot.size;
+}
+
+void MemorySlots::removeAvailableSlot(uint32_t index)
+{
+    auto& slot = _slots[index];
+
+    uint32_t fl = 0, sl = 0;
+    mapping(slot.size, fl, sl);
+
+    if (slot.previousAvailable != npos)
+        _slots[slot.previousAvailable].nextAvailable = slot.nextAvailable;
+    else
+        _availableHeads[fl * secondLevelCount + sl] = slot.nextAvailable;
+
+    if (slot.nextAvailable != npos) _slots[slot.nextAvailable].previousAvailable = slot.previousAvailable;
+
+    if (_availableHeads[fl * secondLevelCount + sl] == npos)
     {
-        if (itr->second == offset)
+        _secondLevelBitmaps[fl] &= ~(1u << sl);
+        if (_secondLevelBitmaps[fl] == 0) _firstLevelBitmap &= ~(uint64_t(1) << fl);
+    }
+
+    slot.available = false;
+    slot.previousAvailable = npos;
+    slot.nextAvailable = npos;
+
+    _totalAvailableSize -= slot.size;
+}
+
+uint32_t MemorySlots::findAvailableSlot(size_t size, size_t alignment, size_t& alignedStart) const
+{
+    auto fits = [&](uint32_t index) {
+        auto& slot = _slots[index];
+        alignedStart = ((slot.offset + alignment - 1) / alignment) * alignment;
+        return (alignedStart + size) <= (slot.offset + slot.size);
+    };
+
+    // search the size classes from fl, sl upwards, checking at most maxChecks slots of each size class before moving on to the next
+    auto search = [&](uint32_t fl, uint32_t sl, size_t maxChecks) -> uint32_t {
+        while (fl < _secondLevelBitmaps.size())
         {
-            _availableMemory.erase(itr);
-            break;
+            uint32_t slMap = (sl < 32) ? (_secondLevelBitmaps[fl] & (~0u << sl)) : 0;
+            if (slMap == 0)
+            {
+                uint64_t flMap = (fl + 1 < 64) ? (_firstLevelBitmap & (~uint64_t(0) << (fl + 1))) : 0;
+                if (flMap == 0) return npos;
+
+                fl = leastSignificantBit(flMap);
+                slMap = _secondLevelBitmaps[fl];
+            }
+            sl = leastSignificantBit(slMap);
+
+            size_t numChecks = 0;
+            for (uint32_t index = _availableHeads[fl * secondLevelCount + sl]; index != npos && numChecks < maxChecks; index = _slots[index].nextAvailable, ++numChecks)
+            {
+                if (fits(index)) return index;
+            }
+            ++sl;
         }
+        return npos;
+    };
+
+    // good fit, round the size up to the next size class so that any slot in it will be big enough
+    uint32_t fl = 0, sl = 0;
+    size_t roundedSize = size;
+    if (size >= secondLevelCount)
+    {
+        roundedSize += (size_t(1) << (mostSignificantBit(size) - secondLevelCountLog2)) - 1;
     }
+    mapping(roundedSize, fl, sl);
+
+    uint32_t index = search(fl, sl, 4);
+    if (index != npos) return index;
+
+    // slots in the size class of the requested size, or ones that are only big enough once the alignment is accounted for, need checking individually
+    mapping(size, fl, sl);
+    return search(fl, sl, std::numeric_limits<size_t>::max());
 }
 
-MemorySlots::OptionalOffset MemorySlots::reserve(size_t size, size_t alignment)
+size_t MemorySlots::reservedHash(size_t offset) const
 {
-    if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
+    // fibonacci hashing spreads the typically aligned offsets across the table
+    return static_cast<size_t>((static_cast<uint64_t>(offset) * 11400714819323198485ull) >> 32) & (_reservedSlots.size() - 1);
+}
+
+void MemorySlots::insertReservedSlot(size_t offset, uint32_t index)
+{
+    if ((_numReservedSlots + 1) * 4 > _reservedSlots.size() * 3)
     {
-        info("\nMemorySlots::reserve(", size, ", ", alignment, ") ", this);
+        // grow the table to keep the load factor below 0.75
+        std::vector<std::pair<size_t, uint32_t>> previous(_reservedSlots.size() * 2, {0, npos});
+        previous.swap(_reservedSlots);
+        _numReservedSlots = 0;
+        for (auto& [previous_offset, previous_index] : previous)
+        {
+            if (previous_index != npos) insertReservedSlot(previous_offset, previous_index);
+        }
     }
 
-    if (full()) return OptionalOffset(false, 0);
+    size_t mask = _reservedSlots.size() - 1;
+    size_t i = reservedHash(offset);
+    while (_reservedSlots[i].second != npos) i = (i + 1) & mask;
+
+    _reservedSlots[i] = {offset, index};
+    ++_numReservedSlots;
+}
+
+uint32_t MemorySlots::removeReservedSlot(size_t offset)
+{
+    size_t mask = _reservedSlots.size() - 1;
+    size_t i = reservedHash(offset);
+    while (_reservedSlots[i].second != npos && _reservedSlots[i].first != offset) i = (i + 1) & mask;
+
+    uint32_t index = _reservedSlots[i].second;
+    if (index == npos) return npos;
 
-    auto itr = _availableMemory.lower_bound(size);
-    while (itr != _availableMemory.end())
+    // backward shift deletion so that no tombstones are required
+    size_t j = i;
+    for (;;)
     {
-        size_t slotSize = itr->first;
-        size_t slotStart = itr->second;
-        size_t slotEnd = slotStart + slotSize;
-        size_t alignedStart = ((slotStart + alignment - 1) / alignment) * alignment;
-        size_t alignedEnd = alignedStart + size;
-        if (alignedEnd <= slotEnd) // slot big enough
+        _reservedSlots[i].second = npos;
+        for (;;)
         {
-            // remove available slot
-            removeAvailableSlot(slotStart, slotSize);
-
-            if (slotStart < alignedStart) // space before newly reserved slot
+            j = (j + 1) & mask;
+            if (_reservedSlots[j].second == npos)
             {
-                insertAvailableSlot(slotStart, alignedStart - slotStart);
+                --_numReservedSlots;
+                return index;
             }
 
-            if (alignedEnd < slotEnd) // space after newly reserved slot
-            {
-                slotStart = alignedEnd;
-                insertAvailableSlot(slotStart, slotEnd - slotStart);
-            }
+            size_t k = reservedHash(_reservedSlots[j].first);
+            // move entry j into the gap at i unless its home position k lies cyclically in (i, j]
+            if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))) continue;
+            break;
+        }
+        _reservedSlots[i] = _reservedSlots[j];
+        i = j;
+    }
+}
 
-            // record and return reserved slot
-            _reservedMemory.emplace(alignedStart, size);
+MemorySlots::OptionalOffset MemorySlots::reserve(size_t size, size_t alignment)
+{
+    if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
+    {
+        info("\nMemorySlots::reserve(", size, ", ", alignment, ") ", this);
+    }
 
-            if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
-            {
-                info("MemorySlots::reserve(", size, ", ", alignment, ") ", this, " allocated [", alignedStart, ", ", size, "]");
-            }
+    if (full()) return OptionalOffset(false, 0);
 
-            if (memoryTracking & MEMORY_TRACKING_CHECK_ACTIONS) check();
+    // zero sized reservations still require a unique offset so are given a minimum size of 1
+    if (size == 0) size = 1;
+    if (alignment == 0) alignment = 1;
 
-            return {true, alignedStart};
-        }
-        else // slot not big enough so advance to the next slot
+    size_t alignedStart = 0;
+    uint32_t index = findAvailableSlot(size, alignment, alignedStart);
+    if (index == npos)
+    {
+        if (memoryTracking & MEMORY_TRACKING_CHECK_ACTIONS) check();
+
+        if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
         {
-            ++itr;
+            info("MemorySlots::reserve(", size, ", ", alignment, ") ", this, " no suitable slots found");
         }
+        return {false, 0};
     }
 
-    if (memoryTracking & MEMORY_TRACKING_CHECK_ACTIONS) check();
+    removeAvailableSlot(index);
+
+    size_t slotStart = _slots[index].offset;
+    size_t slotEnd = slotStart + _slots[index].size;
+    size_t alignedEnd = alignedStart + size;
+
+    if (slotStart < alignedStart) // space before newly reserved slot
+    {
+        uint32_t before = createSlot(slotStart, alignedStart - slotStart);
+        auto& slot = _slots[index];
+        _slots[before].previous = slot.previous;
+        _slots[before].next = index;
+        if (slot.previous != npos)
+            _slots[slot.previous].next = before;
+        else
+            _firstSlot = before;
+        slot.previous = before;
+        slot.offset = alignedStart;
+        insertAvailableSlot(before);
+    }
+
+    if (alignedEnd < slotEnd) // space after newly reserved slot
+    {
+        uint32_t after = createSlot(alignedEnd, slotEnd - alignedEnd);
+        auto& slot = _slots[index];
+        _slots[after].previous = index;
+        _slots[after].next = slot.next;
+        if (slot.next != npos) _slots[slot.next].previous = after;
+        slot.next = after;
+        insertAvailableSlot(after);
+    }
+
+    // record and return reserved slot
+    _slots[index].size = size;
+    _totalReservedSize += size;
+    insertReservedSlot(alignedStart, index);
 
     if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
     {
-        info("MemorySlots::reserve(", size, ", ", alignment, ") ", this, " no suitable slots found");
+        info("MemorySlots::reserve(", size, ", ", alignment, ") ", this, " allocated [", alignedStart, ", ", size, "]");
     }
-    return {false, 0};
+
+    if (memoryTracking & MEMORY_TRACKING_CHECK_ACTIONS) check();
+
+    return {true, alignedStart};
 }
 
 bool MemorySlots::release(size_t offset, size_t size)
@@ -208,75 +472,47 @@ bool MemorySlots::release(size_t offset, size_t size)
         info("\nMemorySlots::release(", offset, ", ", size, ") ", this);
     }
 
-    auto itr = _reservedMemory.find(offset);
-    if (itr == _reservedMemory.end())
+    uint32_t index = removeReservedSlot(offset);
+    if (index == npos)
     {
         // entry isn't in reserved slots
         return false;
     }
 
-    if (size != itr->second)
+    if (size != _slots[index].size)
     {
         if (memoryTracking & MEMORY_TRACKING_REPORT_ACTIONS)
         {
-            info("    reserved slot different size = ", size, ", itr->second = ", itr->second);
+            info("    reserved slot different size = ", size, ", slot.size = ", _slots[index].size);
         }
-
-        size = itr->second;
     }
 
-    // remove from reserved list
-    _reservedMemory.erase(itr);
+    _totalReservedSize -= _slots[index].size;
 
-    if (_offsetSizes.empty())
+    uint32_t previous = _slots[index].previous;
+    if (previous != npos && _slots[previous].available)
     {
-        insertAvailableSlot(offset, size);
-
-        if (memoryTracking & MEMORY_TRACKING_CHECK_ACTIONS) check();
-
-        return true;
+        // previous slot abuts with the one being released so merge the released slot into it
+        removeAvailableSlot(previous);
+        _slots[previous].size += _slots[index].size;
+        _slots[previous].next = _slots[index].next;
+        if (_slots[index].next != npos) _slots[_slots[index].next].previous = previous;
+        destroySlot(index);
+        index = previous;
     }
 
-    size_t slotStart = offset;
-    size_t slotEnd = offset + size;
-
-    auto next_slot_itr = _offsetSizes.lower_bound(slotStart);
-    if (next_slot_itr != _offsetSizes.end())
+    uint32_t next = _slots[index].next;
+    if (next != npos && _slots[next].available)
     {
-        if (next_slot_itr != _offsetSizes.begin())
-        {
-            auto prev_slot_itr = next_slot_itr;
-            --prev_slot_itr;
-
-            size_t prev_slotEnd = prev_slot_itr->first + prev_slot_itr->second;
-            if (prev_slotEnd == slotStart)
-            {
-                // previous slot abuts with the one being released so remove it.
-                slotStart = prev_slot_itr->first;
-                removeAvailableSlot(prev_slot_itr->first, prev_slot_itr->second);
-            }
-        }
-
-        if (next_slot_itr->first == slotEnd)
-        {
-            // next available slot abuts released so extend new slot and remove previous next available slot
-            slotEnd = next_slot_itr->first + next_slot_itr->second;
-            removeAvailableSlot(next_slot_itr->first, next_slot_itr->second);
-        }
-    }
-    else
-    {
-        auto prev_slot_itr = _offsetSizes.rbegin();
-        size_t prev_slotEnd = prev_slot_itr->first + prev_slot_itr->second;
-        if (prev_slotEnd == slotStart)
-        {
-            // previous slot abuts with the one being released so remove it.
-            slotStart = prev_slot_itr->first;
-            removeAvailableSlot(prev_slot_itr->first, prev_slot_itr->second);
-        }
+        // next available slot abuts released so extend the released slot and remove the next slot
+        removeAvailableSlot(next);
+        _slots[index].size += _slots[next].size;
+        _slots[index].next = _slots[next].next;
+        if (_slots[next].next != npos) _slots[_slots[next].next].previous = index;
+        destroySlot(next);
     }
 
-    insertAvailableSlot(slotStart, slotEnd - slotStart);
+    insertAvailableSlot(index);
 
     if (memoryTracking & MEMORY_TRACKING_CHECK_ACTIONS) check();
 
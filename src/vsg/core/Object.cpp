@@ -213,7 +213,7 @@ void* Object::operator new(std::size_t count)
     return vsg::allocate(count, vsg::ALLOCATOR_AFFINITY_OBJECTS);
 }
 
-void Object::operator delete(void* ptr)
+void Object::operator delete(void* ptr, std::size_t size)
 {
-    vsg::deallocate(ptr);
+    vsg::deallocate(ptr, size, vsg::ALLOCATOR_AFFINITY_OBJECTS);
 }
@@ -771,6 +771,10 @@ void Visitor::apply(DrawIndexed& value)
 {
     apply(static_cast<Command&>(value));
 }
+void Visitor::apply(DrawIndexedIndirect& value)
+{
+    apply(static_cast<Command&>(value));
+}
 void Visitor::apply(ClearAttachments& value)
 {
     apply(static_cast<Command&>(value));
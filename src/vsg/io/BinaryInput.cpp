@@ -22,6 +22,8 @@ BinaryInput::BinaryInput(std::istream& input, ref_ptr<ObjectFactory> in_objectFa
     Input(in_objectFactory, in_options),
     _input(input)
 {
+    // class ID 0 is reserved for null objects
+    _classes.push_back(ClassEntry{"nullptr", {}});
 }
 
 void BinaryInput::_read(std::string& value)
@@ -30,6 +32,7 @@ void BinaryInput::_read(std::string& value)
 
     value.resize(size, 0);
     _input.read(value.data(), size);
+    _position += size;
 }
 
 void BinaryInput::_read(std::wstring& value)
@@ -96,25 +99,112 @@ vsg::ref_ptr<vsg::Object> BinaryInput::read()
     {
         return itr->second;
     }
+    else if (auto preread_itr = prereadObjects.find(id); preread_itr != prereadObjects.end())
+    {
+        objectIDMap.insert(preread_itr->second.objectIDMap.begin(), preread_itr->second.objectIDMap.end());
+        setPosition(preread_itr->second.end);
+        prereadObjects.erase(preread_itr);
+        return objectIDMap[id];
+    }
+    else if (classIDs)
+    {
+        uint32_t classID = readValue<uint32_t>(nullptr);
+        if (classID & 0x80000000)
+        {
+            classID &= ~0x80000000;
+            _read(_className);
+
+            // classes are defined in order of first use, so corrupt IDs can't grow the table arbitrarily
+            if (classID <= _classes.size()) assignClass(classID, _className);
+        }
+
+        vsg::ref_ptr<vsg::Object> object;
+        if (classID < _classes.size())
+        {
+            if (classID != 0) object = _create(_classes[classID].name, _classes[classID].create);
+        }
+        else
+        {
+            warn("Undefined class ID : ", classID);
+        }
+
+        objectIDMap[id] = object;
+        return object;
+    }
     else
     {
-        std::string className = readValue<std::string>(nullptr);
+        _read(_className);
 
         vsg::ref_ptr<vsg::Object> object;
-        if (className != "nullptr")
+        if (_className != "nullptr")
         {
-            object = objectFactory->create(className.c_str());
-            if (object)
-            {
-                object->read(*this);
-            }
-            else
-            {
-                warn("Unable to create instance of class : ", className);
-            }
+            auto itr = _createFunctions.find(_className);
+            if (itr == _createFunctions.end()) itr = _createFunctions.emplace(_className, objectFactory->getCreateFunction(_className)).first;
+            object = _create(_className, itr->second);
         }
 
         objectIDMap[id] = object;
         return object;
     }
 }
+
+vsg::ref_ptr<vsg::Object> BinaryInput::_create(const std::string& className, const ObjectFactory::CreateFunction& create)
+{
+    auto object = create ? create() : objectFactory->create(className);
+    if (object)
+    {
+        object->read(*this);
+    }
+    else
+    {
+        warn("Unable to create instance of class : ", className);
+    }
+    return object;
+}
+
+void BinaryInput::assignClass(uint32_t classID, const std::string& className)
+{
+    if (classID >= _classes.size()) _classes.resize(classID + 1);
+
+    auto& entry = _classes[classID];
+    if (entry.name == className) return;
+
+    entry.name = className;
+    entry.create = objectFactory->getCreateFunction(className);
+}
+
+void BinaryInput::setPosition(size_t position)
+{
+    if (position == _position) return;
+
+    _input.seekg(static_cast<std::streamoff>(position) - static_cast<std::streamoff>(_position), std::ios_base::cur);
+    _position = position;
+}
+
+void BinaryInput::alignArray()
+{
+    if (alignment <= 1) return;
+
+    size_t padding = (alignment - (_position % alignment)) % alignment;
+    if (padding > 0)
+    {
+        _input.ignore(static_cast<std::streamsize>(padding));
+        _position += padding;
+    }
+}
+
+const void* BinaryInput::mapArray(size_t size, size_t valueAlignment, ref_ptr<Object>& owner)
+{
+    if (!mappedFile || size == 0) return nullptr;
+
+    size_t offset = mappedOffset + _position;
+    if (offset + size > mappedFile->size()) return nullptr;
+
+    auto ptr = mappedFile->data() + offset;
+    if ((reinterpret_cast<uintptr_t>(ptr) % valueAlignment) != 0) return nullptr;
+
+    _input.ignore(static_cast<std::streamsize>(size));
+    _position += size;
+    owner = mappedFile;
+    return ptr;
+}
@@ -14,12 +14,17 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <vsg/io/BinaryOutput.h>
 
+#include <algorithm>
+
 using namespace vsg;
 
 BinaryOutput::BinaryOutput(std::ostream& output, ref_ptr<const Options> in_options) :
     Output(in_options),
     _output(output)
 {
+    // class ID 0 is reserved for null objects
+    _classIDMap["nullptr"] = 0;
+    _classNames.push_back("nullptr");
 }
 
 void BinaryOutput::_write(const std::string& str)
@@ -27,6 +32,7 @@ void BinaryOutput::_write(const std::string& str)
     uint32_t size = static_cast<uint32_t>(str.size());
     _output.write(reinterpret_cast<const char*>(&size), sizeof(uint32_t));
     _output.write(str.data(), size);
+    _position += sizeof(uint32_t) + size;
 }
 
 void BinaryOutput::_write(const std::wstring& str)
@@ -81,6 +87,24 @@ void BinaryOutput::write(size_t num, const Path* value)
     }
 }
 
+void BinaryOutput::_writeClass(const char* className)
+{
+    if (auto itr = _classIDMap.find(className); itr != _classIDMap.end())
+    {
+        _write(1, &(itr->second));
+        return;
+    }
+
+    // the first use of a class writes its ID with the top bit set followed by the class name
+    uint32_t classID = static_cast<uint32_t>(_classNames.size());
+    _classIDMap[className] = classID;
+    _classNames.push_back(className);
+
+    uint32_t definition = classID | 0x80000000;
+    _write(1, &definition);
+    _write(std::string(className));
+}
+
 void BinaryOutput::write(const vsg::Object* object)
 {
     if (auto itr = objectIDMap.find(object); itr != objectIDMap.end())
@@ -88,20 +112,95 @@ void BinaryOutput::write(const vsg::Object* object)
         // write out the objectID
         uint32_t id = itr->second;
         _output.write(reinterpret_cast<const char*>(&id), sizeof(id));
+        _position += sizeof(id);
+
+        // note the reference so objects referring to ones written before them aren't indexed, null objects don't need to be linked so are ignored
+        if (object && !_indexFrames.empty()) _indexFrames.back().minReference = std::min(_indexFrames.back().minReference, id);
         return;
     }
 
     ObjectID id = objectID++;
     objectIDMap[object] = id;
 
+    size_t begin = _position;
     _output.write(reinterpret_cast<const char*>(&id), sizeof(id));
+    _position += sizeof(id);
     if (object)
     {
-        _write(std::string(object->className()));
+        if (indexThreshold > 0) _indexFrames.push_back(IndexFrame{id, begin, id, false});
+
+        if (classIDs)
+            _writeClass(object->className());
+        else
+            _write(std::string(object->className()));
+
         object->write(*this);
+
+        if (indexThreshold > 0)
+        {
+            auto frame = _indexFrames.back();
+            _indexFrames.pop_back();
+
+            // record the innermost self contained objects that are large enough, the root object is always read sequentially
+            if (!_indexFrames.empty() && !frame.containsEntry && frame.minReference >= frame.id && (_position - frame.begin) >= indexThreshold)
+            {
+                index.push_back(IndexEntry{frame.id, frame.begin, _position});
+                frame.containsEntry = true;
+            }
+
+            if (!_indexFrames.empty())
+            {
+                auto& parent = _indexFrames.back();
+                parent.minReference = std::min(parent.minReference, frame.minReference);
+                parent.containsEntry = parent.containsEntry || frame.containsEntry;
+            }
+        }
+    }
+    else if (classIDs)
+    {
+        uint32_t classID = 0;
+        _write(1, &classID);
     }
     else
     {
         _write(std::string("nullptr"));
     }
 }
+
+void BinaryOutput::writeIndex()
+{
+    uint64_t indexPosition = _position;
+    uint64_t count = index.size();
+    _output.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    _output.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(IndexEntry));
+    _position += sizeof(count) + index.size() * sizeof(IndexEntry);
+
+    if (classIDs)
+    {
+        // indexed objects may be read before the objects that define the classes they use, so provide all the class names up front
+        uint32_t numClasses = static_cast<uint32_t>(_classNames.size());
+        _write(1, &numClasses);
+        for (auto& className : _classNames) _write(std::string(className));
+    }
+
+    _output.write(reinterpret_cast<const char*>(&indexPosition), sizeof(indexPosition));
+    _position += sizeof(indexPosition);
+}
+
+void BinaryOutput::alignArray()
+{
+    if (alignment <= 1) return;
+
+    size_t padding = (alignment - (_position % alignment)) % alignment;
+    if (padding > 0)
+    {
+        const char zeros[256] = {};
+        for (size_t remaining = padding; remaining > 0;)
+        {
+            size_t count = std::min(remaining, sizeof(zeros));
+            _output.write(zeros, static_cast<std::streamsize>(count));
+            remaining -= count;
+        }
+        _position += padding;
+    }
+}
@@ -0,0 +1,260 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/CompressionCodec.h>
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace vsg;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// CompressionCodec
+//
+CompressionCodec::CompressionCodec(const std::string& in_name) :
+    name(in_name)
+{
+}
+
+CompressionCodec::~CompressionCodec()
+{
+}
+
+struct CompressionCodecs
+{
+    std::mutex mutex;
+    std::map<std::string, ref_ptr<CompressionCodec>> codecs;
+
+    CompressionCodecs()
+    {
+        auto lz4 = LZ4Codec::create();
+        codecs[lz4->name] = lz4;
+    }
+
+    static CompressionCodecs& instance()
+    {
+        static CompressionCodecs s_codecs;
+        return s_codecs;
+    }
+};
+
+void CompressionCodec::add(ref_ptr<CompressionCodec> codec)
+{
+    if (!codec) return;
+
+    auto& registry = CompressionCodecs::instance();
+    std::scoped_lock<std::mutex> lock(registry.mutex);
+    registry.codecs[codec->name] = codec;
+}
+
+ref_ptr<CompressionCodec> CompressionCodec::find(const std::string& name)
+{
+    auto& registry = CompressionCodecs::instance();
+    std::scoped_lock<std::mutex> lock(registry.mutex);
+    if (auto itr = registry.codecs.find(name); itr != registry.codecs.end()) return itr->second;
+    return {};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LZ4Codec
+//
+// Each sequence is a token holding the literal length in its high 4 bits and the match length - 4 in its low 4 bits,
+// lengths of 15 or more continue in following bytes of 255 terminated by a byte less than 255. The literals follow, then
+// the 2 byte little endian offset of the match. The final sequence only has literals, the last 5 bytes are always literals
+// and the last match starts at least 12 bytes before the end.
+//
+static constexpr size_t lz4_minMatch = 4;
+static constexpr size_t lz4_lastLiterals = 5;
+static constexpr size_t lz4_matchFindLimit = 12;
+static constexpr size_t lz4_maxOffset = 65535;
+static constexpr uint32_t lz4_hashLog = 14;
+
+static inline uint32_t lz4_read32(const uint8_t* ptr)
+{
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint32_t lz4_hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - lz4_hashLog);
+}
+
+static inline uint8_t* lz4_writeLength(uint8_t* op, size_t length)
+{
+    for (; length >= 255; length -= 255) *op++ = 255;
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+}
+
+static inline bool lz4_readLength(const uint8_t*& ip, const uint8_t* iend, size_t& length)
+{
+    uint8_t value = 0;
+    do
+    {
+        if (ip >= iend) return false;
+        value = *ip++;
+        length += value;
+    } while (value == 255);
+    return true;
+}
+
+LZ4Codec::LZ4Codec() :
+    Inherit("lz4")
+{
+}
+
+LZ4Codec::~LZ4Codec()
+{
+}
+
+size_t LZ4Codec::compressBound(size_t size) const
+{
+    return size + size / 255 + 16;
+}
+
+size_t LZ4Codec::compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) const
+{
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* iend = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dstCapacity;
+
+    auto writeSequence = [&](const uint8_t* matchStart, size_t offset, size_t matchLength) -> bool {
+        size_t literalLength = static_cast<size_t>(matchStart - anchor);
+        size_t required = 1 + literalLength + literalLength / 255 + 1 + 2 + matchLength / 255 + 1;
+        if (required > static_cast<size_t>(oend - op)) return false;
+
+        uint8_t* token = op++;
+        if (literalLength >= 15)
+        {
+            *token = 15 << 4;
+            op = lz4_writeLength(op, literalLength - 15);
+        }
+        else
+        {
+            *token = static_cast<uint8_t>(literalLength << 4);
+        }
+
+        std::memcpy(op, anchor, literalLength);
+        op += literalLength;
+
+        if (matchLength == 0) return true;
+
+        *op++ = static_cast<uint8_t>(offset & 0xff);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+
+        size_t length = matchLength - lz4_minMatch;
+        if (length >= 15)
+        {
+            *token |= 15;
+            op = lz4_writeLength(op, length - 15);
+        }
+        else
+        {
+            *token |= static_cast<uint8_t>(length);
+        }
+        return true;
+    };
+
+    if (srcSize >= lz4_matchFindLimit)
+    {
+        std::vector<uint32_t> hashTable(size_t(1) << lz4_hashLog, 0);
+
+        const uint8_t* matchLimit = iend - lz4_lastLiterals;
+        const uint8_t* inputLimit = iend - lz4_matchFindLimit;
+        while (ip <= inputLimit)
+        {
+            uint32_t sequence = lz4_read32(ip);
+            auto& entry = hashTable[lz4_hash(sequence)];
+            const uint8_t* ref = src + entry;
+            entry = static_cast<uint32_t>(ip - src);
+
+            if (ref >= ip || static_cast<size_t>(ip - ref) > lz4_maxOffset || lz4_read32(ref) != sequence)
+            {
+                ++ip;
+                continue;
+            }
+
+            // extend the match forwards then backwards over any pending literals
+            const uint8_t* matchEnd = ip + lz4_minMatch;
+            const uint8_t* refEnd = ref + lz4_minMatch;
+            while (matchEnd < matchLimit && *matchEnd == *refEnd)
+            {
+                ++matchEnd;
+                ++refEnd;
+            }
+
+            while (ip > anchor && ref > src && ip[-1] == ref[-1])
+            {
+                --ip;
+                --ref;
+            }
+
+            if (!writeSequence(ip, static_cast<size_t>(ip - ref), static_cast<size_t>(matchEnd - ip))) return 0;
+
+            ip = matchEnd;
+            anchor = ip;
+        }
+    }
+
+    // remaining bytes are written as literals
+    if (!writeSequence(iend, 0, 0)) return 0;
+
+    return static_cast<size_t>(op - dst);
+}
+
+bool LZ4Codec::decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) const
+{
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dstSize;
+
+    while (ip < iend)
+    {
+        uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !lz4_readLength(ip, iend, literalLength)) return false;
+        if (literalLength > static_cast<size_t>(iend - ip) || literalLength > static_cast<size_t>(oend - op)) return false;
+
+        std::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // the final sequence has no match
+        if (ip == iend) break;
+
+        if (iend - ip < 2) return false;
+        size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !lz4_readLength(ip, iend, matchLength)) return false;
+        matchLength += lz4_minMatch;
+        if (matchLength > static_cast<size_t>(oend - op)) return false;
+
+        // copy byte by byte as the match may overlap the bytes being written
+        const uint8_t* match = op - offset;
+        for (size_t i = 0; i < matchLength; ++i) *op++ = *match++;
+    }
+
+    return op == oend;
+}
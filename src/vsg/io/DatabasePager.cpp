@@ -10,19 +10,130 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/commands/BindIndexBuffer.h>
+#include <vsg/commands/BindVertexBuffers.h>
 #include <vsg/io/DatabasePager.h>
 #include <vsg/io/Logger.h>
 #include <vsg/io/ReaderWriter.h>
 #include <vsg/io/read.h>
+#include <vsg/nodes/Geometry.h>
+#include <vsg/nodes/StateGroup.h>
+#include <vsg/nodes/VertexDraw.h>
+#include <vsg/nodes/VertexIndexDraw.h>
+#include <vsg/state/DescriptorBuffer.h>
+#include <vsg/state/DescriptorImage.h>
 #include <vsg/threading/atomics.h>
 #include <vsg/ui/ApplicationEvent.h>
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <set>
+
 using namespace vsg;
 
 /////////////////////////////////////////////////////////////////////////
 //
 // DatabasePager
 //
+namespace
+{
+    // frame the PagedLOD's high res child was last visible, or predicted to become visible
+    uint64_t lastRequired(const PagedLOD& plod)
+    {
+        return std::max(plod.frameHighResLastUsed.load(), plod.frameHighResLastPredicted.load());
+    }
+
+    // accumulate the CPU memory used by the Data, and the GPU memory used by the buffers and images, of a compiled subgraph.
+    // GPU memory is only measured for deviceID 0.
+    class CollectMemoryUsage : public ConstVisitor
+    {
+    public:
+        uint64_t cpuMemoryUsage = 0;
+        uint64_t gpuMemoryUsage = 0;
+
+        void apply(const Object& object) override
+        {
+            object.traverse(*this);
+        }
+
+        void apply(const StateGroup& stateGroup) override
+        {
+            for (auto& stateCommand : stateGroup.stateCommands)
+            {
+                stateCommand->accept(*this);
+            }
+            stateGroup.traverse(*this);
+        }
+
+        void apply(const DescriptorBuffer& descriptorBuffer) override
+        {
+            for (auto& bufferInfo : descriptorBuffer.bufferInfoList) add(bufferInfo);
+        }
+
+        void apply(const DescriptorImage& descriptorImage) override
+        {
+            for (auto& imageInfo : descriptorImage.imageInfoList) add(imageInfo);
+        }
+
+        void apply(const Geometry& geometry) override
+        {
+            for (auto& array : geometry.arrays) add(array);
+            add(geometry.indices);
+        }
+
+        void apply(const VertexDraw& vertexDraw) override
+        {
+            for (auto& array : vertexDraw.arrays) add(array);
+        }
+
+        void apply(const VertexIndexDraw& vertexIndexDraw) override
+        {
+            for (auto& array : vertexIndexDraw.arrays) add(array);
+            add(vertexIndexDraw.indices);
+        }
+
+        void apply(const BindVertexBuffers& bindVertexBuffers) override
+        {
+            for (auto& array : bindVertexBuffers.arrays) add(array);
+        }
+
+        void apply(const BindIndexBuffer& bindIndexBuffer) override
+        {
+            add(bindIndexBuffer.indices);
+        }
+
+    protected:
+        std::set<const Object*> _visited;
+
+        bool firstVisit(const Object* object) { return object && _visited.insert(object).second; }
+
+        void add(const Data* data)
+        {
+            if (firstVisit(data)) cpuMemoryUsage += data->dataSize();
+        }
+
+        void add(const ref_ptr<BufferInfo>& bufferInfo)
+        {
+            if (!firstVisit(bufferInfo.get())) return;
+
+            add(bufferInfo->data.get());
+            if (bufferInfo->buffer) gpuMemoryUsage += bufferInfo->range;
+        }
+
+        void add(const ref_ptr<ImageInfo>& imageInfo)
+        {
+            if (!imageInfo || !imageInfo->imageView) return;
+
+            auto image = imageInfo->imageView->image.get();
+            if (!firstVisit(image)) return;
+
+            add(image->data.get());
+            if (image->vk(0)) gpuMemoryUsage += image->getMemoryRequirements(0).size;
+        }
+    };
+} // namespace
+
 DatabaseQueue::DatabaseQueue(ref_ptr<ActivityStatus> status) :
     _status(status)
 {
@@ -37,14 +148,16 @@ void DatabaseQueue::add(ref_ptr<PagedLOD> plod)
     // debug("DatabaseQueue::add(", plod,") status = ",plod->requestStatus.load());
 
     std::scoped_lock lock(_mutex);
-    _queue.emplace_back(plod);
+    _queue.push_back(Entry{plod->priority.load(), plod});
+    std::push_heap(_queue.begin(), _queue.end());
     _cv.notify_one();
 }
 
 void DatabaseQueue::add(ref_ptr<PagedLOD> plod, const CompileResult& cr)
 {
     std::scoped_lock lock(_mutex);
-    _queue.emplace_back(plod);
+    _queue.push_back(Entry{plod->priority.load(), plod});
+    std::push_heap(_queue.begin(), _queue.end());
     _cv.notify_one();
     _compileResult.add(cr);
 }
@@ -72,17 +185,10 @@ ref_ptr<PagedLOD> DatabaseQueue::take_when_available()
 
     // debug("DatabaseQueue::take_when_available() D ", _queue.size());
 
-    // find the PagedLOD with the highest priority;
-    auto itr = _queue.begin();
-    auto highest_itr = itr++;
-
-    for (; itr != _queue.end(); ++itr)
-    {
-        if ((*itr)->priority > (*highest_itr)->priority) highest_itr = itr;
-    }
-
-    ref_ptr<PagedLOD> plod = *highest_itr;
-    _queue.erase(highest_itr);
+    // the PagedLOD with the highest priority is at the top of the heap
+    std::pop_heap(_queue.begin(), _queue.end());
+    ref_ptr<PagedLOD> plod = std::move(_queue.back().plod);
+    _queue.pop_back();
 
     // debug("Returning ", plod.get(), std::dec, ", size = ", _queue.size());
     return plod;
@@ -92,16 +198,96 @@ DatabaseQueue::Nodes DatabaseQueue::take_all(CompileResult& cr)
 {
     std::scoped_lock lock(_mutex);
     Nodes nodes;
-    nodes.swap(_queue);
+    for (auto& entry : _queue)
+    {
+        nodes.emplace_back(std::move(entry.plod));
+    }
+    _queue.clear();
     cr.add(_compileResult);
     _compileResult.reset();
     return nodes;
 }
 
+DatabaseQueue::Nodes DatabaseQueue::update(uint64_t frameCount)
+{
+    std::scoped_lock lock(_mutex);
+
+    // remove PagedLOD that are no longer being used
+    Nodes expired;
+    auto itr = std::remove_if(_queue.begin(), _queue.end(), [&](Entry& entry) {
+        if ((frameCount - lastRequired(*entry.plod)) <= 1) return false;
+        expired.emplace_back(std::move(entry.plod));
+        return true;
+    });
+    bool rebuild = itr != _queue.end();
+    _queue.erase(itr, _queue.end());
+
+    // refresh priorities, an increased priority only needs the entry moved up the heap, sifting it up only swaps it with
+    // entries earlier in the heap that have already been visited so the rest of the pass is unaffected.
+    for (size_t i = 0; i < _queue.size(); ++i)
+    {
+        auto& entry = _queue[i];
+        double priority = entry.plod->priority.load();
+        if (priority == entry.priority) continue;
+
+        if (priority < entry.priority) rebuild = true;
+        entry.priority = priority;
+        if (!rebuild) siftUp(i);
+    }
+
+    if (rebuild) std::make_heap(_queue.begin(), _queue.end());
+
+    return expired;
+}
+
+void DatabaseQueue::siftUp(size_t index)
+{
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if (!(_queue[parent] < _queue[index])) break;
+
+        std::swap(_queue[parent], _queue[index]);
+        index = parent;
+    }
+}
+
+size_t DatabaseQueue::size() const
+{
+    std::scoped_lock lock(_mutex);
+    return _queue.size();
+}
+
 /////////////////////////////////////////////////////////////////////////
 //
 // DatabasePager
 //
+struct DatabasePager::FileData : public Object
+{
+    ref_ptr<PagedLOD> plod;
+    Path filename; // file found by the I/O thread, empty if the file couldn't be found
+    std::string buffer;
+};
+
+void DatabasePager::Statistics::add(uint64_t time)
+{
+    ++count;
+    totalTime += time;
+
+    uint64_t previous = maxTime.load();
+    while (time > previous && !maxTime.compare_exchange_weak(previous, time)) {}
+}
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    uint64_t nanosecondsSince(clock::time_point start)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+    }
+} // namespace
+
 DatabasePager::DatabasePager()
 {
     if (!_status) _status = ActivityStatus::create();
@@ -120,77 +306,260 @@ DatabasePager::~DatabasePager()
 
     _status->set(false);
 
-    for (auto& thread : _readThreads)
+    for (auto threads : {&_ioThreads, &_readThreads, &_compileThreads})
     {
-        thread.join();
+        for (auto& thread : *threads)
+        {
+            thread.join();
+        }
     }
 }
 
 void DatabasePager::start()
 {
-    int numReadThreads = 4;
+    if (numIOThreads > 0) _fileDataQueue = FileDataQueue::create(_status);
+    if (numCompileThreads > 0) _compileQueue = DatabaseQueue::create(_status);
 
     //
-    // set up read thread(s)
+    // set up the pipeline of I/O, read and compile thread(s), with the I/O and compile stages optional
     //
-    auto read = [](ref_ptr<DatabaseQueue> requestQueue, ref_ptr<ActivityStatus> status, DatabasePager& databasePager) {
-        debug("Started DatabaseThread read thread");
+    for (uint32_t i = 0; i < numIOThreads; ++i)
+    {
+        _ioThreads.emplace_back([this]() { runIOThread(); });
+    }
 
-        while (status->active())
+    for (uint32_t i = 0; i < std::max(numReadThreads, 1u); ++i)
+    {
+        _readThreads.emplace_back([this]() { runReadThread(); });
+    }
+
+    for (uint32_t i = 0; i < numCompileThreads; ++i)
+    {
+        _compileThreads.emplace_back([this]() { runCompileThread(); });
+    }
+}
+
+bool DatabasePager::beginRead(PagedLOD* plod)
+{
+    uint64_t frameDelta = frameCount - lastRequired(*plod);
+    if (frameDelta > 1 || !compare_exchange(plod->requestStatus, PagedLOD::ReadRequest, PagedLOD::Reading))
+    {
+        // debug("Expire read request");
+        requestDiscarded(plod);
+        return false;
+    }
+    return true;
+}
+
+ref_ptr<Object> DatabasePager::read(FileData& fileData)
+{
+    auto& plod = fileData.plod;
+    if (fileData.filename && !fileData.buffer.empty())
+    {
+        auto local_options = plod->options ? Options::create(*plod->options) : Options::create();
+        local_options->extensionHint = lowerCaseFileExtension(fileData.filename);
+        local_options->paths.insert(local_options->paths.begin(), filePath(fileData.filename));
+
+        auto data = reinterpret_cast<const uint8_t*>(fileData.buffer.data());
+        if (auto object = vsg::read(data, fileData.buffer.size(), local_options)) return object;
+    }
+
+    // couldn't be read from memory so fallback to reading from file
+    return vsg::read(plod->filename, plod->options);
+}
+
+void DatabasePager::compile(ref_ptr<PagedLOD> plod)
+{
+    auto startTime = clock::now();
+
+    ref_ptr<Node> subgraph;
+    {
+        std::scoped_lock<std::mutex> lock(pendingPagedLODMutex);
+        subgraph = plod->pending;
+    }
+
+    auto result = compileManager->compile(subgraph);
+
+    compileStatistics.add(nanosecondsSince(startTime));
+
+    if (result)
+    {
+        // record the memory used so updateSceneGraph can keep the loaded subgraphs within the memory budgets
+        CollectMemoryUsage collectMemoryUsage;
+        subgraph->accept(collectMemoryUsage);
+        plod->cpuMemoryUsage = collectMemoryUsage.cpuMemoryUsage;
+        plod->gpuMemoryUsage = collectMemoryUsage.gpuMemoryUsage;
+
+        plod->requestStatus.exchange(PagedLOD::MergeRequest);
+
+        // move to the merge queue;
+        _toMergeQueue->add(plod, result);
+    }
+    else
+    {
+        debug("Failed to compile ", plod, " ", plod->filename);
+        requestDiscarded(plod);
+    }
+}
+
+void DatabasePager::runIOThread()
+{
+    debug("Started DatabasePager I/O thread");
+
+    while (_status->active())
+    {
+        // apply back pressure when the read threads can't keep up
+        if (!waitUntil([&]() { return inFlightBytes.load() < maxInFlightBytes; })) break;
+
+        auto plod = _requestQueue->take_when_available();
+        if (!plod || !beginRead(plod)) continue;
+
+        auto startTime = clock::now();
+
+        ref_ptr<FileData> fileData(new FileData);
+        fileData->plod = plod;
+        fileData->filename = findFile(plod->filename, plod->options.get());
+        if (fileData->filename)
         {
-            auto plod = requestQueue->take_when_available();
-            if (plod)
+            std::ifstream fin(fileData->filename, std::ios::in | std::ios::binary);
+            if (fin)
             {
-                uint64_t frameDelta = databasePager.frameCount - plod->frameHighResLastUsed.load();
-                if (frameDelta > 1 || !compare_exchange(plod->requestStatus, PagedLOD::ReadRequest, PagedLOD::Reading))
-                {
-                    // debug("Expire read request");
-                    databasePager.requestDiscarded(plod);
-                    continue;
-                }
+                fin.seekg(0, fin.end);
+                auto fileSize = static_cast<size_t>(fin.tellg());
+                fin.seekg(0);
 
-                auto read_object = vsg::read(plod->filename, plod->options);
-                auto subgraph = read_object.cast<Node>();
+                fileData->buffer.resize(fileSize);
+                fin.read(fileData->buffer.data(), fileSize);
+                if (!fin) fileData->buffer.clear();
+            }
+        }
 
-                if (subgraph && compare_exchange(plod->requestStatus, PagedLOD::Reading, PagedLOD::Compiling))
-                {
-                    {
-                        std::scoped_lock<std::mutex> lock(databasePager.pendingPagedLODMutex);
-                        plod->pending = subgraph;
-                    }
-
-                    // compile plod
-                    if (auto result = databasePager.compileManager->compile(subgraph))
-                    {
-                        plod->requestStatus.exchange(PagedLOD::MergeRequest);
-
-                        // move to the merge queue;
-                        databasePager._toMergeQueue->add(plod, result);
-                    }
-                    else
-                    {
-                        debug("Failed to compile ", plod, " ", plod->filename);
-                        databasePager.requestDiscarded(plod);
-                    }
-                }
-                else
-                {
-                    if (auto read_error = read_object.cast<ReadError>())
-                        warn(read_error->message);
-                    else
-                        warn("Failed to read ", plod, " ", plod->filename);
+        ioStatistics.add(nanosecondsSince(startTime));
 
-                    databasePager.requestDiscarded(plod);
-                }
+        inFlightBytes += fileData->buffer.size();
+        _fileDataQueue->add(fileData);
+    }
+
+    debug("Finished DatabasePager I/O thread");
+}
+
+void DatabasePager::runReadThread()
+{
+    debug("Started DatabasePager read thread");
+
+    while (_status->active())
+    {
+        // apply back pressure when the compile threads can't keep up
+        if (_compileQueue && !waitUntil([&]() { return _compileQueue->size() < maxCompileQueueSize; })) break;
+
+        ref_ptr<PagedLOD> plod;
+        ref_ptr<Object> read_object;
+        auto startTime = clock::now();
+
+        if (_fileDataQueue)
+        {
+            auto fileData = _fileDataQueue->take_when_available();
+            if (!fileData) continue;
+
+            startTime = clock::now();
+            plod = fileData->plod;
+            read_object = read(*fileData);
+
+            inFlightBytes -= fileData->buffer.size();
+            notifyWaiting();
+        }
+        else
+        {
+            plod = _requestQueue->take_when_available();
+            if (!plod || !beginRead(plod)) continue;
+
+            startTime = clock::now();
+            read_object = vsg::read(plod->filename, plod->options);
+        }
+
+        readStatistics.add(nanosecondsSince(startTime));
+
+        auto subgraph = read_object.cast<Node>();
+        if (subgraph && compare_exchange(plod->requestStatus, PagedLOD::Reading, PagedLOD::Compiling))
+        {
+            {
+                std::scoped_lock<std::mutex> lock(pendingPagedLODMutex);
+                plod->pending = subgraph;
             }
+
+            if (_compileQueue)
+                _compileQueue->add(plod);
+            else
+                compile(plod);
         }
-        debug("Finished DatabaseThread read thread");
-    };
+        else
+        {
+            if (auto read_error = read_object.cast<ReadError>())
+                warn(read_error->message);
+            else
+                warn("Failed to read ", plod, " ", plod->filename);
+
+            requestDiscarded(plod);
+        }
+    }
+
+    debug("Finished DatabasePager read thread");
+}
+
+void DatabasePager::runCompileThread()
+{
+    debug("Started DatabasePager compile thread");
+
+    while (_status->active())
+    {
+        auto plod = _compileQueue->take_when_available();
+        if (!plod) continue;
+
+        notifyWaiting();
+        compile(plod);
+    }
+
+    debug("Finished DatabasePager compile thread");
+}
+
+bool DatabasePager::waitUntil(const std::function<bool()>& predicate)
+{
+    std::unique_lock lock(_waitMutex);
+    while (_status->active() && !predicate())
+    {
+        _waitCV.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    return _status->active();
+}
 
-    for (int i = 0; i < numReadThreads; ++i)
+void DatabasePager::notifyWaiting()
+{
+    // lock the mutex to avoid the notification being lost between a waiting thread checking its predicate and waiting
     {
-        _readThreads.emplace_back(read, std::ref(_requestQueue), std::ref(_status), std::ref(*this));
+        std::scoped_lock lock(_waitMutex);
     }
+    _waitCV.notify_all();
+}
+
+void DatabasePager::report(std::ostream& out) const
+{
+    auto reportStage = [&](const char* name, const Statistics& statistics) {
+        out << "    " << name << " count = " << statistics.count << ", average = " << statistics.averageTime() << "ms, max = " << static_cast<double>(statistics.maxTime) * 1e-6 << "ms" << std::endl;
+    };
+
+    out << "DatabasePager::report() numActiveRequests = " << numActiveRequests << std::endl;
+    out << "    numHighResHits = " << numHighResHits << ", numHighResMisses = " << numHighResMisses;
+    if (prefetch) out << ", numPrefetchRequests = " << numPrefetchRequests << ", numPrefetchDiscarded = " << numPrefetchDiscarded;
+    out << std::endl;
+    out << "    totalCPUMemoryUsage = " << totalCPUMemoryUsage << ", totalGPUMemoryUsage = " << totalGPUMemoryUsage << std::endl;
+    out << "    request queue size = " << _requestQueue->size();
+    if (_fileDataQueue) out << ", file data queue size = " << _fileDataQueue->size() << ", inFlightBytes = " << inFlightBytes;
+    if (_compileQueue) out << ", compile queue size = " << _compileQueue->size();
+    out << std::endl;
+
+    if (!_ioThreads.empty()) reportStage("I/O", ioStatistics);
+    reportStage("read", readStatistics);
+    reportStage("compile", compileStatistics);
 }
 
 void DatabasePager::request(ref_ptr<PagedLOD> plod)
@@ -235,6 +604,13 @@ void DatabasePager::updateSceneGraph(FrameStamp* frameStamp, CompileResult& cr)
 {
     frameCount.exchange(frameStamp ? frameStamp->frameCount : 0);
 
+    // reprioritize the pending read requests and discard those no longer required in one pass, rather than leaving it to the read threads
+    for (auto& plod : _requestQueue->update(frameCount))
+    {
+        if (plod->frameHighResLastPredicted > plod->frameHighResLastUsed) ++numPrefetchDiscarded;
+        requestDiscarded(plod);
+    }
+
     auto nodes = _toMergeQueue->take_all(cr);
 
     if (culledPagedLODs)
@@ -279,31 +655,69 @@ void DatabasePager::updateSceneGraph(FrameStamp* frameStamp, CompileResult& cr)
 
         culledPagedLODs->clear();
 
-        // set the number of PagedLOD to expire
+        // work out how many PagedLOD high res subgraphs, and how much memory, to release to keep within the targets once the new nodes are merged
         uint32_t total = pagedLODContainer->activeList.count + pagedLODContainer->inactiveList.count;
 
         debug("DatabasePager : activeList.count = ", pagedLODContainer->activeList.count, ", inactiveList.count = ", pagedLODContainer->inactiveList.count, ", total = ", total);
 
-        if ((nodes.size() + total) > targetMaxNumPagedLODWithHighResSubgraphs)
+        uint64_t pendingCPUMemory = totalCPUMemoryUsage;
+        uint64_t pendingGPUMemory = totalGPUMemoryUsage;
+        for (auto& plod : nodes)
+        {
+            pendingCPUMemory += plod->cpuMemoryUsage;
+            pendingGPUMemory += plod->gpuMemoryUsage;
+        }
+
+        uint32_t numPagedLODHighRestSubgraphsToRemove = ((nodes.size() + total) > targetMaxNumPagedLODWithHighResSubgraphs) ? ((static_cast<uint32_t>(nodes.size()) + total) - targetMaxNumPagedLODWithHighResSubgraphs) : 0;
+        uint64_t cpuMemoryToRelease = (targetMaxCPUMemory > 0 && pendingCPUMemory > targetMaxCPUMemory) ? (pendingCPUMemory - targetMaxCPUMemory) : 0;
+        uint64_t gpuMemoryToRelease = (targetMaxGPUMemory > 0 && pendingGPUMemory > targetMaxGPUMemory) ? (pendingGPUMemory - targetMaxGPUMemory) : 0;
+
+        if (numPagedLODHighRestSubgraphsToRemove > 0 || cpuMemoryToRelease > 0 || gpuMemoryToRelease > 0)
         {
-            uint32_t numPagedLODHighRestSubgraphsToRemove = (static_cast<uint32_t>(nodes.size()) + total) - targetMaxNumPagedLODWithHighResSubgraphs;
-            uint32_t targetNumInactive = (numPagedLODHighRestSubgraphsToRemove < pagedLODContainer->inactiveList.count) ? (pagedLODContainer->inactiveList.count - numPagedLODHighRestSubgraphsToRemove) : 0;
+            debug("Need to remove, inactive count = ", pagedLODContainer->inactiveList.count, ", num to remove = ", numPagedLODHighRestSubgraphsToRemove, ", cpuMemoryToRelease = ", cpuMemoryToRelease, ", gpuMemoryToRelease = ", gpuMemoryToRelease);
 
-            debug("Need to remove, inactive count = ", pagedLODContainer->inactiveList.count, ", target = ", targetNumInactive);
+            // rank the inactive high res subgraphs so the least recently used and most distant are expired first
+            struct Candidate
+            {
+                double cost;
+                PagedLOD* plod;
 
-            for (uint32_t index = pagedLODContainer->inactiveList.head; (index != 0) && (pagedLODContainer->inactiveList.count > targetNumInactive);)
+                bool operator<(const Candidate& rhs) const { return cost > rhs.cost; }
+            };
+
+            std::vector<Candidate> candidates;
+            candidates.reserve(pagedLODContainer->inactiveList.count);
+            for (uint32_t index = pagedLODContainer->inactiveList.head; index != 0; index = elements[index].next)
             {
-                auto& element = elements[index];
-                index = element.next;
+                auto plod = elements[index].plod.get();
+                double age = static_cast<double>(frameCount - std::min(lastRequired(*plod), frameCount.load()));
+                double distance = plod->bound.r > 0.0 ? (plod->lastLodDistance.load() / plod->bound.r) : 0.0;
+                candidates.push_back(Candidate{age + expiryDistanceWeight * distance, plod});
+            }
+            std::sort(candidates.begin(), candidates.end());
 
-                if (compare_exchange(element.plod->requestStatus, PagedLOD::NoRequest, PagedLOD::DeleteRequest))
+            for (auto& candidate : candidates)
+            {
+                if (numPagedLODHighRestSubgraphsToRemove == 0 && cpuMemoryToRelease == 0 && gpuMemoryToRelease == 0) break;
+
+                if (compare_exchange(candidate.plod->requestStatus, PagedLOD::NoRequest, PagedLOD::DeleteRequest))
                 {
-                    ref_ptr<PagedLOD> plod = element.plod;
+                    ref_ptr<PagedLOD> plod(candidate.plod);
                     plod->children[0].node = nullptr;
                     plod->requestCount.exchange(0);
                     plod->requestStatus.exchange(PagedLOD::NoRequest);
                     plod->pending = {};
                     pagedLODContainer->remove(plod);
+
+                    if (numPagedLODHighRestSubgraphsToRemove > 0) --numPagedLODHighRestSubgraphsToRemove;
+                    cpuMemoryToRelease -= std::min(cpuMemoryToRelease, plod->cpuMemoryUsage);
+                    gpuMemoryToRelease -= std::min(gpuMemoryToRelease, plod->gpuMemoryUsage);
+
+                    totalCPUMemoryUsage -= std::min(totalCPUMemoryUsage.load(), plod->cpuMemoryUsage);
+                    totalGPUMemoryUsage -= std::min(totalGPUMemoryUsage.load(), plod->gpuMemoryUsage);
+                    plod->cpuMemoryUsage = 0;
+                    plod->gpuMemoryUsage = 0;
+
                     debug("    trimming ", plod, " ", plod->filename);
                 }
             }
@@ -331,6 +745,12 @@ void DatabasePager::updateSceneGraph(FrameStamp* frameStamp, CompileResult& cr)
                     plod->children[0].node = plod->pending;
                 }
 
+                totalCPUMemoryUsage += plod->cpuMemoryUsage;
+                totalGPUMemoryUsage += plod->gpuMemoryUsage;
+
+                // prefetched PagedLOD that haven't been visible yet need to be tracked so they can be expired
+                if (plod->index == 0 && pagedLODContainer) pagedLODContainer->inactive(plod);
+
                 plod->requestStatus.exchange(PagedLOD::NoRequest);
             }
         }
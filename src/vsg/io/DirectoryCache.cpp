@@ -0,0 +1,112 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/DirectoryCache.h>
+#include <vsg/io/FileSystem.h>
+
+#include <cwctype>
+
+using namespace vsg;
+
+static DirectoryCache::Key makeKey(Path::string_type str)
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    // Windows file systems are case insensitive
+    for (auto& c : str) c = static_cast<Path::value_type>(std::towlower(c));
+#endif
+    return str;
+}
+
+DirectoryCache::DirectoryCache()
+{
+}
+
+DirectoryCache::~DirectoryCache()
+{
+}
+
+std::shared_ptr<const DirectoryCache::Contents> DirectoryCache::_getContents(const Key& directory)
+{
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        if (auto itr = _directories.find(directory); itr != _directories.end()) return itr->second;
+    }
+
+    // list the directory without holding the lock so that slow file systems don't stall other threads
+    auto contents = std::make_shared<Contents>();
+    for (auto& entry : getDirectoryContents(directory))
+    {
+        contents->insert(makeKey(entry.native()));
+    }
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _directories.emplace(directory, contents).first->second;
+}
+
+bool DirectoryCache::fileExists(const Path& path)
+{
+    auto& str = path.native();
+    auto pos = str.find_last_of(Path::separators);
+
+    Key name = (pos == Key::npos) ? str : str.substr(pos + 1);
+    if (name.empty() || name == Key(1, '.') || name == Key(2, '.'))
+    {
+        // trailing separators and relative directory references can't be looked up in the directory contents
+        return vsg::fileExists(path);
+    }
+
+    Key directory;
+    if (pos == Key::npos)
+        directory = Key(1, '.');
+    else if (pos == 0)
+        directory = str.substr(0, 1);
+    else
+        directory = str.substr(0, pos);
+
+    auto contents = _getContents(makeKey(directory));
+    return contents->count(makeKey(name)) != 0;
+}
+
+Path DirectoryCache::findFile(const Path& filename, const Paths& paths)
+{
+    for (auto& path : paths)
+    {
+        Path fullpath = path / filename;
+        if (fileExists(fullpath))
+        {
+            return fullpath;
+        }
+    }
+    return {};
+}
+
+void DirectoryCache::invalidate(const Path& directory)
+{
+    // match the directory keys used by fileExists(..), which don't have trailing separators
+    Key key = directory.native();
+    while (key.size() > 1 && Key(Path::separators).find(key.back()) != Key::npos) key.pop_back();
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _directories.erase(makeKey(key));
+}
+
+void DirectoryCache::clear()
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _directories.clear();
+}
+
+size_t DirectoryCache::size() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _directories.size();
+}
@@ -10,6 +10,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/io/DirectoryCache.h>
 #include <vsg/io/FileSystem.h>
 #include <vsg/io/Logger.h>
 #include <vsg/io/Options.h>
@@ -142,6 +143,39 @@ bool vsg::fileExists(const Path& path)
 #endif
 }
 
+int64_t vsg::fileModificationTime(const Path& path)
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    struct __stat64 stbuf;
+    if (_wstat64(path.c_str(), &stbuf) != 0) return 0;
+#elif defined(__APPLE__)
+    struct stat stbuf;
+    if (stat(path.c_str(), &stbuf) != 0) return 0;
+#else
+    struct stat64 stbuf;
+    if (stat64(path.c_str(), &stbuf) != 0) return 0;
+#endif
+    return static_cast<int64_t>(stbuf.st_mtime);
+}
+
+bool vsg::renameFile(const Path& oldPath, const Path& newPath)
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    return MoveFileExW(oldPath.c_str(), newPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return ::rename(oldPath.c_str(), newPath.c_str()) == 0;
+#endif
+}
+
+bool vsg::removeFile(const Path& path)
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    return _wremove(path.c_str()) == 0;
+#else
+    return ::remove(path.c_str()) == 0;
+#endif
+}
+
 Path vsg::findFile(const Path& filename, const Paths& paths)
 {
     for (auto path : paths)
@@ -162,20 +196,26 @@ Path vsg::findFile(const Path& filename, const Options* options)
         // if Options has a findFileCallback use it
         if (options->findFileCallback) return options->findFileCallback(filename, options);
 
+        // if Options has a DirectoryCache use its cached directory contents to check files exist
+        auto& directoryCache = options->directoryCache;
+        auto exists = [&](const Path& path) { return directoryCache ? directoryCache->fileExists(path) : fileExists(path); };
+
         if (!options->paths.empty())
         {
             // if appropriate use the filename directly if it exists.
-            if (options->checkFilenameHint == Options::CHECK_ORIGINAL_FILENAME_EXISTS_FIRST && fileExists(filename)) return filename;
+            if (options->checkFilenameHint == Options::CHECK_ORIGINAL_FILENAME_EXISTS_FIRST && exists(filename)) return filename;
 
             // search for the file in the options specific paths.
-            if (auto path = findFile(filename, options->paths)) return path;
+            if (auto path = directoryCache ? directoryCache->findFile(filename, options->paths) : findFile(filename, options->paths)) return path;
 
             // if appropriate use the filename directly if it exists.
-            if (options->checkFilenameHint == Options::CHECK_ORIGINAL_FILENAME_EXISTS_LAST && fileExists(filename))
+            if (options->checkFilenameHint == Options::CHECK_ORIGINAL_FILENAME_EXISTS_LAST && exists(filename))
                 return filename;
             else
                 return {};
         }
+
+        return exists(filename) ? filename : Path();
     }
 
     return fileExists(filename) ? filename : Path();
@@ -171,6 +171,7 @@ ObjectFactory::ObjectFactory()
     add<vsg::QuadGroup>();
     add<vsg::StateGroup>();
     add<vsg::CullGroup>();
+    add<vsg::BatchCullGroup>();
     add<vsg::CullNode>();
     add<vsg::LOD>();
     add<vsg::PagedLOD>();
@@ -179,6 +180,7 @@ ObjectFactory::ObjectFactory()
     add<vsg::Geometry>();
     add<vsg::VertexDraw>();
     add<vsg::VertexIndexDraw>();
+    add<vsg::CulledInstanceDraw>();
     add<vsg::Bin>();
     add<vsg::DepthSorted>();
     add<vsg::Switch>();
@@ -319,3 +321,9 @@ vsg::ref_ptr<vsg::Object> ObjectFactory::create(const std::string& className)
     warn("ObjectFactory::create(", className, ") failed to find means to create object");
     return vsg::ref_ptr<vsg::Object>();
 }
+
+ObjectFactory::CreateFunction ObjectFactory::getCreateFunction(const std::string& className) const
+{
+    if (auto itr = _createMap.find(className); itr != _createMap.end()) return itr->second;
+    return {};
+}
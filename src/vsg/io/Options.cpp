@@ -11,6 +11,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 </editor-fold> */
 
 #include <vsg/io/Options.h>
+#include <vsg/io/DirectoryCache.h>
 #include <vsg/io/ReaderWriter.h>
 #include <vsg/state/DescriptorSetLayout.h>
 #include <vsg/threading/OperationThreads.h>
@@ -39,6 +40,7 @@ Options::Options(const Options& options) :
     checkFilenameHint(options.checkFilenameHint),
     paths(options.paths),
     findFileCallback(options.findFileCallback),
+    directoryCache(options.directoryCache),
     fileCache(options.fileCache),
     extensionHint(options.extensionHint),
     mapRGBtoRGBAHint(options.mapRGBtoRGBAHint),
@@ -164,6 +166,11 @@ bool Options::readOptions(CommandLine& arguments)
     }
 
     if (arguments.read("--file-cache", fileCache)) read = true;
+    if (arguments.read("--directory-cache"))
+    {
+        directoryCache = DirectoryCache::create();
+        read = true;
+    }
     if (arguments.read("--extension-hint", extensionHint)) read = true;
 
     return read;
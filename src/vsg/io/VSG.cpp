@@ -16,8 +16,14 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/io/BinaryInput.h>
 #include <vsg/io/BinaryOutput.h>
 #include <vsg/io/Logger.h>
+#include <vsg/io/MappedFile.h>
 #include <vsg/io/VSG.h>
+#include <vsg/io/compressed_stream.h>
 #include <vsg/io/mem_stream.h>
+#include <vsg/threading/TaskGroup.h>
+#include <vsg/utils/CommandLine.h>
+
+#include <algorithm>
 
 using namespace vsg;
 
@@ -48,7 +54,7 @@ VSG::VSG() :
 {
 }
 
-VSG::FormatInfo VSG::readHeader(std::istream& fin) const
+VSG::FormatInfo VSG::readHeader(std::istream& fin, BinaryHeader* binaryHeader) const
 {
     fin.imbue(s_class_locale);
 
@@ -72,23 +78,274 @@ VSG::FormatInfo VSG::readHeader(std::istream& fin) const
     std::string version_string;
     std::getline(fin, version_string);
 
+    if (binaryHeader)
+    {
+        *binaryHeader = {};
+        if (type == BINARY)
+        {
+            if (auto pos = version_string.find(" alignment "); pos != std::string::npos)
+            {
+                std::stringstream str(version_string.substr(pos + 11));
+                str >> binaryHeader->alignment;
+            }
+
+            if (auto pos = version_string.find(" codec "); pos != std::string::npos)
+            {
+                std::stringstream str(version_string.substr(pos + 7));
+                str >> binaryHeader->codec;
+            }
+
+            binaryHeader->indexed = version_string.find(" index") != std::string::npos;
+            binaryHeader->classIDs = version_string.find(" class_ids") != std::string::npos;
+        }
+    }
+
     auto version = parseVersion(version_string);
 
     return FormatInfo(type, version);
 }
 
-void VSG::writeHeader(std::ostream& fout, const FormatInfo& formatInfo) const
+void VSG::writeHeader(std::ostream& fout, const FormatInfo& formatInfo, const BinaryHeader& binaryHeader) const
 {
     if (formatInfo.first == NOT_RECOGNIZED) return;
 
     fout.imbue(s_class_locale);
+
+    std::stringstream header;
+    header.imbue(s_class_locale);
     if (formatInfo.first == BINARY)
-        fout << "#vsgb";
+        header << "#vsgb";
     else
-        fout << "#vsga";
+        header << "#vsga";
 
     auto version = formatInfo.second;
-    fout << " " << version.major << "." << version.minor << "." << version.patch << "\n";
+    header << " " << version.major << "." << version.minor << "." << version.patch;
+
+    std::string header_string = header.str();
+    if (formatInfo.first == BINARY)
+    {
+        if (binaryHeader.classIDs) header_string += " class_ids";
+        if (!binaryHeader.codec.empty()) header_string += " codec " + binaryHeader.codec;
+        if (binaryHeader.indexed) header_string += " index";
+
+        if (auto alignment = binaryHeader.alignment; alignment > 1)
+        {
+            // declare the alignment and pad the header so that the data following it starts on an aligned boundary
+            header_string += " alignment " + std::to_string(alignment);
+            size_t length = header_string.size() + 1;
+            header_string.append((alignment - (length % alignment)) % alignment, ' ');
+        }
+    }
+
+    fout << header_string << "\n";
+}
+
+ref_ptr<Object> VSG::_readBinary(std::istream& fin, ref_ptr<const Options> options, const Path& filename, const VsgVersion& version, const BinaryHeader& binaryHeader, const OpenPayload& openPayload) const
+{
+    ref_ptr<CompressionCodec> compressionCodec;
+    if (!binaryHeader.codec.empty())
+    {
+        compressionCodec = CompressionCodec::find(binaryHeader.codec);
+        if (!compressionCodec)
+        {
+            warn("VSG::read() compression codec \"", binaryHeader.codec, "\" not supported, unable to read ", filename);
+            return {};
+        }
+    }
+
+    std::unique_ptr<compressed_istream> cfin;
+    if (compressionCodec) cfin.reset(new compressed_istream(fin, compressionCodec));
+    std::istream& payload = cfin ? *cfin : fin;
+
+    vsg::BinaryInput input(payload, _objectFactory, options);
+    input.filename = filename;
+    input.version = version;
+    input.alignment = binaryHeader.alignment;
+    input.classIDs = binaryHeader.classIDs;
+
+    if (binaryHeader.indexed && openPayload && options && options->operationThreads)
+    {
+        _readIndexedObjects(input, payload, compressionCodec, openPayload);
+    }
+
+    return input.readObject("Root");
+}
+
+static bool readClassNames(std::istream& fin, std::vector<std::string>& classNames)
+{
+    // limits well beyond any real class table, so corrupt files can't cause huge allocations
+    const uint32_t maxNumClasses = 65536;
+    const uint32_t maxClassNameLength = 1024;
+
+    uint32_t count = 0;
+    if (!fin.read(reinterpret_cast<char*>(&count), sizeof(count)) || count > maxNumClasses) return false;
+
+    for (uint32_t i = 0; i < count && fin; ++i)
+    {
+        uint32_t size = 0;
+        if (!fin.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > maxClassNameLength) return false;
+
+        std::string name(size, 0);
+        fin.read(name.data(), size);
+        classNames.push_back(name);
+    }
+    return static_cast<bool>(fin);
+}
+
+void VSG::_readIndexedObjects(BinaryInput& input, std::istream& payload, ref_ptr<const CompressionCodec> codec, const OpenPayload& openPayload) const
+{
+    // the index follows the root object, with its position at the very end of the payload
+    using IndexEntry = BinaryOutput::IndexEntry;
+    std::vector<IndexEntry> index;
+    std::vector<std::string> classNames;
+    {
+        auto start = payload.tellg();
+        uint64_t indexPosition = 0;
+        uint64_t count = 0;
+        if (start != std::streampos(-1) &&
+            payload.seekg(-static_cast<std::streamoff>(sizeof(indexPosition)), std::ios_base::end) &&
+            payload.read(reinterpret_cast<char*>(&indexPosition), sizeof(indexPosition)) &&
+            payload.seekg(start + static_cast<std::streamoff>(indexPosition)) &&
+            payload.read(reinterpret_cast<char*>(&count), sizeof(count)) &&
+            count <= indexPosition / sizeof(IndexEntry))
+        {
+            index.resize(count);
+            if (!payload.read(reinterpret_cast<char*>(index.data()), count * sizeof(IndexEntry))) index.clear();
+
+            // the class names are needed up front as indexed objects may use classes first defined before them
+            if (input.classIDs && !readClassNames(payload, classNames)) index.clear();
+        }
+
+        payload.clear();
+        payload.seekg(start);
+    }
+
+    if (index.empty()) return;
+
+    // the sequential read skips the preread objects along with the class names first used within them
+    for (uint32_t classID = 0; classID < classNames.size(); ++classID)
+    {
+        input.assignClass(classID, classNames[classID]);
+    }
+
+    struct ReadIndexedObject : public Operation
+    {
+        ReadIndexedObject(ref_ptr<ObjectFactory> in_objectFactory, const BinaryInput& in_input, const std::vector<std::string>& in_classNames, ref_ptr<const CompressionCodec> in_codec, const OpenPayload& in_openPayload, const IndexEntry& in_entry, BinaryInput::PrereadObject& in_result) :
+            objectFactory(in_objectFactory),
+            input(in_input),
+            classNames(in_classNames),
+            codec(in_codec),
+            openPayload(in_openPayload),
+            entry(in_entry),
+            result(in_result) {}
+
+        void run() override
+        {
+            auto source = openPayload();
+            if (!source) return;
+
+            std::unique_ptr<compressed_istream> decompressed;
+            if (codec) decompressed.reset(new compressed_istream(*source, codec));
+            std::istream& stream = decompressed ? *decompressed : *source;
+
+            BinaryInput indexedInput(stream, objectFactory, input.options);
+            indexedInput.filename = input.filename;
+            indexedInput.version = input.version;
+            indexedInput.alignment = input.alignment;
+            indexedInput.mappedFile = input.mappedFile;
+            indexedInput.mappedOffset = input.mappedOffset;
+            indexedInput.classIDs = input.classIDs;
+            for (uint32_t classID = 0; classID < classNames.size(); ++classID)
+            {
+                indexedInput.assignClass(classID, classNames[classID]);
+            }
+
+            indexedInput.setPosition(entry.begin);
+            if (indexedInput.read() && indexedInput.getPosition() == entry.end)
+            {
+                result.objectIDMap = std::move(indexedInput.objectIDMap);
+                result.end = entry.end;
+            }
+        }
+
+        ref_ptr<ObjectFactory> objectFactory;
+        const BinaryInput& input;
+        const std::vector<std::string>& classNames;
+        ref_ptr<const CompressionCodec> codec;
+        const OpenPayload& openPayload;
+        const IndexEntry& entry;
+        BinaryInput::PrereadObject& result;
+    };
+
+    std::vector<BinaryInput::PrereadObject> results(index.size());
+
+    // read the indexed objects in parallel, using this thread as well
+    auto taskGroup = TaskGroup::create(input.options->operationThreads);
+    for (size_t i = 0; i < index.size(); ++i)
+    {
+        taskGroup->run(ref_ptr<Operation>(new ReadIndexedObject(_objectFactory, input, classNames, codec, openPayload, index[i], results[i])));
+    }
+    taskGroup->wait();
+
+    // objects that failed to read are left for the sequential read
+    for (size_t i = 0; i < index.size(); ++i)
+    {
+        if (results[i].end > 0) input.prereadObjects[static_cast<BinaryInput::ObjectID>(index[i].id)] = std::move(results[i]);
+    }
+}
+
+bool VSG::_writeBinary(const Object* object, std::ostream& fout, ref_ptr<const Options> options, const VsgVersion& version, uint32_t alignment) const
+{
+    std::string codec;
+    uint32_t blockSize = 262144;
+    uint32_t indexThreshold = 0;
+    bool classIDs = false;
+    if (options)
+    {
+        options->getValue(VSG::compression_codec, codec);
+        options->getValue(VSG::compression_block_size, blockSize);
+        options->getValue(VSG::index_threshold, indexThreshold);
+        options->getValue(VSG::class_ids, classIDs);
+    }
+
+    ref_ptr<CompressionCodec> compressionCodec;
+    if (!codec.empty())
+    {
+        compressionCodec = CompressionCodec::find(codec);
+        if (!compressionCodec)
+        {
+            warn("VSG::write() compression codec \"", codec, "\" not supported.");
+            return false;
+        }
+    }
+
+    BinaryHeader binaryHeader;
+    binaryHeader.alignment = alignment;
+    binaryHeader.codec = codec;
+    binaryHeader.indexed = indexThreshold > 0;
+    binaryHeader.classIDs = classIDs;
+    writeHeader(fout, FormatInfo{BINARY, version}, binaryHeader);
+
+    auto writeRoot = [&](std::ostream& payload) {
+        vsg::BinaryOutput output(payload, options);
+        output.version = version;
+        output.alignment = alignment;
+        output.indexThreshold = indexThreshold;
+        output.classIDs = classIDs;
+        output.writeObject("Root", object);
+        if (indexThreshold > 0) output.writeIndex();
+    };
+
+    if (!compressionCodec)
+    {
+        writeRoot(fout);
+        return fout.good();
+    }
+
+    compressed_ostream cfout(fout, compressionCodec, blockSize);
+    writeRoot(cfout);
+    cfout.finish();
+    return cfout.good();
 }
 
 vsg::ref_ptr<vsg::Object> VSG::read(const vsg::Path& filename, ref_ptr<const Options> options) const
@@ -98,16 +355,65 @@ vsg::ref_ptr<vsg::Object> VSG::read(const vsg::Path& filename, ref_ptr<const Opt
     vsg::Path filenameToUse = findFile(filename, options);
     if (!filenameToUse) return {};
 
+    return readFile(filenameToUse, options);
+}
+
+vsg::ref_ptr<vsg::Object> VSG::readFile(const vsg::Path& filenameToUse, ref_ptr<const Options> options) const
+{
+    bool mapFile = false;
+    if (options) options->getValue(VSG::map_file, mapFile);
+
+    if (mapFile)
+    {
+        auto mappedFile = MappedFile::create(filenameToUse);
+        if (mappedFile->valid())
+        {
+            mem_stream fin(mappedFile->data(), mappedFile->size());
+
+            // compressed files can't reference array values in place so are read via the std::ifstream below
+            BinaryHeader binaryHeader;
+            auto [type, version] = readHeader(fin, &binaryHeader);
+            if (type == BINARY && binaryHeader.codec.empty())
+            {
+                auto headerEnd = std::find(mappedFile->data(), mappedFile->data() + mappedFile->size(), '\n');
+
+                vsg::BinaryInput input(fin, _objectFactory, options);
+                input.filename = filenameToUse;
+                input.version = version;
+                input.alignment = binaryHeader.alignment;
+                input.classIDs = binaryHeader.classIDs;
+                input.mappedFile = mappedFile;
+                input.mappedOffset = static_cast<size_t>(headerEnd - mappedFile->data()) + 1;
+
+                if (binaryHeader.indexed && options->operationThreads)
+                {
+                    auto openPayload = [&]() -> std::unique_ptr<std::istream> {
+                        return std::make_unique<mem_stream>(mappedFile->data() + input.mappedOffset, mappedFile->size() - input.mappedOffset);
+                    };
+                    _readIndexedObjects(input, fin, {}, openPayload);
+                }
+
+                // arrays referencing the mapped file hold a reference to it, keeping it mapped for as long as they need it
+                return input.readObject("Root");
+            }
+        }
+    }
+
     std::ifstream fin(filenameToUse, std::ios::in | std::ios::binary);
     if (!fin) return {};
 
-    auto [type, version] = readHeader(fin);
+    BinaryHeader binaryHeader;
+    auto [type, version] = readHeader(fin, &binaryHeader);
     if (type == BINARY)
     {
-        vsg::BinaryInput input(fin, _objectFactory, options);
-        input.filename = filenameToUse;
-        input.version = version;
-        return input.readObject("Root");
+        // indexed objects are read in parallel from their own std::ifstream
+        auto payloadStart = fin.tellg();
+        auto openPayload = [&]() -> std::unique_ptr<std::istream> {
+            auto stream = std::make_unique<std::ifstream>(filenameToUse, std::ios::in | std::ios::binary);
+            if (!*stream || !stream->seekg(payloadStart)) return {};
+            return stream;
+        };
+        return _readBinary(fin, options, filenameToUse, version, binaryHeader, openPayload);
     }
     else if (type == ASCII)
     {
@@ -125,12 +431,12 @@ vsg::ref_ptr<vsg::Object> VSG::read(std::istream& fin, vsg::ref_ptr<const vsg::O
 {
     if (options && !compatibleExtension(options, ".vsgb", ".vsgt")) return {};
 
-    auto [type, version] = readHeader(fin);
+    BinaryHeader binaryHeader;
+    auto [type, version] = readHeader(fin, &binaryHeader);
     if (type == BINARY)
     {
-        vsg::BinaryInput input(fin, _objectFactory, options);
-        input.version = version;
-        return input.readObject("Root");
+        // a generic std::istream can't be opened again so indexed objects are read sequentially
+        return _readBinary(fin, options, {}, version, binaryHeader, {});
     }
     else if (type == ASCII)
     {
@@ -147,12 +453,32 @@ vsg::ref_ptr<vsg::Object> VSG::read(const uint8_t* ptr, size_t size, vsg::ref_pt
     if (options && !compatibleExtension(options, ".vsgb", ".vsgt")) return {};
 
     mem_stream fin(ptr, size);
-    return read(fin, options);
+
+    BinaryHeader binaryHeader;
+    auto [type, version] = readHeader(fin, &binaryHeader);
+    if (type == BINARY)
+    {
+        // indexed objects are read in parallel from their own mem_stream
+        auto payloadStart = static_cast<size_t>(fin.tellg());
+        auto openPayload = [&]() -> std::unique_ptr<std::istream> {
+            return std::make_unique<mem_stream>(ptr + payloadStart, size - payloadStart);
+        };
+        return _readBinary(fin, options, {}, version, binaryHeader, openPayload);
+    }
+    else if (type == ASCII)
+    {
+        vsg::AsciiInput input(fin, _objectFactory, options);
+        input.version = version;
+        return input.readObject("Root");
+    }
+
+    return {};
 }
 
 bool VSG::write(const vsg::Object* object, const vsg::Path& filename, ref_ptr<const Options> options) const
 {
     auto version = vsgGetVersion();
+    uint32_t alignment = 0;
 
     if (options)
     {
@@ -161,18 +487,14 @@ bool VSG::write(const vsg::Object* object, const vsg::Path& filename, ref_ptr<co
         {
             version = parseVersion(version_string);
         }
+        options->getValue(VSG::array_alignment, alignment);
     }
 
     auto ext = vsg::lowerCaseFileExtension(filename);
     if (ext == ".vsgb")
     {
         std::ofstream fout(filename, std::ios::out | std::ios::binary);
-        writeHeader(fout, FormatInfo{BINARY, version});
-
-        vsg::BinaryOutput output(fout, options);
-        output.version = version;
-        output.writeObject("Root", object);
-        return true;
+        return _writeBinary(object, fout, options, version, alignment);
     }
     else if (ext == ".vsga" || ext == ".vsgt")
     {
@@ -196,6 +518,7 @@ bool VSG::write(const vsg::Object* object, std::ostream& fout, ref_ptr<const Opt
 
     auto version = vsgGetVersion();
     bool asciiFormat = true;
+    uint32_t alignment = 0;
 
     if (options)
     {
@@ -206,6 +529,7 @@ bool VSG::write(const vsg::Object* object, std::ostream& fout, ref_ptr<const Opt
         {
             version = parseVersion(version_string);
         }
+        options->getValue(VSG::array_alignment, alignment);
     }
 
     if (asciiFormat)
@@ -219,18 +543,30 @@ bool VSG::write(const vsg::Object* object, std::ostream& fout, ref_ptr<const Opt
     }
     else
     {
-        writeHeader(fout, FormatInfo(BINARY, version));
-
-        vsg::BinaryOutput output(fout, options);
-        output.version = version;
-        output.writeObject("Root", object);
-        return true;
+        return _writeBinary(object, fout, options, version, alignment);
     }
 }
 
+bool VSG::readOptions(Options& options, CommandLine& arguments) const
+{
+    bool result = arguments.readAndAssign<bool>(VSG::map_file, &options);
+    result = arguments.readAndAssign<uint32_t>(VSG::array_alignment, &options) || result;
+    result = arguments.readAndAssign<std::string>(VSG::compression_codec, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(VSG::compression_block_size, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(VSG::index_threshold, &options) || result;
+    result = arguments.readAndAssign<bool>(VSG::class_ids, &options) || result;
+    return result;
+}
+
 bool VSG::getFeatures(Features& features) const
 {
     features.extensionFeatureMap[".vsgb"] = static_cast<FeatureMask>(READ_FILENAME | READ_ISTREAM | READ_MEMORY | WRITE_FILENAME | WRITE_OSTREAM);
     features.extensionFeatureMap[".vsgt"] = static_cast<FeatureMask>(READ_FILENAME | READ_ISTREAM | READ_MEMORY | WRITE_FILENAME | WRITE_OSTREAM);
+    features.optionNameTypeMap[VSG::map_file] = type_name<bool>();
+    features.optionNameTypeMap[VSG::array_alignment] = type_name<uint32_t>();
+    features.optionNameTypeMap[VSG::compression_codec] = type_name<std::string>();
+    features.optionNameTypeMap[VSG::compression_block_size] = type_name<uint32_t>();
+    features.optionNameTypeMap[VSG::index_threshold] = type_name<uint32_t>();
+    features.optionNameTypeMap[VSG::class_ids] = type_name<bool>();
     return true;
 }
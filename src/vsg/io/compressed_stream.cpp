@@ -0,0 +1,278 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/compressed_stream.h>
+
+#include <algorithm>
+
+using namespace vsg;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// compressed_ostream
+//
+compressed_ostream::compressed_ostream(std::ostream& output, ref_ptr<const CompressionCodec> codec, size_t blockSize) :
+    std::ostream(&_buffer),
+    _buffer(output, codec, blockSize)
+{
+    rdbuf(&_buffer);
+}
+
+compressed_ostream::~compressed_ostream()
+{
+    finish();
+}
+
+void compressed_ostream::finish()
+{
+    _buffer.finish();
+    if (!_buffer.output.good()) setstate(std::ios_base::badbit);
+}
+
+compressed_ostream::compress_buffer::compress_buffer(std::ostream& in_output, ref_ptr<const CompressionCodec> in_codec, size_t blockSize) :
+    output(in_output),
+    codec(in_codec)
+{
+    buffer.resize(std::max(blockSize, size_t(1)));
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+compressed_ostream::compress_buffer::int_type compressed_ostream::compress_buffer::overflow(int_type c)
+{
+    if (finished || !writeBlock()) return traits_type::eof();
+
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+bool compressed_ostream::compress_buffer::writeBlock()
+{
+    size_t size = static_cast<size_t>(pptr() - pbase());
+    if (size == 0) return true;
+
+    const char* data = buffer.data();
+    size_t compressedSize = 0;
+    if (codec)
+    {
+        compressed.resize(codec->compressBound(size));
+        compressedSize = codec->compress(reinterpret_cast<const uint8_t*>(buffer.data()), size, compressed.data(), compressed.size());
+        if (compressedSize > 0 && compressedSize < size) data = reinterpret_cast<const char*>(compressed.data());
+    }
+
+    // store blocks that don't compress as is
+    if (compressedSize == 0 || compressedSize >= size) compressedSize = size;
+
+    blockIndex.push_back(compressedPosition);
+    blockIndex.push_back(uncompressedPosition);
+
+    uint32_t sizes[2] = {static_cast<uint32_t>(size), static_cast<uint32_t>(compressedSize)};
+    output.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    output.write(data, compressedSize);
+
+    compressedPosition += sizeof(sizes) + compressedSize;
+    uncompressedPosition += size;
+
+    setp(buffer.data(), buffer.data() + buffer.size());
+
+    return output.good();
+}
+
+void compressed_ostream::compress_buffer::finish()
+{
+    if (finished) return;
+    finished = true;
+
+    writeBlock();
+
+    // terminating block, also recorded in the index so the index holds the total compressed and uncompressed sizes
+    blockIndex.push_back(compressedPosition);
+    blockIndex.push_back(uncompressedPosition);
+
+    uint32_t sizes[2] = {0, 0};
+    output.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    compressedPosition += sizeof(sizes);
+
+    // block index followed by its offset so readers can find it from the end of the stream
+    uint64_t indexOffset = compressedPosition;
+    uint64_t count = blockIndex.size() / 2;
+    output.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    output.write(reinterpret_cast<const char*>(blockIndex.data()), blockIndex.size() * sizeof(uint64_t));
+    output.write(reinterpret_cast<const char*>(&indexOffset), sizeof(indexOffset));
+
+    setp(nullptr, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// compressed_istream
+//
+compressed_istream::compressed_istream(std::istream& input, ref_ptr<const CompressionCodec> codec) :
+    std::istream(&_buffer),
+    _buffer(input, codec)
+{
+    rdbuf(&_buffer);
+}
+
+compressed_istream::decompress_buffer::decompress_buffer(std::istream& in_input, ref_ptr<const CompressionCodec> in_codec) :
+    input(in_input),
+    codec(in_codec),
+    start(in_input.tellg())
+{
+    setg(nullptr, nullptr, nullptr);
+}
+
+compressed_istream::decompress_buffer::int_type compressed_istream::decompress_buffer::underflow()
+{
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    blockStart += static_cast<uint64_t>(egptr() - eback());
+    setg(nullptr, nullptr, nullptr);
+
+    if (!readBlock()) return traits_type::eof();
+
+    return traits_type::to_int_type(*gptr());
+}
+
+bool compressed_istream::decompress_buffer::readBlock()
+{
+    if (endOfBlocks) return false;
+
+    uint32_t sizes[2] = {0, 0};
+    if (!input.read(reinterpret_cast<char*>(sizes), sizeof(sizes)) || sizes[0] == 0)
+    {
+        endOfBlocks = true;
+        return false;
+    }
+
+    buffer.resize(sizes[0]);
+    if (sizes[1] == sizes[0])
+    {
+        if (!input.read(buffer.data(), sizes[0])) return false;
+    }
+    else
+    {
+        compressed.resize(sizes[1]);
+        if (!codec || !input.read(reinterpret_cast<char*>(compressed.data()), sizes[1])) return false;
+        if (!codec->decompress(compressed.data(), sizes[1], reinterpret_cast<uint8_t*>(buffer.data()), sizes[0])) return false;
+    }
+
+    setg(buffer.data(), buffer.data(), buffer.data() + sizes[0]);
+    return true;
+}
+
+bool compressed_istream::decompress_buffer::readIndex()
+{
+    if (!blockIndex.empty()) return true;
+    if (start == std::streampos(-1)) return false;
+
+    auto current = input.tellg();
+    input.clear();
+
+    uint64_t indexOffset = 0;
+    uint64_t count = 0;
+    bool result = false;
+    if (input.seekg(-static_cast<std::streamoff>(sizeof(indexOffset)), std::ios_base::end) &&
+        input.read(reinterpret_cast<char*>(&indexOffset), sizeof(indexOffset)) &&
+        input.seekg(start + static_cast<std::streamoff>(indexOffset)) &&
+        input.read(reinterpret_cast<char*>(&count), sizeof(count)))
+    {
+        // each block takes at least 8 bytes so a larger count can only come from a corrupt index
+        if (count > 0 && count <= indexOffset / 8)
+        {
+            blockIndex.resize(count * 2);
+            result = static_cast<bool>(input.read(reinterpret_cast<char*>(blockIndex.data()), blockIndex.size() * sizeof(uint64_t)));
+            if (!result) blockIndex.clear();
+        }
+    }
+
+    input.clear();
+    input.seekg(current);
+    return result;
+}
+
+compressed_istream::decompress_buffer::pos_type compressed_istream::decompress_buffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if ((which & std::ios_base::in) == 0) return pos_type(off_type(-1));
+
+    off_type current = static_cast<off_type>(blockStart + static_cast<uint64_t>(gptr() - eback()));
+    if (dir == std::ios_base::cur)
+    {
+        if (off == 0) return pos_type(current);
+        return seekpos(pos_type(current + off), which);
+    }
+    else if (dir == std::ios_base::beg)
+    {
+        return seekpos(pos_type(off), which);
+    }
+    else
+    {
+        if (!readIndex()) return pos_type(off_type(-1));
+        return seekpos(pos_type(static_cast<off_type>(blockIndex.back()) + off), which);
+    }
+}
+
+compressed_istream::decompress_buffer::pos_type compressed_istream::decompress_buffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    if ((which & std::ios_base::in) == 0 || off_type(pos) < 0) return pos_type(off_type(-1));
+
+    uint64_t position = static_cast<uint64_t>(off_type(pos));
+
+    // no need to decompress anything when staying within the current block
+    uint64_t blockSize = static_cast<uint64_t>(egptr() - eback());
+    if (position >= blockStart && position < blockStart + blockSize)
+    {
+        setg(eback(), eback() + (position - blockStart), egptr());
+        return pos;
+    }
+
+    if (!readIndex()) return pos_type(off_type(-1));
+
+    // the last entry is the terminating block, holding the total uncompressed size
+    size_t numBlocks = blockIndex.size() / 2 - 1;
+    uint64_t totalSize = blockIndex.back();
+    if (position > totalSize) return pos_type(off_type(-1));
+
+    setg(nullptr, nullptr, nullptr);
+
+    if (position == totalSize)
+    {
+        blockStart = totalSize;
+        endOfBlocks = true;
+        return pos;
+    }
+
+    // find the last block starting at or before the position
+    size_t first = 0;
+    size_t last = numBlocks;
+    while (last - first > 1)
+    {
+        size_t middle = (first + last) / 2;
+        if (blockIndex[middle * 2 + 1] <= position)
+            first = middle;
+        else
+            last = middle;
+    }
+
+    input.clear();
+    input.seekg(start + static_cast<std::streamoff>(blockIndex[first * 2]));
+    blockStart = blockIndex[first * 2 + 1];
+    endOfBlocks = false;
+
+    if (!readBlock()) return pos_type(off_type(-1));
+
+    setg(eback(), eback() + (position - blockStart), egptr());
+    return pos;
+}
@@ -10,17 +10,119 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/core/Auxiliary.h>
+#include <vsg/io/AsciiOutput.h>
 #include <vsg/io/VSG.h>
 #include <vsg/io/glsl.h>
 #include <vsg/io/read.h>
 #include <vsg/io/spirv.h>
 #include <vsg/io/tile.h>
 #include <vsg/io/txt.h>
-#include <vsg/threading/OperationThreads.h>
+#include <vsg/threading/TaskGroup.h>
 #include <vsg/utils/SharedObjects.h>
 
+#include <iomanip>
+#include <random>
+#include <sstream>
+
 using namespace vsg;
 
+FileCacheStatistics& vsg::fileCacheStatistics()
+{
+    static FileCacheStatistics s_fileCacheStatistics;
+    return s_fileCacheStatistics;
+}
+
+uint64_t vsg::fileCacheKey(const Options* options)
+{
+    if (!options) return 0;
+
+    // serialize the Options that can change what the ReaderWriters load, the search paths, threads and caches used don't affect the loaded object
+    std::ostringstream key;
+    key << options->extensionHint.string() << '\n'
+        << options->mapRGBtoRGBAHint << '\n'
+        << static_cast<int>(options->sceneCoordinateConvention) << '\n';
+    for (auto& [ext, coordinateConvention] : options->formatCoordinateConventions)
+    {
+        key << ext.string() << ' ' << static_cast<int>(coordinateConvention) << '\n';
+    }
+    for (auto& rw : options->readerWriters)
+    {
+        if (rw) key << rw->className() << '\n';
+    }
+    for (auto& entry : options->shaderSets)
+    {
+        key << entry.first << '\n';
+    }
+    if (auto auxiliary = options->getAuxiliary())
+    {
+        // values assigned with Options::setValue(..)
+        AsciiOutput output(key);
+        for (auto& [name, object] : auxiliary->userObjects)
+        {
+            output.writeObject(name.c_str(), object.get());
+        }
+    }
+
+    // FNV-1a so that the key is the same across processes and platforms sharing the fileCache
+    uint64_t hash = 14695981039346656037ull;
+    for (auto c : key.str())
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+Path vsg::fileCachePath(const Path& fileCache, const Path& filename, const Options* options)
+{
+    if (!fileCache || !filename) return {};
+
+    // map the filename or URL to a path relative to the fileCache by removing any protocol, drive and root, and neutralizing references to parent directories
+    std::string relativePath = filename.string();
+    if (auto pos = relativePath.find("://"); pos != std::string::npos) relativePath.erase(0, pos + 3);
+    if (relativePath.size() >= 2 && relativePath[1] == ':') relativePath.erase(0, 2);
+    relativePath.erase(0, relativePath.find_first_not_of("/\\"));
+    for (auto pos = relativePath.find(".."); pos != std::string::npos; pos = relativePath.find("..", pos))
+    {
+        relativePath.replace(pos, 2, "__");
+    }
+
+    if (relativePath.empty()) return {};
+
+    if (options)
+    {
+        std::ostringstream key;
+        key << '.' << std::hex << std::setw(16) << std::setfill('0') << fileCacheKey(options);
+        relativePath += key.str();
+    }
+
+    return fileCache / (relativePath + ".vsgb");
+}
+
+static void writeToFileCache(const Object* object, const Path& cacheFilename, ref_ptr<const Options> options)
+{
+    makeDirectory(filePath(cacheFilename));
+
+    // write to a uniquely named file and then rename it, so that other threads and processes sharing the fileCache never read a partially written file
+    static const uint64_t s_processKey = std::random_device{}();
+    static std::atomic_uint64_t s_count{0};
+    Path temporaryFilename = removeExtension(cacheFilename);
+    temporaryFilename.concat("." + std::to_string(s_processKey) + "_" + std::to_string(s_count++) + ".tmp.vsgb");
+
+    auto& statistics = fileCacheStatistics();
+
+    VSG rw;
+    if (rw.write(object, temporaryFilename, options) && renameFile(temporaryFilename, cacheFilename))
+    {
+        ++statistics.writes;
+    }
+    else
+    {
+        removeFile(temporaryFilename);
+        ++statistics.failedWrites;
+    }
+}
+
 ref_ptr<Object> vsg::read(const Path& filename, ref_ptr<const Options> options)
 {
     auto read_file = [&]() -> ref_ptr<Object> {
@@ -63,19 +165,55 @@ ref_ptr<Object> vsg::read(const Path& filename, ref_ptr<const Options> options)
         }
     };
 
+    auto read_file_via_cache = [&]() -> ref_ptr<Object> {
+        // native binary files gain nothing from being cached
+        if (!options || !options->fileCache || lowerCaseFileExtension(filename) == ".vsgb") return read_file();
+
+        // key the cache on the resolved filename so the same file found via different Options::paths shares one entry, URLs are used as is
+        bool url = filename.string().find("://") != std::string::npos;
+        Path sourceFilename = url ? filename : findFile(filename, options);
+        if (!sourceFilename) return read_file();
+
+        // local files that can't be stat'ed can't be checked for modification so bypass the cache, URLs are never revalidated
+        int64_t sourceTime = url ? 0 : fileModificationTime(sourceFilename);
+        if (!url && sourceTime == 0) return read_file();
+
+        Path cacheFilename = fileCachePath(options->fileCache, sourceFilename, options);
+        if (!cacheFilename) return read_file();
+
+        auto& statistics = fileCacheStatistics();
+
+        // use the cached file unless the local source file has been modified since it was cached
+        if (auto cacheTime = fileModificationTime(cacheFilename); cacheTime != 0 && cacheTime >= sourceTime)
+        {
+            VSG rw;
+            if (auto object = rw.readFile(cacheFilename, options))
+            {
+                ++statistics.hits;
+                return object;
+            }
+        }
+
+        ++statistics.misses;
+
+        auto object = read_file();
+        if (object) writeToFileCache(object, cacheFilename, options);
+        return object;
+    };
+
     if (options && options->sharedObjects && options->sharedObjects->suitable(filename))
     {
         auto loadedObject = LoadedObject::create(filename, options);
 
         options->sharedObjects->share(loadedObject, [&](auto load) {
-            load->object = read_file();
+            load->object = read_file_via_cache();
         });
 
         return loadedObject->object;
     }
     else
     {
-        return read_file();
+        return read_file_via_cache();
     }
 }
 
@@ -96,38 +234,32 @@ PathObjects vsg::read(const Paths& filenames, ref_ptr<const Options> options)
 
         struct ReadOperation : public Operation
         {
-            ReadOperation(const Path& f, ref_ptr<const Options> opt, ref_ptr<Object>& obj, ref_ptr<Latch> l) :
+            ReadOperation(const Path& f, ref_ptr<const Options> opt, ref_ptr<Object>& obj) :
                 filename(f),
                 options(opt),
-                object(obj),
-                latch(l) {}
+                object(obj) {}
 
             void run() override
             {
                 object = vsg::read(filename, options);
-                latch->count_down();
             }
 
             Path filename;
             ref_ptr<const Options> options;
             ref_ptr<Object>& object;
-            ref_ptr<Latch> latch;
         };
 
-        // use latch to synchronize this thread with the file reading threads
-        auto latch = Latch::create(static_cast<int>(filenames.size()));
+        // use task group to synchronize this thread with the file reading threads
+        auto taskGroup = TaskGroup::create(operationThreads);
 
         // add operations
         for (auto& [filename, object] : entries)
         {
-            operationThreads->add(ref_ptr<Operation>(new ReadOperation(filename, options, object, latch)));
+            taskGroup->run(ref_ptr<Operation>(new ReadOperation(filename, options, object)));
         }
 
-        // use this thread to read the files as well
-        operationThreads->run();
-
-        // wait till all the read operations have completed
-        latch->wait();
+        // wait till all the read operations have completed, using this thread to read the files as well
+        taskGroup->wait();
     }
     else
     {
@@ -0,0 +1,141 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/app/RecordTraversal.h>
+#include <vsg/io/stream.h>
+#include <vsg/nodes/BatchCullGroup.h>
+#include <vsg/nodes/CullGroup.h>
+#include <vsg/nodes/CullNode.h>
+#include <vsg/nodes/LOD.h>
+#include <vsg/nodes/PagedLOD.h>
+#include <vsg/vk/State.h>
+
+#include <limits>
+
+using namespace vsg;
+
+BatchCullGroup::BatchCullGroup(size_t numChildren) :
+    Inherit(numChildren)
+{
+}
+
+BatchCullGroup::~BatchCullGroup()
+{
+}
+
+void BatchCullGroup::read(Input& input)
+{
+    Group::read(input);
+
+    updateBounds();
+}
+
+void BatchCullGroup::updateBounds()
+{
+    _x.resize(children.size());
+    _y.resize(children.size());
+    _z.resize(children.size());
+    _radius.resize(children.size());
+    _boundChildren.resize(children.size());
+
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        const dsphere* bound = nullptr;
+
+        auto child = children[i].get();
+        if (auto cullNode = child->cast<CullNode>())
+        {
+            bound = &cullNode->bound;
+        }
+        else if (auto cullGroup = child->cast<CullGroup>())
+        {
+            bound = &cullGroup->bound;
+        }
+        else if (auto lod = child->cast<LOD>())
+        {
+            bound = &lod->bound;
+        }
+        else if (auto plod = child->cast<PagedLOD>())
+        {
+            bound = &plod->bound;
+        }
+
+        if (bound)
+        {
+            _x[i] = bound->x;
+            _y[i] = bound->y;
+            _z[i] = bound->z;
+            _radius[i] = bound->r;
+        }
+        else
+        {
+            // children without a bound always pass
+            _x[i] = _y[i] = _z[i] = 0.0;
+            _radius[i] = std::numeric_limits<double>::infinity();
+        }
+        _boundChildren[i] = child;
+    }
+}
+
+void BatchCullGroup::traverse(RecordTraversal& visitor) const
+{
+    if (_boundChildren.size() != children.size())
+    {
+        Group::traverse(visitor);
+        return;
+    }
+
+    auto state = visitor.getState();
+    bool coherentCulling = state->coherentCulling;
+
+    // cull in blocks so the visibility flags stay on the stack and in cache
+    constexpr size_t blockSize = 64;
+    uint8_t visible[blockSize];
+
+    for (size_t first = 0; first < children.size(); first += blockSize)
+    {
+        size_t count = std::min(blockSize, children.size() - first);
+        state->intersect(&_x[first], &_y[first], &_z[first], &_radius[first], count, visible);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto& child = children[first + i];
+            if (child.get() != _boundChildren[first + i])
+            {
+                // child replaced since updateBounds() so its cached bound doesn't apply
+                if (child) child->accept(visitor);
+                continue;
+            }
+
+            if (!visible[i]) continue;
+
+            if (auto cullNode = child->cast<CullNode>())
+            {
+                if (coherentCulling)
+                    visitor.apply(*cullNode);
+                else
+                    cullNode->child->accept(visitor);
+            }
+            else if (auto cullGroup = child->cast<CullGroup>())
+            {
+                if (coherentCulling)
+                    visitor.apply(*cullGroup);
+                else
+                    cullGroup->traverse(visitor);
+            }
+            else
+            {
+                child->accept(visitor);
+            }
+        }
+    }
+}
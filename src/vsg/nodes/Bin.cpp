@@ -16,6 +16,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/vk/State.h>
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
 
 using namespace vsg;
 
@@ -36,6 +38,7 @@ Bin::~Bin()
 void Bin::clear()
 {
     _matrices.clear();
+    _matrixIDs.clear();
     _stateCommands.clear();
     _elements.clear();
     _binElements.clear();
@@ -47,31 +50,28 @@ void Bin::add(State* state, double value, const Node* node)
 
     Element element;
 
-    const auto& mv = state->modelviewMatrixStack.top();
-#if 1
-    if (_matrices.empty())
+    // look for the modelview matrix amongst the most recently added ones, using the MatrixStack's identifier
+    // so that siblings sharing a transform share a single copy of the matrix without comparing matrix values.
+    auto& modelviewMatrixStack = state->modelviewMatrixStack;
+    auto matrixID = modelviewMatrixStack.topID();
+    constexpr size_t maxMatrixSearch = 4;
+    size_t searchEnd = _matrixIDs.size() > maxMatrixSearch ? _matrixIDs.size() - maxMatrixSearch : 0;
+    size_t matrixIndex = _matrixIDs.size();
+    for (size_t i = _matrixIDs.size(); i > searchEnd; --i)
     {
-        element.matrixIndex = static_cast<uint32_t>(_matrices.size());
-        _matrices.push_back(mv);
-    }
-    else
-    {
-        if (_matrices.back() == mv)
+        if (_matrixIDs[i - 1] == matrixID)
         {
-            //debug("reoccurring ");
-            element.matrixIndex = static_cast<uint32_t>(_matrices.size()) - 1;
-        }
-        else
-        {
-            //debug("new ");
-            element.matrixIndex = static_cast<uint32_t>(_matrices.size());
-            _matrices.push_back(mv);
+            matrixIndex = i - 1;
+            break;
         }
     }
-#else
-    element.matrixIndex = _matrices.size();
-    _matrices.push_back(mv);
-#endif
+
+    if (matrixIndex == _matrixIDs.size())
+    {
+        _matrices.push_back(modelviewMatrixStack.top());
+        _matrixIDs.push_back(matrixID);
+    }
+    element.matrixIndex = static_cast<uint32_t>(matrixIndex);
 
     element.stateCommandIndex = static_cast<uint32_t>(_stateCommands.size());
     for (auto& stateStack : state->stateStacks)
@@ -83,6 +83,18 @@ void Bin::add(State* state, double value, const Node* node)
         }
     }
 
+    // share the previous element's state commands when they are the same
+    if (!_elements.empty())
+    {
+        auto& previous = _elements.back();
+        if (previous.stateCommandCount == element.stateCommandCount &&
+            std::equal(_stateCommands.begin() + previous.stateCommandIndex, _stateCommands.begin() + previous.stateCommandIndex + previous.stateCommandCount, _stateCommands.begin() + element.stateCommandIndex))
+        {
+            _stateCommands.resize(element.stateCommandIndex);
+            element.stateCommandIndex = previous.stateCommandIndex;
+        }
+    }
+
     element.child = node;
 
     _binElements.emplace_back(static_cast<float>(value), static_cast<uint32_t>(_elements.size()));
@@ -90,23 +102,194 @@ void Bin::add(State* state, double value, const Node* node)
     _elements.push_back(element);
 }
 
+void Bin::merge(const Bin& bin)
+{
+    auto matrixOffset = static_cast<uint32_t>(_matrices.size());
+    auto stateCommandOffset = static_cast<uint32_t>(_stateCommands.size());
+    auto elementOffset = static_cast<uint32_t>(_elements.size());
+
+    _matrices.insert(_matrices.end(), bin._matrices.begin(), bin._matrices.end());
+    // identifiers are only unique within a single MatrixStack so don't share matrices added via another State
+    _matrixIDs.insert(_matrixIDs.end(), bin._matrices.size(), 0);
+    _stateCommands.insert(_stateCommands.end(), bin._stateCommands.begin(), bin._stateCommands.end());
+
+    for (auto element : bin._elements)
+    {
+        element.matrixIndex += matrixOffset;
+        element.stateCommandIndex += stateCommandOffset;
+        _elements.push_back(element);
+    }
+
+    for (auto& [key, index] : bin._binElements)
+    {
+        _binElements.emplace_back(key, index + elementOffset);
+    }
+}
+
+// map a float to an unsigned integer with the same ordering, negative values have all their bits flipped, positive values just the sign bit.
+static inline uint32_t sortableKey(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t mask = static_cast<uint32_t>(-static_cast<int32_t>(bits >> 31)) | 0x80000000u;
+    return bits ^ mask;
+}
+
+void Bin::sort() const
+{
+    if (sortOrder == STATE_SORT)
+    {
+        stateSort();
+        return;
+    }
+
+    size_t numElements = _binElements.size();
+
+    bool sorted = false;
+    if (incrementalSort && _previousOrder.size() == numElements)
+    {
+        // restore the previous frame's order then fix it up, falling back to a full sort if too many elements have moved
+        _sortBuffer.resize(numElements);
+        for (size_t i = 0; i < numElements; ++i)
+        {
+            _sortBuffer[i] = _binElements[_previousOrder[i]];
+        }
+        _binElements.swap(_sortBuffer);
+
+        sorted = insertionSort(numElements);
+    }
+
+    if (!sorted)
+    {
+        if (numElements >= radixSortThreshold)
+        {
+            radixSort();
+        }
+        else if (sortOrder == ASCENDING)
+        {
+            std::sort(_binElements.begin(), _binElements.end(), [](const KeyIndex& lhs, const KeyIndex& rhs) { return lhs.first < rhs.first; });
+        }
+        else
+        {
+            std::sort(_binElements.begin(), _binElements.end(), [](const KeyIndex& lhs, const KeyIndex& rhs) { return rhs.first < lhs.first; });
+        }
+    }
+
+    if (incrementalSort)
+    {
+        _previousOrder.resize(numElements);
+        for (size_t i = 0; i < numElements; ++i)
+        {
+            _previousOrder[i] = _binElements[i].second;
+        }
+    }
+}
+
+bool Bin::insertionSort(size_t maxMoves) const
+{
+    auto less = [descending = (sortOrder == DESCENDING)](float lhs, float rhs) { return descending ? (rhs < lhs) : (lhs < rhs); };
+
+    size_t numMoves = 0;
+    for (size_t i = 1; i < _binElements.size(); ++i)
+    {
+        auto keyIndex = _binElements[i];
+        size_t j = i;
+        while (j > 0 && less(keyIndex.first, _binElements[j - 1].first))
+        {
+            _binElements[j] = _binElements[j - 1];
+            --j;
+            ++numMoves;
+        }
+        _binElements[j] = keyIndex;
+
+        // leave the remaining elements partially sorted, the full sort handles any order
+        if (numMoves > maxMoves) return false;
+    }
+    return true;
+}
+
+void Bin::stateSort() const
+{
+    float minValue = std::numeric_limits<float>::max();
+    float maxValue = std::numeric_limits<float>::lowest();
+    for (auto& keyIndex : _binElements)
+    {
+        minValue = std::min(minValue, keyIndex.first);
+        maxValue = std::max(maxValue, keyIndex.first);
+    }
+
+    uint32_t maxBucket = depthBuckets > 1 ? depthBuckets - 1 : 0;
+    float scale = (maxBucket > 0 && maxValue > minValue) ? static_cast<float>(depthBuckets) / (maxValue - minValue) : 0.0f;
+    auto bucket = [&](float value) { return std::min(static_cast<uint32_t>((value - minValue) * scale), maxBucket); };
+
+    // state commands are held in slot order so comparing them in turn orders by pipeline, then by descriptor sets
+    auto stateCommands = _stateCommands.data();
+    std::stable_sort(_binElements.begin(), _binElements.end(), [&](const KeyIndex& lhs, const KeyIndex& rhs) {
+        auto lhsBucket = bucket(lhs.first);
+        auto rhsBucket = bucket(rhs.first);
+        if (lhsBucket != rhsBucket) return lhsBucket < rhsBucket;
+
+        auto& lhsElement = _elements[lhs.second];
+        auto& rhsElement = _elements[rhs.second];
+        auto lhsBegin = stateCommands + lhsElement.stateCommandIndex;
+        auto rhsBegin = stateCommands + rhsElement.stateCommandIndex;
+        return std::lexicographical_compare(lhsBegin, lhsBegin + lhsElement.stateCommandCount, rhsBegin, rhsBegin + rhsElement.stateCommandCount, std::less<const StateCommand*>());
+    });
+}
+
+void Bin::radixSort() const
+{
+    // least significant digit radix sort, 4 passes of 8 bits, the histograms for all passes are gathered in a single pass over the keys
+    if (_binElements.size() < 2) return;
+
+    uint32_t flip = (sortOrder == DESCENDING) ? 0xffffffffu : 0u;
+
+    uint32_t histograms[4][256];
+    std::memset(histograms, 0, sizeof(histograms));
+    for (auto& keyIndex : _binElements)
+    {
+        uint32_t key = sortableKey(keyIndex.first) ^ flip;
+        ++histograms[0][key & 0xff];
+        ++histograms[1][(key >> 8) & 0xff];
+        ++histograms[2][(key >> 16) & 0xff];
+        ++histograms[3][key >> 24];
+    }
+
+    size_t numElements = _binElements.size();
+    _sortBuffer.resize(numElements);
+
+    for (uint32_t pass = 0; pass < 4; ++pass)
+    {
+        auto& histogram = histograms[pass];
+        uint32_t shift = pass * 8;
+
+        // skip passes where all the keys share the same digit
+        if (histogram[(sortableKey(_binElements.front().first) ^ flip) >> shift & 0xff] == numElements) continue;
+
+        uint32_t offset = 0;
+        for (auto& count : histogram)
+        {
+            uint32_t c = count;
+            count = offset;
+            offset += c;
+        }
+
+        for (auto& keyIndex : _binElements)
+        {
+            uint32_t digit = ((sortableKey(keyIndex.first) ^ flip) >> shift) & 0xff;
+            _sortBuffer[histogram[digit]++] = keyIndex;
+        }
+        _binElements.swap(_sortBuffer);
+    }
+}
+
 void Bin::traverse(RecordTraversal& rt) const
 {
     //debug("Bin::traverse(RecordTraversal& visitor) ", sortOrder, " ", _binElements.size());
 
     auto state = rt.getState();
 
-    switch (sortOrder)
-    {
-    case (ASCENDING):
-        std::sort(_binElements.begin(), _binElements.end(), [](const KeyIndex& lhs, const KeyIndex& rhs) { return lhs.first < rhs.first; });
-        break;
-    case (DESCENDING):
-        std::sort(_binElements.begin(), _binElements.end(), [](const KeyIndex& lhs, const KeyIndex& rhs) { return rhs.first < lhs.first; });
-        break;
-    case (NO_SORT):
-        break;
-    }
+    if (sortOrder != NO_SORT) sort();
 
     uint32_t previousMatrixIndex = static_cast<uint32_t>(_matrices.size());
     //uint32_t previousStateCommandIndex = _stateCommands.size();
@@ -114,6 +297,14 @@ void Bin::traverse(RecordTraversal& rt) const
     state->pushFrustum();
     state->dirty = true;
 
+    // the state commands pushed for the previous element are left in place for as long as following elements share them,
+    // once a state command differs it and those in the following slots are popped and the element's own ones pushed.
+    const StateCommand* const* pushedCommands = nullptr;
+    uint32_t numPushed = 0;
+
+    _numStateCommandsPushed = 0;
+    _numStateCommandsShared = 0;
+
     for (auto& keyElement : _binElements)
     {
         auto& element = _elements[keyElement.second];
@@ -131,27 +322,38 @@ void Bin::traverse(RecordTraversal& rt) const
             //debug("    No need to update");
         }
 
-        if (element.stateCommandCount > 0)
+        auto commands = _stateCommands.data() + element.stateCommandIndex;
+        uint32_t numShared = 0;
+        uint32_t maxShared = std::min(numPushed, element.stateCommandCount);
+        while (numShared < maxShared && pushedCommands[numShared] == commands[numShared]) ++numShared;
+
+        if (numShared != numPushed || numShared != element.stateCommandCount)
         {
-            uint32_t endIndex = element.stateCommandIndex + element.stateCommandCount;
-            for (uint32_t i = element.stateCommandIndex; i < endIndex; ++i)
+            for (uint32_t i = numPushed; i > numShared; --i)
             {
-                auto command = _stateCommands[i];
-                state->stateStacks[command->slot].push(command);
+                state->stateStacks[pushedCommands[i - 1]->slot].pop();
             }
 
-            element.child->accept(rt);
-
-            for (uint32_t i = element.stateCommandIndex; i < endIndex; ++i)
+            for (uint32_t i = numShared; i < element.stateCommandCount; ++i)
             {
-                auto command = _stateCommands[i];
-                state->stateStacks[command->slot].pop();
+                state->stateStacks[commands[i]->slot].push(commands[i]);
             }
+
+            state->dirty = true;
         }
-        else
-        {
-            element.child->accept(rt);
-        }
+
+        _numStateCommandsPushed += element.stateCommandCount - numShared;
+        _numStateCommandsShared += numShared;
+
+        pushedCommands = commands;
+        numPushed = element.stateCommandCount;
+
+        element.child->accept(rt);
+    }
+
+    for (uint32_t i = numPushed; i > 0; --i)
+    {
+        state->stateStacks[pushedCommands[i - 1]->slot].pop();
     }
 
     state->popFrustum();
@@ -0,0 +1,315 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/app/RecordTraversal.h>
+#include <vsg/core/ConstVisitor.h>
+#include <vsg/core/Visitor.h>
+#include <vsg/io/Options.h>
+#include <vsg/io/stream.h>
+#include <vsg/maths/box.h>
+#include <vsg/nodes/CulledInstanceDraw.h>
+#include <vsg/ui/FrameStamp.h>
+#include <vsg/vk/State.h>
+
+#include <algorithm>
+
+using namespace vsg;
+
+// number of uint32_t in a VkDrawIndexedIndirectCommand
+static constexpr uint32_t indirectCommandSize = 5;
+
+// maximum number of instances in a cluster, also the number of bounds culled in each batch
+static constexpr size_t clusterSize = 64;
+
+CulledInstanceDraw::CulledInstanceDraw()
+{
+}
+
+CulledInstanceDraw::~CulledInstanceDraw()
+{
+}
+
+void CulledInstanceDraw::read(Input& input)
+{
+    Node::read(input);
+
+    input.read("firstBinding", firstBinding);
+    arrays.resize(input.readValue<uint32_t>("NumArrays"));
+    for (auto& array : arrays)
+    {
+        input.readObject("Array", array);
+    }
+    input.readObject("Indices", indices);
+
+    input.read("indexCount", indexCount);
+    input.read("firstIndex", firstIndex);
+    input.read("vertexOffset", vertexOffset);
+
+    input.read("bound", bound);
+    input.read("instanceMatrices", instanceMatrices);
+    input.read("maxViews", maxViews);
+
+    update();
+}
+
+void CulledInstanceDraw::write(Output& output) const
+{
+    Node::write(output);
+
+    output.write("firstBinding", firstBinding);
+    output.writeValue<uint32_t>("NumArrays", arrays.size());
+    for (auto& array : arrays)
+    {
+        output.writeObject("Array", array);
+    }
+    output.writeObject("Indices", indices);
+
+    output.write("indexCount", indexCount);
+    output.write("firstIndex", firstIndex);
+    output.write("vertexOffset", vertexOffset);
+
+    output.write("bound", bound);
+    output.write("instanceMatrices", instanceMatrices);
+    output.write("maxViews", maxViews);
+}
+
+void CulledInstanceDraw::update()
+{
+    {
+        std::scoped_lock<std::mutex> lock(_slotMutex);
+        _slotFrameCount = 0;
+        _numSlotsUsed = 0;
+    }
+
+    if (!instanceMatrices || !indices || maxViews == 0)
+    {
+        _order.clear();
+        _x.clear();
+        _y.clear();
+        _z.clear();
+        _radius.clear();
+        _clusterOffsets.clear();
+        _clusterX.clear();
+        _clusterY.clear();
+        _clusterZ.clear();
+        _clusterRadius.clear();
+        _visibleMatrices = {};
+        _indirectCommands = {};
+        _bindCulledInstances = {};
+        _bindAllInstances = {};
+        _bindIndexBuffer = {};
+        _drawIndexedIndirect = {};
+        return;
+    }
+
+    // transform the mesh bound into each instance's position so the instances can be culled in the node's local coordinate frame
+    auto numInstances = instanceMatrices->size();
+    std::vector<dsphere> instanceBounds(numInstances);
+    for (size_t i = 0; i < numInstances; ++i)
+    {
+        dmat4 matrix(instanceMatrices->at(i));
+        double scale = std::max({length(dvec3(matrix[0][0], matrix[0][1], matrix[0][2])),
+                                 length(dvec3(matrix[1][0], matrix[1][1], matrix[1][2])),
+                                 length(dvec3(matrix[2][0], matrix[2][1], matrix[2][2]))});
+        instanceBounds[i].set(matrix * bound.center, bound.radius * scale);
+    }
+
+    // split the instances at the median of the longest axis of their centers until each range fits in a cluster
+    _order.resize(numInstances);
+    for (size_t i = 0; i < numInstances; ++i) _order[i] = static_cast<uint32_t>(i);
+
+    _clusterOffsets.clear();
+    _clusterX.clear();
+    _clusterY.clear();
+    _clusterZ.clear();
+    _clusterRadius.clear();
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    if (numInstances > 0) ranges.emplace_back(0, numInstances);
+    while (!ranges.empty())
+    {
+        auto [first, last] = ranges.back();
+        ranges.pop_back();
+
+        dbox extents;
+        for (size_t i = first; i < last; ++i) extents.add(instanceBounds[_order[i]].center);
+
+        if (last - first > clusterSize)
+        {
+            dvec3 size = extents.max - extents.min;
+            int axis = (size.x >= size.y && size.x >= size.z) ? 0 : ((size.y >= size.z) ? 1 : 2);
+            size_t middle = first + (last - first) / 2;
+            std::nth_element(_order.begin() + first, _order.begin() + middle, _order.begin() + last, [&](uint32_t lhs, uint32_t rhs) {
+                return instanceBounds[lhs].center[axis] < instanceBounds[rhs].center[axis];
+            });
+
+            // push the upper half first so the clusters are laid out in the order of the split
+            ranges.emplace_back(middle, last);
+            ranges.emplace_back(first, middle);
+            continue;
+        }
+
+        dvec3 center = (extents.min + extents.max) * 0.5;
+        double radius = 0.0;
+        for (size_t i = first; i < last; ++i)
+        {
+            auto& instanceBound = instanceBounds[_order[i]];
+            radius = std::max(radius, length(instanceBound.center - center) + instanceBound.radius);
+        }
+
+        _clusterOffsets.push_back(static_cast<uint32_t>(first));
+        _clusterX.push_back(center.x);
+        _clusterY.push_back(center.y);
+        _clusterZ.push_back(center.z);
+        _clusterRadius.push_back(radius);
+    }
+    _clusterOffsets.push_back(static_cast<uint32_t>(numInstances));
+
+    _x.resize(numInstances);
+    _y.resize(numInstances);
+    _z.resize(numInstances);
+    _radius.resize(numInstances);
+    for (size_t i = 0; i < numInstances; ++i)
+    {
+        auto& instanceBound = instanceBounds[_order[i]];
+        _x[i] = instanceBound.center.x;
+        _y[i] = instanceBound.center.y;
+        _z[i] = instanceBound.center.z;
+        _radius[i] = instanceBound.radius;
+    }
+
+    // each view slot has numInstances entries in the visible matrices and one indirect command
+    _visibleMatrices = mat4Array::create(numInstances * maxViews);
+    _visibleMatrices->properties.dataVariance = DYNAMIC_DATA_TRANSFER_AFTER_RECORD;
+
+    _indirectCommands = uintArray::create(indirectCommandSize * maxViews, 0u);
+    _indirectCommands->properties.dataVariance = DYNAMIC_DATA_TRANSFER_AFTER_RECORD;
+
+    DataList culledArrays(arrays);
+    culledArrays.push_back(_visibleMatrices);
+    _bindCulledInstances = BindVertexBuffers::create(firstBinding, culledArrays);
+
+    DataList allArrays(arrays);
+    allArrays.push_back(instanceMatrices);
+    _bindAllInstances = BindVertexBuffers::create(firstBinding, allArrays);
+
+    _bindIndexBuffer = BindIndexBuffer::create(indices);
+    _drawIndexedIndirect = DrawIndexedIndirect::create(_indirectCommands, 1, indirectCommandSize * static_cast<uint32_t>(sizeof(uint32_t)));
+}
+
+uint32_t CulledInstanceDraw::_nextSlot(uint64_t frameCount) const
+{
+    std::scoped_lock<std::mutex> lock(_slotMutex);
+
+    // the buffers are read by the GPU after recording so each record in a frame needs its own slot
+    if (frameCount != _slotFrameCount)
+    {
+        _slotFrameCount = frameCount;
+        _numSlotsUsed = 0;
+    }
+
+    if (_numSlotsUsed < maxViews) return _numSlotsUsed++;
+
+    return maxViews;
+}
+
+void CulledInstanceDraw::traverse(Visitor& visitor)
+{
+    if (!_drawIndexedIndirect) return;
+
+    _bindCulledInstances->accept(visitor);
+    _bindAllInstances->accept(visitor);
+    _bindIndexBuffer->accept(visitor);
+    _drawIndexedIndirect->accept(visitor);
+}
+
+void CulledInstanceDraw::traverse(ConstVisitor& visitor) const
+{
+    if (!_drawIndexedIndirect) return;
+
+    _bindCulledInstances->accept(visitor);
+    _bindAllInstances->accept(visitor);
+    _bindIndexBuffer->accept(visitor);
+    _drawIndexedIndirect->accept(visitor);
+}
+
+void CulledInstanceDraw::traverse(RecordTraversal& visitor) const
+{
+    if (!_drawIndexedIndirect) return;
+
+    auto state = visitor.getState();
+    auto& commandBuffer = *(state->_commandBuffer);
+    auto numInstances = static_cast<uint32_t>(_x.size());
+
+    auto frameStamp = visitor.getFrameStamp();
+    uint32_t slot = _nextSlot(frameStamp ? frameStamp->frameCount : 0);
+    if (slot >= maxViews)
+    {
+        // no slot left in this frame so draw all the instances
+        state->record();
+        _bindAllInstances->record(commandBuffer);
+        _bindIndexBuffer->record(commandBuffer);
+        vkCmdDrawIndexed(commandBuffer, indexCount, numInstances, firstIndex, vertexOffset, 0);
+        return;
+    }
+
+    uint32_t firstInstance = slot * numInstances;
+    const mat4* matrices = instanceMatrices->data();
+    mat4* visibleMatrices = _visibleMatrices->data() + firstInstance;
+    uint32_t numVisible = 0;
+
+    // cull the clusters in blocks so the visibility flags stay on the stack and in cache, then the instances of each visible cluster,
+    // matrices are always copied and the count advanced by the flag to keep the compaction free of branches
+    uint8_t clusterVisible[clusterSize];
+    uint8_t visible[clusterSize];
+
+    size_t numClusters = _clusterX.size();
+    for (size_t firstCluster = 0; firstCluster < numClusters; firstCluster += clusterSize)
+    {
+        size_t clusterCount = std::min(clusterSize, numClusters - firstCluster);
+        state->intersect(&_clusterX[firstCluster], &_clusterY[firstCluster], &_clusterZ[firstCluster], &_clusterRadius[firstCluster], clusterCount, clusterVisible);
+
+        for (size_t c = 0; c < clusterCount; ++c)
+        {
+            if (!clusterVisible[c]) continue;
+
+            size_t first = _clusterOffsets[firstCluster + c];
+            size_t count = _clusterOffsets[firstCluster + c + 1] - first;
+            state->intersect(&_x[first], &_y[first], &_z[first], &_radius[first], count, visible);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                visibleMatrices[numVisible] = matrices[_order[first + i]];
+                numVisible += visible[i];
+            }
+        }
+    }
+
+    if (numVisible == 0) return;
+
+    uint32_t* command = _indirectCommands->data() + slot * indirectCommandSize;
+    command[0] = indexCount;
+    command[1] = numVisible;
+    command[2] = firstIndex;
+    command[3] = vertexOffset;
+    command[4] = firstInstance;
+
+    _visibleMatrices->dirty();
+    _indirectCommands->dirty();
+
+    state->record();
+    _bindCulledInstances->record(commandBuffer);
+    _bindIndexBuffer->record(commandBuffer);
+
+    auto& bufferInfo = _drawIndexedIndirect->bufferInfo;
+    vkCmdDrawIndexedIndirect(commandBuffer, bufferInfo->buffer->vk(commandBuffer.deviceID), bufferInfo->offset + slot * _drawIndexedIndirect->stride, 1, _drawIndexedIndirect->stride);
+}
@@ -29,7 +29,7 @@ void* Node::operator new(std::size_t count)
     return vsg::allocate(count, vsg::ALLOCATOR_AFFINITY_NODES);
 }
 
-void Node::operator delete(void* ptr)
+void Node::operator delete(void* ptr, std::size_t size)
 {
-    vsg::deallocate(ptr);
+    vsg::deallocate(ptr, size, vsg::ALLOCATOR_AFFINITY_NODES);
 }
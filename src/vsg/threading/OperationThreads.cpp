@@ -13,28 +13,198 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/io/Options.h>
 #include <vsg/threading/OperationThreads.h>
 
+#include <deque>
+#include <limits>
+#include <vector>
+
 using namespace vsg;
 
-OperationThreads::OperationThreads(uint32_t numThreads, ref_ptr<ActivityStatus> in_status) :
-    status(in_status)
+namespace
 {
-    if (!status) status = ActivityStatus::create();
-    queue = OperationQueue::create(status);
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<ref_ptr<Operation>> operations;       // run LIFO by the owning thread, stolen FIFO by other threads
+        std::deque<ref_ptr<Operation>> pinnedOperations; // only run by the owning thread
+        std::atomic_size_t numPinned = 0;
+        Affinity affinity;
+    };
+
+    const uint32_t s_noWorker = std::numeric_limits<uint32_t>::max();
+} // namespace
+
+struct OperationThreads::Scheduler : public Object
+{
+    Scheduler(ref_ptr<OperationQueue> in_queue, ref_ptr<ActivityStatus> in_status, uint32_t numThreads) :
+        queue(in_queue),
+        status(in_status)
+    {
+        for (uint32_t i = 0; i < numThreads; ++i)
+        {
+            workers.emplace_back(new Worker);
+        }
+    }
+
+    ref_ptr<OperationQueue> queue;
+    ref_ptr<ActivityStatus> status;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic_uint32_t numIdle = 0;
+    std::atomic_size_t numStealable = 0;
+    std::atomic_uint32_t nextPinned = 0;
+
+    // the Scheduler and worker index associated with the current thread, set for the lifetime of each worker thread
+    static thread_local Scheduler* s_current;
+    static thread_local uint32_t s_currentWorker;
+
+    uint32_t currentWorker() const { return s_current == this ? s_currentWorker : s_noWorker; }
+
+    void add(ref_ptr<Operation> operation)
+    {
+        uint32_t index = currentWorker();
+        if (index == s_noWorker)
+        {
+            queue->add(operation);
+            return;
+        }
+
+        auto& worker = *workers[index];
+        {
+            std::scoped_lock lock(worker.mutex);
+            worker.operations.push_back(operation);
+            ++numStealable;
+        }
 
-    auto run = [](ref_ptr<OperationQueue> q, ref_ptr<ActivityStatus> thread_status) {
-        while (thread_status->active())
+        // wake any idle workers so they can steal the new operation
+        if (numIdle.load() > 0) queue->wake_waiting();
+    }
+
+    void add(ref_ptr<Operation> operation, const Affinity& affinity)
+    {
+        // assign to the matching workers in turn
+        std::vector<Worker*> matching;
+        for (auto& worker : workers)
+        {
+            std::scoped_lock lock(worker->mutex);
+            for (auto cpu : worker->affinity.cpus)
+            {
+                if (affinity.cpus.count(cpu) > 0)
+                {
+                    matching.push_back(worker.get());
+                    break;
+                }
+            }
+        }
+
+        if (matching.empty())
+        {
+            add(operation);
+            return;
+        }
+
+        auto& worker = *matching[nextPinned.fetch_add(1) % matching.size()];
+        {
+            std::scoped_lock lock(worker.mutex);
+            worker.pinnedOperations.push_back(operation);
+            ++worker.numPinned;
+        }
+
+        if (numIdle.load() > 0) queue->wake_waiting();
+    }
+
+    ref_ptr<Operation> take(uint32_t index)
+    {
+        ref_ptr<Operation> operation;
+
+        // first check the worker's own pinned operations and deque
+        if (index < workers.size())
         {
-            ref_ptr<Operation> operation = q->take_when_available();
+            auto& worker = *workers[index];
+            std::scoped_lock lock(worker.mutex);
+            if (!worker.pinnedOperations.empty())
+            {
+                operation = std::move(worker.pinnedOperations.front());
+                worker.pinnedOperations.pop_front();
+                --worker.numPinned;
+                return operation;
+            }
+            if (!worker.operations.empty())
+            {
+                operation = std::move(worker.operations.back());
+                worker.operations.pop_back();
+                --numStealable;
+                return operation;
+            }
+        }
+
+        // next the shared queue
+        if ((operation = queue->take())) return operation;
+
+        // finally try to steal the oldest operation from the other workers
+        if (numStealable.load() == 0) return operation;
+
+        size_t numWorkers = workers.size();
+        size_t start = (index < numWorkers) ? index + 1 : 0;
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            size_t victim = (start + i) % numWorkers;
+            if (victim == index) continue;
+
+            auto& worker = *workers[victim];
+            std::scoped_lock lock(worker.mutex);
+            if (!worker.operations.empty())
+            {
+                operation = std::move(worker.operations.front());
+                worker.operations.pop_front();
+                --numStealable;
+                return operation;
+            }
+        }
+
+        return operation;
+    }
+
+    void run(uint32_t index)
+    {
+        s_current = this;
+        s_currentWorker = index;
+
+        auto& worker = *workers[index];
+        auto workAvailable = [&]() { return numStealable.load() > 0 || worker.numPinned.load() > 0; };
+
+        while (status->active())
+        {
+            ref_ptr<Operation> operation = take(index);
+            if (!operation)
+            {
+                // numIdle is incremented before workAvailable() is checked so that add() sees this thread as idle and wakes it
+                ++numIdle;
+                operation = queue->take_when_available(workAvailable);
+                --numIdle;
+            }
+
             if (operation)
             {
                 operation->run();
             }
         }
-    };
 
-    for (size_t i = 0; i < numThreads; ++i)
+        s_current = nullptr;
+    }
+};
+
+thread_local OperationThreads::Scheduler* OperationThreads::Scheduler::s_current = nullptr;
+thread_local uint32_t OperationThreads::Scheduler::s_currentWorker = 0;
+
+OperationThreads::OperationThreads(uint32_t numThreads, ref_ptr<ActivityStatus> in_status) :
+    status(in_status)
+{
+    if (!status) status = ActivityStatus::create();
+    queue = OperationQueue::create(status);
+    _scheduler = new Scheduler(queue, status, numThreads);
+
+    for (uint32_t i = 0; i < numThreads; ++i)
     {
-        threads.emplace_back(run, queue, status);
+        threads.emplace_back([](ref_ptr<Scheduler> scheduler, uint32_t index) { scheduler->run(index); }, _scheduler, i);
     }
 }
 
@@ -43,21 +213,65 @@ OperationThreads::~OperationThreads()
     stop();
 }
 
+void OperationThreads::add(ref_ptr<Operation> operation)
+{
+    _scheduler->add(operation);
+}
+
+void OperationThreads::add(ref_ptr<Operation> operation, const Affinity& affinity)
+{
+    _scheduler->add(operation, affinity);
+}
+
+void OperationThreads::setAffinity(const Affinity& affinity)
+{
+    if (!affinity) return;
+
+    auto cpu_itr = affinity.cpus.begin();
+    auto thread_itr = threads.begin();
+    for (auto& worker : _scheduler->workers)
+    {
+        if (thread_itr == threads.end()) break;
+
+        Affinity threadAffinity(*cpu_itr);
+        {
+            std::scoped_lock lock(worker->mutex);
+            worker->affinity = threadAffinity;
+        }
+        vsg::setAffinity(*thread_itr, threadAffinity);
+
+        ++thread_itr;
+        if (++cpu_itr == affinity.cpus.end()) cpu_itr = affinity.cpus.begin();
+    }
+}
+
 void OperationThreads::run()
 {
-    while (ref_ptr<Operation> operation = queue->take())
+    while (run_one())
     {
-        operation->run();
     }
 }
 
+bool OperationThreads::run_one()
+{
+    auto operation = _scheduler->take(_scheduler->currentWorker());
+    if (!operation) return false;
+
+    operation->run();
+    return true;
+}
+
 void OperationThreads::stop()
 {
     status->set(false);
 
     for (auto& thread : threads)
     {
-        thread.join();
+        // the last reference to this OperationThreads may have been released by an operation running on one of its threads, which can't join itself
+        if (thread.get_id() == std::this_thread::get_id())
+            thread.detach();
+        else
+            thread.join();
     }
 
     threads.clear();
@@ -0,0 +1,113 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/threading/TaskGroup.h>
+
+using namespace vsg;
+
+struct TaskGroup::Task : public Operation
+{
+    Task(ref_ptr<TaskGroup> in_group, ref_ptr<Operation> in_operation) :
+        group(in_group),
+        operation(in_operation) {}
+
+    void run() override
+    {
+        operation->run();
+        group->decrement();
+    }
+
+    ref_ptr<TaskGroup> group;
+    ref_ptr<Operation> operation;
+};
+
+TaskGroup::TaskGroup(ref_ptr<OperationThreads> in_operationThreads, ref_ptr<TaskGroup> in_parent) :
+    operationThreads(in_operationThreads),
+    parent(in_parent)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+}
+
+void TaskGroup::increment()
+{
+    std::scoped_lock lock(_mutex);
+    if (_pending++ == 0 && parent) parent->increment();
+}
+
+void TaskGroup::decrement()
+{
+    std::vector<ref_ptr<Operation>> continuations;
+    {
+        std::scoped_lock lock(_mutex);
+        if (--_pending > 0) return;
+
+        continuations.swap(_continuations);
+    }
+
+    // schedule continuations before releasing the parent so that it can't complete ahead of them
+    for (auto& continuation : continuations)
+    {
+        if (parent)
+            parent->run(continuation);
+        else
+            operationThreads->add(continuation);
+    }
+
+    if (parent) parent->decrement();
+
+    std::scoped_lock lock(_mutex);
+    _cv.notify_all();
+}
+
+void TaskGroup::run(ref_ptr<Operation> operation, const Affinity& affinity)
+{
+    increment();
+
+    ref_ptr<Operation> task(new Task(ref_ptr<TaskGroup>(this), operation));
+    if (affinity)
+        operationThreads->add(task, affinity);
+    else
+        operationThreads->add(task);
+}
+
+void TaskGroup::then(ref_ptr<Operation> continuation)
+{
+    {
+        std::scoped_lock lock(_mutex);
+        if (_pending > 0)
+        {
+            _continuations.push_back(continuation);
+            return;
+        }
+    }
+
+    if (parent)
+        parent->run(continuation);
+    else
+        operationThreads->add(continuation);
+}
+
+void TaskGroup::wait()
+{
+    while (!done())
+    {
+        // help out by running available operations, these may belong to this group or unrelated work
+        if (operationThreads->run_one()) continue;
+
+        // nothing available to run so the remaining operations are running on other threads, wait for them to complete or add new operations
+        std::unique_lock lock(_mutex);
+        if (_pending > 0) _cv.wait_for(lock, std::chrono::milliseconds(1));
+    }
+}
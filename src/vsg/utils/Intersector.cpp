@@ -22,13 +22,17 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/nodes/Geometry.h>
 #include <vsg/nodes/LOD.h>
 #include <vsg/nodes/PagedLOD.h>
+#include <vsg/nodes/QuadGroup.h>
 #include <vsg/nodes/StateGroup.h>
 #include <vsg/nodes/Transform.h>
 #include <vsg/nodes/VertexDraw.h>
 #include <vsg/nodes/VertexIndexDraw.h>
 #include <vsg/state/GraphicsPipeline.h>
+#include <vsg/threading/TaskGroup.h>
 #include <vsg/utils/Intersector.h>
 
+#include <typeinfo>
+
 using namespace vsg;
 
 struct PushPopNode
@@ -40,7 +44,8 @@ struct PushPopNode
     ~PushPopNode() { nodePath.pop_back(); }
 };
 
-Intersector::Intersector(ref_ptr<ArrayState> initialArrayState)
+Intersector::Intersector(ref_ptr<ArrayState> initialArrayState) :
+    triangleBVHCache(TriangleBVHCache::instance())
 {
     arrayStateStack.reserve(4);
     arrayStateStack.emplace_back(initialArrayState ? initialArrayState : ArrayState::create());
@@ -48,13 +53,45 @@ Intersector::Intersector(ref_ptr<ArrayState> initialArrayState)
 
 void Intersector::apply(const Node& node)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &node);
 
     node.traverse(*this);
 }
 
+void Intersector::apply(const Group& group)
+{
+    if (done()) return;
+
+    PushPopNode ppn(_nodePath, &group);
+
+    if (operationThreads && _parallelLevel < parallelDepth && group.children.size() > 1)
+    {
+        if (traverseInParallel(group.children.data(), group.children.data() + group.children.size())) return;
+    }
+
+    group.traverse(*this);
+}
+
+void Intersector::apply(const QuadGroup& group)
+{
+    if (done()) return;
+
+    PushPopNode ppn(_nodePath, &group);
+
+    if (operationThreads && _parallelLevel < parallelDepth)
+    {
+        if (traverseInParallel(group.children.data(), group.children.data() + group.children.size())) return;
+    }
+
+    group.traverse(*this);
+}
+
 void Intersector::apply(const StateGroup& stategroup)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &stategroup);
 
     auto arrayState = stategroup.prototypeArrayState ? stategroup.prototypeArrayState->clone(arrayStateStack.back()) : arrayStateStack.back()->clone();
@@ -73,6 +110,8 @@ void Intersector::apply(const StateGroup& stategroup)
 
 void Intersector::apply(const Transform& transform)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &transform);
 
     pushTransform(transform);
@@ -84,6 +123,8 @@ void Intersector::apply(const Transform& transform)
 
 void Intersector::apply(const LOD& lod)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &lod);
 
     if (intersects(lod.bound))
@@ -101,6 +142,8 @@ void Intersector::apply(const LOD& lod)
 
 void Intersector::apply(const PagedLOD& plod)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &plod);
 
     if (intersects(plod.bound))
@@ -118,6 +161,8 @@ void Intersector::apply(const PagedLOD& plod)
 
 void Intersector::apply(const CullNode& cn)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &cn);
 
     if (intersects(cn.bound)) cn.traverse(*this);
@@ -125,6 +170,8 @@ void Intersector::apply(const CullNode& cn)
 
 void Intersector::apply(const CullGroup& cn)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &cn);
 
     if (intersects(cn.bound)) cn.traverse(*this);
@@ -132,6 +179,8 @@ void Intersector::apply(const CullGroup& cn)
 
 void Intersector::apply(const DepthSorted& cn)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &cn);
 
     if (intersects(cn.bound)) cn.traverse(*this);
@@ -139,6 +188,8 @@ void Intersector::apply(const DepthSorted& cn)
 
 void Intersector::apply(const VertexDraw& vid)
 {
+    if (done()) return;
+
     auto& arrayState = *arrayStateStack.back();
     arrayState.apply(vid);
     if (!arrayState.vertices) return;
@@ -150,6 +201,8 @@ void Intersector::apply(const VertexDraw& vid)
 
 void Intersector::apply(const VertexIndexDraw& vid)
 {
+    if (done()) return;
+
     auto& arrayState = *arrayStateStack.back();
     arrayState.apply(vid);
     if (!arrayState.vertices) return;
@@ -163,6 +216,8 @@ void Intersector::apply(const VertexIndexDraw& vid)
 
 void Intersector::apply(const Geometry& geometry)
 {
+    if (done()) return;
+
     auto& arrayState = *arrayStateStack.back();
     arrayState.apply(geometry);
     if (!arrayState.vertices) return;
@@ -206,6 +261,8 @@ void Intersector::apply(const uintArray& array)
 
 void Intersector::apply(const Draw& draw)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &draw);
 
     intersectDraw(draw.firstVertex, draw.vertexCount, draw.firstInstance, draw.instanceCount);
@@ -213,7 +270,106 @@ void Intersector::apply(const Draw& draw)
 
 void Intersector::apply(const DrawIndexed& drawIndexed)
 {
+    if (done()) return;
+
     PushPopNode ppn(_nodePath, &drawIndexed);
 
     intersectDrawIndexed(drawIndexed.firstIndex, drawIndexed.indexCount, drawIndexed.firstInstance, drawIndexed.instanceCount);
 }
+
+struct IntersectSubgraph : public Operation
+{
+    IntersectSubgraph(ref_ptr<Intersector> in_intersector, const Node* in_node) :
+        intersector(in_intersector),
+        node(in_node) {}
+
+    void run() override
+    {
+        node->accept(*intersector);
+    }
+
+    ref_ptr<Intersector> intersector;
+    const Node* node;
+};
+
+bool Intersector::traverseInParallel(const ref_ptr<Node>* first, const ref_ptr<Node>* last)
+{
+    std::vector<ref_ptr<Intersector>> subgraphIntersectors;
+    for (auto itr = first; itr != last; ++itr)
+    {
+        if (!*itr) continue;
+
+        auto subgraphIntersector = createSubgraphIntersector();
+        if (!subgraphIntersector || typeid(*subgraphIntersector) != typeid(*this)) return false;
+
+        // each subgraph Intersector has its own copy of the ArrayState stack as ArrayState is modified during traversal
+        subgraphIntersector->arrayStateStack.clear();
+        for (auto& arrayState : arrayStateStack) subgraphIntersector->arrayStateStack.push_back(arrayState->clone());
+
+        subgraphIntersector->ushort_indices = ushort_indices;
+        subgraphIntersector->uint_indices = uint_indices;
+        subgraphIntersector->_nodePath = _nodePath;
+        subgraphIntersector->_parallelLevel = _parallelLevel + 1;
+        subgraphIntersector->operationThreads = operationThreads;
+        subgraphIntersector->parallelDepth = parallelDepth;
+        subgraphIntersector->hitMode = hitMode;
+        subgraphIntersector->useTriangleBVH = useTriangleBVH;
+        subgraphIntersector->triangleBVHCache = triangleBVHCache;
+        subgraphIntersector->minimumTrianglesForBVH = minimumTrianglesForBVH;
+
+        subgraphIntersectors.push_back(subgraphIntersector);
+    }
+
+    if (subgraphIntersectors.size() < 2) return false;
+
+    // the outermost parallel traversal creates the hit state shared by all the nested subgraph Intersectors
+    bool ownSharedHits = !_sharedHits && hitMode != ALL_HITS;
+    if (ownSharedHits) _sharedHits = std::make_shared<SharedHits>();
+    for (auto& subgraphIntersector : subgraphIntersectors) subgraphIntersector->_sharedHits = _sharedHits;
+
+    auto taskGroup = TaskGroup::create(operationThreads);
+
+    size_t i = 0;
+    for (auto itr = first; itr != last; ++itr)
+    {
+        if (*itr) taskGroup->run(ref_ptr<Operation>(new IntersectSubgraph(subgraphIntersectors[i++], itr->get())));
+    }
+
+    taskGroup->wait();
+
+    mergeSubgraphIntersectors(subgraphIntersectors);
+
+    if (hitMode == ANY_HIT && _sharedHits && _sharedHits->done) _done = true;
+    if (ownSharedHits) _sharedHits = {};
+
+    return true;
+}
+
+void Intersector::stopTraversal()
+{
+    _done = true;
+    if (_sharedHits) _sharedHits->done = true;
+}
+
+void Intersector::shareClosestHit(double distance)
+{
+    if (!_sharedHits) return;
+
+    double closest = _sharedHits->closest.load();
+    while (distance < closest && !_sharedHits->closest.compare_exchange_weak(closest, distance)) {}
+}
+
+ref_ptr<const TriangleBVH> Intersector::getOrCreateTriangleBVH(ref_ptr<const vec3Array> vertices, uint32_t firstIndex, uint32_t indexCount)
+{
+    if (!useTriangleBVH || !triangleBVHCache || !vertices || (indexCount / 3) < minimumTrianglesForBVH) return {};
+
+    ref_ptr<const Data> indices;
+    if (ushort_indices)
+        indices = ushort_indices;
+    else if (uint_indices)
+        indices = uint_indices;
+    else
+        return {};
+
+    return triangleBVHCache->getOrCreate(vertices, indices, firstIndex, indexCount);
+}
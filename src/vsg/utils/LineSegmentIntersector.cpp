@@ -14,6 +14,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/nodes/Transform.h>
 #include <vsg/utils/LineSegmentIntersector.h>
 
+#include <algorithm>
+
 using namespace vsg;
 
 template<typename V>
@@ -180,15 +182,29 @@ LineSegmentIntersector::Intersection::Intersection(const dvec3& in_localIntersec
 
 ref_ptr<LineSegmentIntersector::Intersection> LineSegmentIntersector::add(const dvec3& coord, double ratio, const IndexRatios& indexRatios, uint32_t instanceIndex)
 {
-    ref_ptr<Intersection> intersection;
+    // avoid creating Intersection objects for hits that would be discarded
+    if (!recordHit(intersections, &Intersection::ratio, ratio)) return {};
 
     auto localToWorld = computeTransform(_nodePath);
-    intersection = Intersection::create(coord, localToWorld * coord, ratio, localToWorld, _nodePath, arrayStateStack.back()->arrays, indexRatios, instanceIndex);
+    auto intersection = Intersection::create(coord, localToWorld * coord, ratio, localToWorld, _nodePath, arrayStateStack.back()->arrays, indexRatios, instanceIndex);
     intersections.emplace_back(intersection);
 
     return intersection;
 }
 
+ref_ptr<Intersector> LineSegmentIntersector::createSubgraphIntersector()
+{
+    const auto& worldLineSegment = _lineSegmentStack.front();
+    auto subgraphIntersector = LineSegmentIntersector::create(worldLineSegment.start, worldLineSegment.end);
+    subgraphIntersector->_lineSegmentStack = _lineSegmentStack;
+    return subgraphIntersector;
+}
+
+void LineSegmentIntersector::mergeSubgraphIntersectors(const std::vector<ref_ptr<Intersector>>& subgraphIntersectors)
+{
+    mergeIntersections<LineSegmentIntersector>(intersections, &Intersection::ratio, subgraphIntersectors);
+}
+
 void LineSegmentIntersector::pushTransform(const Transform& transform)
 {
     auto& l2wStack = localToWorldStack();
@@ -241,6 +257,9 @@ bool LineSegmentIntersector::intersects(const dsphere& bs)
     if (r1 <= 0.0 && r2 <= 0.0) return false;
     if (r1 >= 1.0 && r2 >= 1.0) return false;
 
+    // subgraph can't contain a hit closer than the current closest
+    if (hitMode == CLOSEST_HIT && r1 >= closestHit(intersections, &Intersection::ratio)) return false;
+
     // passed all the rejection tests so line must intersect bounding sphere, return true.
     return true;
 }
@@ -252,7 +271,7 @@ bool LineSegmentIntersector::intersectDraw(uint32_t firstVertex, uint32_t vertex
 
     const auto& ls = _lineSegmentStack.back();
 
-    size_t previous_size = intersections.size();
+    size_t previous_numRecordedHits = _numRecordedHits;
     uint32_t lastIndex = instanceCount > 1 ? (firstInstance + instanceCount) : firstInstance + 1;
     for (uint32_t instanceIndex = firstInstance; instanceIndex < lastIndex; ++instanceIndex)
     {
@@ -261,13 +280,13 @@ bool LineSegmentIntersector::intersectDraw(uint32_t firstVertex, uint32_t vertex
 
         uint32_t endVertex = int((firstVertex + vertexCount) / 3.0f) * 3;
 
-        for (uint32_t i = firstVertex; i < endVertex; i += 3)
+        for (uint32_t i = firstVertex; i < endVertex && !done(); i += 3)
         {
             triIntersector.intersect(i, i + 1, i + 2);
         }
     }
 
-    return intersections.size() != previous_size;
+    return _numRecordedHits != previous_numRecordedHits;
 }
 
 bool LineSegmentIntersector::intersectDrawIndexed(uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance, uint32_t instanceCount)
@@ -277,7 +296,7 @@ bool LineSegmentIntersector::intersectDrawIndexed(uint32_t firstIndex, uint32_t
 
     const auto& ls = _lineSegmentStack.back();
 
-    size_t previous_size = intersections.size();
+    size_t previous_numRecordedHits = _numRecordedHits;
     uint32_t lastIndex = instanceCount > 1 ? (firstInstance + instanceCount) : firstInstance + 1;
     for (uint32_t instanceIndex = firstInstance; instanceIndex < lastIndex; ++instanceIndex)
     {
@@ -286,23 +305,44 @@ bool LineSegmentIntersector::intersectDrawIndexed(uint32_t firstIndex, uint32_t
 
         triIntersector.instanceIndex = instanceIndex;
 
+        // per instance vertex arrays computed by the ArrayState are transient so only use the TriangleBVH for the shared vertex array
+        auto bvh = (triIntersector.vertices == arrayState.vertices) ? getOrCreateTriangleBVH(triIntersector.vertices, firstIndex, indexCount) : ref_ptr<const TriangleBVH>();
+        if (bvh)
+        {
+            if (ushort_indices)
+            {
+                bvh->intersect(ls.start, ls.end, [&](uint32_t i) {
+                    triIntersector.intersect(ushort_indices->at(i), ushort_indices->at(i + 1), ushort_indices->at(i + 2));
+                    return !done();
+                });
+            }
+            else if (uint_indices)
+            {
+                bvh->intersect(ls.start, ls.end, [&](uint32_t i) {
+                    triIntersector.intersect(uint_indices->at(i), uint_indices->at(i + 1), uint_indices->at(i + 2));
+                    return !done();
+                });
+            }
+            continue;
+        }
+
         uint32_t endIndex = int((firstIndex + indexCount) / 3.0f) * 3;
 
         if (ushort_indices)
         {
-            for (uint32_t i = firstIndex; i < endIndex; i += 3)
+            for (uint32_t i = firstIndex; i < endIndex && !done(); i += 3)
             {
                 triIntersector.intersect(ushort_indices->at(i), ushort_indices->at(i + 1), ushort_indices->at(i + 2));
             }
         }
         else if (uint_indices)
         {
-            for (uint32_t i = firstIndex; i < endIndex; i += 3)
+            for (uint32_t i = firstIndex; i < endIndex && !done(); i += 3)
             {
                 triIntersector.intersect(uint_indices->at(i), uint_indices->at(i + 1), uint_indices->at(i + 2));
             }
         }
     }
 
-    return intersections.size() != previous_size;
+    return _numRecordedHits != previous_numRecordedHits;
 }
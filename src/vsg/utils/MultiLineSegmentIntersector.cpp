@@ -0,0 +1,479 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/nodes/Transform.h>
+#include <vsg/utils/MultiLineSegmentIntersector.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace vsg;
+
+// return true if the line segment intersects the sphere, assigning the ratio at which the line segment enters it
+static bool intersectsSphere(const dvec3& start, const dvec3& end, const dsphere& bs, double& entryRatio)
+{
+    entryRatio = 0.0;
+
+    dvec3 sm = start - bs.center;
+    double c = length2(sm) - bs.radius * bs.radius;
+    if (c < 0.0) return true;
+
+    dvec3 se = end - start;
+    double a = length2(se);
+    double b = dot(sm, se) * 2.0;
+    double d = b * b - 4.0 * a * c;
+
+    if (d < 0.0) return false;
+
+    d = sqrt(d);
+
+    double div = 1.0 / (2.0 * a);
+
+    double r1 = (-b - d) * div;
+    double r2 = (-b + d) * div;
+
+    if (r1 <= 0.0 && r2 <= 0.0) return false;
+    if (r1 >= 1.0 && r2 >= 1.0) return false;
+
+    entryRatio = std::max(r1, 0.0);
+    return true;
+}
+
+MultiLineSegmentIntersector::MultiLineSegmentIntersector(const LineSegments& in_lineSegments, ref_ptr<ArrayState> initialArrayData) :
+    Inherit(initialArrayData)
+{
+    _lineSegmentStack.resize(1);
+    reset(in_lineSegments);
+}
+
+void MultiLineSegmentIntersector::reset(const LineSegments& in_lineSegments)
+{
+    _lineSegmentStack.front() = in_lineSegments;
+    _transformDepth = 0;
+
+    hits.clear();
+    nodePaths.clear();
+
+    uint32_t numLineSegments = static_cast<uint32_t>(in_lineSegments.size());
+    _activeIndices.resize(numLineSegments);
+    for (uint32_t i = 0; i < numLineSegments; ++i) _activeIndices[i] = i;
+
+    _activeLevels.clear();
+    _activeLevels.push_back(ActiveLevel{nullptr, 0, 0, numLineSegments});
+
+    _closestRatios.assign(numLineSegments, std::numeric_limits<double>::max());
+    _hitIndices.assign(numLineSegments, invalidHitIndex);
+    _numLineSegmentsHit = 0;
+    _done = false;
+}
+
+bool MultiLineSegmentIntersector::_active(uint32_t lineSegmentIndex, double entryRatio) const
+{
+    switch (hitMode)
+    {
+    case (CLOSEST_HIT): return entryRatio < _closestRatios[lineSegmentIndex];
+    case (ANY_HIT): return _closestRatios[lineSegmentIndex] == std::numeric_limits<double>::max();
+    default: return true;
+    }
+}
+
+void MultiLineSegmentIntersector::_updateHitIndices()
+{
+    _hitIndices.assign(_hitIndices.size(), invalidHitIndex);
+    _numLineSegmentsHit = 0;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(hits.size()); ++i)
+    {
+        auto& hit = hits[i];
+        if (_hitIndices[hit.lineSegmentIndex] == invalidHitIndex)
+        {
+            _hitIndices[hit.lineSegmentIndex] = i;
+            ++_numLineSegmentsHit;
+        }
+        _closestRatios[hit.lineSegmentIndex] = std::min(_closestRatios[hit.lineSegmentIndex], hit.ratio);
+    }
+}
+
+MultiLineSegmentIntersector::NodePath MultiLineSegmentIntersector::nodePath(const Hit& hit) const
+{
+    auto begin = nodePaths.begin() + hit.nodePathOffset;
+    return NodePath(begin, begin + hit.nodePathSize);
+}
+
+void MultiLineSegmentIntersector::sort()
+{
+    std::stable_sort(hits.begin(), hits.end(), [](const Hit& lhs, const Hit& rhs) {
+        if (lhs.lineSegmentIndex != rhs.lineSegmentIndex) return lhs.lineSegmentIndex < rhs.lineSegmentIndex;
+        return lhs.ratio < rhs.ratio;
+    });
+
+    if (hitMode != ALL_HITS)
+    {
+        // only the first hit of each line segment is retained
+        auto last = std::unique(hits.begin(), hits.end(), [](const Hit& lhs, const Hit& rhs) { return lhs.lineSegmentIndex == rhs.lineSegmentIndex; });
+        hits.erase(last, hits.end());
+
+        _updateHitIndices();
+    }
+}
+
+ref_ptr<Intersector> MultiLineSegmentIntersector::createSubgraphIntersector()
+{
+    auto subgraphIntersector = MultiLineSegmentIntersector::create();
+    subgraphIntersector->_lineSegmentStack = _lineSegmentStack;
+    subgraphIntersector->_transformDepth = _transformDepth;
+    subgraphIntersector->_activeIndices = _activeIndices;
+    subgraphIntersector->_activeLevels = _activeLevels;
+    subgraphIntersector->_closestRatios = _closestRatios;
+    subgraphIntersector->_hitIndices.assign(_hitIndices.size(), invalidHitIndex);
+    subgraphIntersector->_numLineSegmentsHit = _numLineSegmentsHit;
+    return subgraphIntersector;
+}
+
+void MultiLineSegmentIntersector::mergeSubgraphIntersectors(const std::vector<ref_ptr<Intersector>>& subgraphIntersectors)
+{
+    for (auto& intersector : subgraphIntersectors)
+    {
+        auto mlsi = intersector.cast<MultiLineSegmentIntersector>();
+        if (!mlsi) continue;
+
+        uint32_t nodePathOffset = static_cast<uint32_t>(nodePaths.size());
+        nodePaths.insert(nodePaths.end(), mlsi->nodePaths.begin(), mlsi->nodePaths.end());
+
+        for (auto hit : mlsi->hits)
+        {
+            hit.nodePathOffset += nodePathOffset;
+            hits.push_back(hit);
+        }
+    }
+
+    sort();
+
+    if (hitMode == ANY_HIT) _done = (_numLineSegmentsHit == _hitIndices.size());
+}
+
+void MultiLineSegmentIntersector::pushTransform(const Transform& transform)
+{
+    auto& l2wStack = localToWorldStack();
+    auto& w2lStack = worldToLocalStack();
+
+    dmat4 localToWorld = l2wStack.empty() ? transform.transform(dmat4{}) : transform.transform(l2wStack.back());
+    dmat4 worldToLocal = inverse(localToWorld);
+
+    l2wStack.push_back(localToWorld);
+    w2lStack.push_back(worldToLocal);
+
+    ++_transformDepth;
+    if (_lineSegmentStack.size() <= _transformDepth) _lineSegmentStack.emplace_back();
+
+    const auto& worldLineSegments = _lineSegmentStack.front();
+    auto& localLineSegments = _lineSegmentStack[_transformDepth];
+    localLineSegments.resize(worldLineSegments.size());
+
+    // only the line segments active for the subgraph can be used beneath it, so only these need transforming
+    _popInactiveLevels();
+    const auto& level = _activeLevels.back();
+    for (size_t i = level.offset; i < level.offset + level.count; ++i)
+    {
+        uint32_t index = _activeIndices[i];
+        localLineSegments[index] = LineSegment{worldToLocal * worldLineSegments[index].start, worldToLocal * worldLineSegments[index].end};
+    }
+}
+
+void MultiLineSegmentIntersector::popTransform()
+{
+    --_transformDepth;
+    localToWorldStack().pop_back();
+    worldToLocalStack().pop_back();
+}
+
+void MultiLineSegmentIntersector::_popInactiveLevels()
+{
+    // levels are only valid while the node they were computed for remains in the NodePath
+    while (_activeLevels.size() > 1)
+    {
+        const auto& level = _activeLevels.back();
+        if (level.depth <= _nodePath.size() && _nodePath[level.depth - 1] == level.node) break;
+
+        _activeIndices.resize(level.offset);
+        _activeLevels.pop_back();
+    }
+}
+
+bool MultiLineSegmentIntersector::intersects(const dsphere& bs)
+{
+    if (!bs.valid()) return false;
+
+    _popInactiveLevels();
+
+    // discard any level computed for the node being tested as it will be recomputed
+    size_t depth = _nodePath.size();
+    if (depth > 0 && _activeLevels.size() > 1 && _activeLevels.back().depth >= depth)
+    {
+        _activeIndices.resize(_activeLevels.back().offset);
+        _activeLevels.pop_back();
+    }
+
+    ActiveLevel parent = _activeLevels.back();
+    const auto& lineSegments = _lineSegmentStack[_transformDepth];
+
+    size_t offset = _activeIndices.size();
+    for (size_t i = parent.offset; i < parent.offset + parent.count; ++i)
+    {
+        uint32_t index = _activeIndices[i];
+        const auto& lineSegment = lineSegments[index];
+        double entryRatio;
+        if (intersectsSphere(lineSegment.start, lineSegment.end, bs, entryRatio) && _active(index, entryRatio)) _activeIndices.push_back(index);
+    }
+
+    size_t count = _activeIndices.size() - offset;
+
+    // no need for a new level if none of the line segments have been culled
+    if (count == 0 || count == parent.count || depth == 0)
+    {
+        _activeIndices.resize(offset);
+        return count > 0;
+    }
+
+    _activeLevels.push_back(ActiveLevel{_nodePath.back(), depth, offset, count});
+    return true;
+}
+
+void MultiLineSegmentIntersector::_assignPackets()
+{
+    _popInactiveLevels();
+
+    const auto& level = _activeLevels.back();
+    const auto& lineSegments = _lineSegmentStack[_transformDepth];
+
+    _packets.clear();
+    for (size_t i = level.offset; i < level.offset + level.count; ++i)
+    {
+        uint32_t index = _activeIndices[i];
+        if (!_active(index, 0.0)) continue;
+
+        if (_packets.empty() || _packets.back().count == 4) _packets.emplace_back();
+
+        auto& packet = _packets.back();
+        uint32_t k = packet.count++;
+
+        const auto& lineSegment = lineSegments[index];
+        dvec3 d = lineSegment.end - lineSegment.start;
+        packet.sx[k] = lineSegment.start.x;
+        packet.sy[k] = lineSegment.start.y;
+        packet.sz[k] = lineSegment.start.z;
+        packet.dx[k] = d.x;
+        packet.dy[k] = d.y;
+        packet.dz[k] = d.z;
+        packet.lineSegmentIndex[k] = index;
+    }
+
+    if (!_packets.empty())
+    {
+        // unused lanes have a zero length segment so never intersect
+        auto& packet = _packets.back();
+        for (uint32_t k = packet.count; k < 4; ++k)
+        {
+            packet.sx[k] = packet.sy[k] = packet.sz[k] = 0.0;
+            packet.dx[k] = packet.dy[k] = packet.dz[k] = 0.0;
+            packet.lineSegmentIndex[k] = 0;
+        }
+    }
+
+    auto& l2wStack = localToWorldStack();
+    _localToWorld = l2wStack.empty() ? dmat4{} : l2wStack.back();
+    _currentNodePathAssigned = false;
+}
+
+void MultiLineSegmentIntersector::_intersectTriangle(const Packet& packet, const vec3Array& vertices, uint32_t i0, uint32_t i1, uint32_t i2, uint32_t instanceIndex)
+{
+    const vec3& v0 = vertices.at(i0);
+    const vec3& v1 = vertices.at(i1);
+    const vec3& v2 = vertices.at(i2);
+
+    double e1x = double(v1.x) - v0.x, e1y = double(v1.y) - v0.y, e1z = double(v1.z) - v0.z;
+    double e2x = double(v2.x) - v0.x, e2y = double(v2.y) - v0.y, e2z = double(v2.z) - v0.z;
+
+    // Moller-Trumbore test of all 4 lanes without branches so the loop can be vectorized, the unnormalized direction gives the ratio directly.
+    double u[4], v[4], t[4];
+    int hit[4];
+    for (int k = 0; k < 4; ++k)
+    {
+        double px = packet.dy[k] * e2z - packet.dz[k] * e2y;
+        double py = packet.dz[k] * e2x - packet.dx[k] * e2z;
+        double pz = packet.dx[k] * e2y - packet.dy[k] * e2x;
+        double det = px * e1x + py * e1y + pz * e1z;
+
+        double tx = packet.sx[k] - v0.x;
+        double ty = packet.sy[k] - v0.y;
+        double tz = packet.sz[k] - v0.z;
+
+        double qx = ty * e1z - tz * e1y;
+        double qy = tz * e1x - tx * e1z;
+        double qz = tx * e1y - ty * e1x;
+
+        double inv_det = (det != 0.0) ? 1.0 / det : 0.0;
+        u[k] = (px * tx + py * ty + pz * tz) * inv_det;
+        v[k] = (qx * packet.dx[k] + qy * packet.dy[k] + qz * packet.dz[k]) * inv_det;
+        t[k] = (qx * e2x + qy * e2y + qz * e2z) * inv_det;
+
+        hit[k] = (inv_det != 0.0) & (u[k] >= 0.0) & (v[k] >= 0.0) & ((u[k] + v[k]) <= 1.0) & (t[k] >= 0.0) & (t[k] <= 1.0);
+    }
+
+    if ((hit[0] | hit[1] | hit[2] | hit[3]) == 0) return;
+
+    for (uint32_t k = 0; k < packet.count; ++k)
+    {
+        if (!hit[k]) continue;
+
+        uint32_t lineSegmentIndex = packet.lineSegmentIndex[k];
+        if (!_active(lineSegmentIndex, t[k])) continue;
+
+        if (!_currentNodePathAssigned)
+        {
+            _currentNodePathOffset = static_cast<uint32_t>(nodePaths.size());
+            nodePaths.insert(nodePaths.end(), _nodePath.begin(), _nodePath.end());
+            _currentNodePathAssigned = true;
+        }
+
+        double r0 = 1.0 - u[k] - v[k];
+
+        // in CLOSEST_HIT and ANY_HIT modes each line segment has at most one hit, which a closer hit replaces
+        Hit* h = nullptr;
+        if (hitMode == ALL_HITS)
+        {
+            h = &hits.emplace_back();
+        }
+        else
+        {
+            uint32_t& hitIndex = _hitIndices[lineSegmentIndex];
+            if (hitIndex == invalidHitIndex)
+            {
+                hitIndex = static_cast<uint32_t>(hits.size());
+                hits.emplace_back();
+                ++_numLineSegmentsHit;
+            }
+            h = &hits[hitIndex];
+
+            _closestRatios[lineSegmentIndex] = t[k];
+            if (hitMode == ANY_HIT && _numLineSegmentsHit == _hitIndices.size()) stopTraversal();
+        }
+
+        ++_numRecordedHits;
+        h->lineSegmentIndex = lineSegmentIndex;
+        h->instanceIndex = instanceIndex;
+        h->ratio = t[k];
+        h->localIntersection = dvec3(v0) * r0 + dvec3(v1) * u[k] + dvec3(v2) * v[k];
+        h->worldIntersection = _localToWorld * h->localIntersection;
+        h->indices[0] = i0;
+        h->indices[1] = i1;
+        h->indices[2] = i2;
+        h->indexRatios[0] = r0;
+        h->indexRatios[1] = u[k];
+        h->indexRatios[2] = v[k];
+        h->nodePathOffset = _currentNodePathOffset;
+        h->nodePathSize = static_cast<uint32_t>(_nodePath.size());
+    }
+}
+
+bool MultiLineSegmentIntersector::intersectDraw(uint32_t firstVertex, uint32_t vertexCount, uint32_t firstInstance, uint32_t instanceCount)
+{
+    auto& arrayState = *arrayStateStack.back();
+    if (arrayState.topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || vertexCount < 3) return false;
+
+    _assignPackets();
+    if (_packets.empty()) return false;
+
+    size_t previous_numRecordedHits = _numRecordedHits;
+    uint32_t lastIndex = instanceCount > 1 ? (firstInstance + instanceCount) : firstInstance + 1;
+    for (uint32_t instanceIndex = firstInstance; instanceIndex < lastIndex; ++instanceIndex)
+    {
+        auto vertices = arrayState.vertexArray(instanceIndex);
+        if (!vertices) return false;
+
+        uint32_t endVertex = int((firstVertex + vertexCount) / 3.0f) * 3;
+
+        for (uint32_t i = firstVertex; i < endVertex && !done(); i += 3)
+        {
+            for (auto& packet : _packets)
+            {
+                _intersectTriangle(packet, *vertices, i, i + 1, i + 2, instanceIndex);
+            }
+        }
+    }
+
+    return _numRecordedHits != previous_numRecordedHits;
+}
+
+bool MultiLineSegmentIntersector::intersectDrawIndexed(uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance, uint32_t instanceCount)
+{
+    auto& arrayState = *arrayStateStack.back();
+    if (arrayState.topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || indexCount < 3) return false;
+
+    _assignPackets();
+    if (_packets.empty()) return false;
+
+    auto intersectTriangles = [&](const Packet& packet, const vec3Array& vertices, uint32_t i, uint32_t instanceIndex) {
+        if (ushort_indices)
+            _intersectTriangle(packet, vertices, ushort_indices->at(i), ushort_indices->at(i + 1), ushort_indices->at(i + 2), instanceIndex);
+        else
+            _intersectTriangle(packet, vertices, uint_indices->at(i), uint_indices->at(i + 1), uint_indices->at(i + 2), instanceIndex);
+    };
+
+    size_t previous_numRecordedHits = _numRecordedHits;
+    uint32_t lastIndex = instanceCount > 1 ? (firstInstance + instanceCount) : firstInstance + 1;
+    for (uint32_t instanceIndex = firstInstance; instanceIndex < lastIndex; ++instanceIndex)
+    {
+        auto vertices = arrayState.vertexArray(instanceIndex);
+        if (!vertices || (!ushort_indices && !uint_indices)) continue;
+
+        // with a TriangleBVH each line segment traverses the hierarchy individually, testing triangles with a single lane packet
+        auto bvh = (vertices == arrayState.vertices) ? getOrCreateTriangleBVH(vertices, firstIndex, indexCount) : ref_ptr<const TriangleBVH>();
+        if (bvh)
+        {
+            for (auto& packet : _packets)
+            {
+                for (uint32_t k = 0; k < packet.count; ++k)
+                {
+                    Packet single;
+                    single.count = 1;
+                    for (int lane = 0; lane < 4; ++lane)
+                    {
+                        single.sx[lane] = packet.sx[k];
+                        single.sy[lane] = packet.sy[k];
+                        single.sz[lane] = packet.sz[k];
+                        single.dx[lane] = lane == 0 ? packet.dx[k] : 0.0;
+                        single.dy[lane] = lane == 0 ? packet.dy[k] : 0.0;
+                        single.dz[lane] = lane == 0 ? packet.dz[k] : 0.0;
+                        single.lineSegmentIndex[lane] = packet.lineSegmentIndex[k];
+                    }
+
+                    dvec3 start(packet.sx[k], packet.sy[k], packet.sz[k]);
+                    dvec3 end = start + dvec3(packet.dx[k], packet.dy[k], packet.dz[k]);
+                    bvh->intersect(start, end, [&](uint32_t i) { intersectTriangles(single, *vertices, i, instanceIndex); });
+                }
+            }
+            continue;
+        }
+
+        uint32_t endIndex = int((firstIndex + indexCount) / 3.0f) * 3;
+
+        for (uint32_t i = firstIndex; i < endIndex && !done(); i += 3)
+        {
+            for (auto& packet : _packets)
+            {
+                intersectTriangles(packet, *vertices, i, instanceIndex);
+            }
+        }
+    }
+
+    return _numRecordedHits != previous_numRecordedHits;
+}
@@ -0,0 +1,255 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/nodes/Transform.h>
+#include <vsg/utils/PolytopeIntersector.h>
+
+#include <algorithm>
+
+using namespace vsg;
+
+PolytopeIntersector::PolytopeIntersector(const Polytope& in_polytope, ref_ptr<ArrayState> initialArrayData) :
+    Inherit(initialArrayData)
+{
+    _polytopeStack.push_back(in_polytope);
+}
+
+PolytopeIntersector::PolytopeIntersector(const Camera& camera, double xMin, double yMin, double xMax, double yMax, ref_ptr<ArrayState> initialArrayData) :
+    Inherit(initialArrayData)
+{
+    auto viewport = camera.getViewport();
+
+    if (xMin > xMax) std::swap(xMin, xMax);
+    if (yMin > yMax) std::swap(yMin, yMax);
+
+    dvec2 ndc_min(-1.0, -1.0), ndc_max(1.0, 1.0);
+    if ((viewport.width > 0) && (viewport.height > 0))
+    {
+        ndc_min.set(((xMin - viewport.x) / viewport.width) * 2.0 - 1.0, ((yMin - viewport.y) / viewport.height) * 2.0 - 1.0);
+        ndc_max.set(((xMax - viewport.x) / viewport.width) * 2.0 - 1.0, ((yMax - viewport.y) / viewport.height) * 2.0 - 1.0);
+    }
+
+    auto projectionMatrix = camera.projectionMatrix->transform();
+    auto viewMatrix = camera.viewMatrix->transform();
+
+    bool reverse_depth = (projectionMatrix(2, 2) > 0.0);
+
+    // planes in clip coordinates, the far plane is omitted as it may be at infinity
+    Polytope clipPolytope{
+        reverse_depth ? dplane(0.0, 0.0, -1.0, 1.0) : dplane(0.0, 0.0, 1.0, 0.0), // near plane
+        dplane(1.0, 0.0, 0.0, -ndc_min.x),                                         // left plane
+        dplane(-1.0, 0.0, 0.0, ndc_max.x),                                         // right plane
+        dplane(0.0, 1.0, 0.0, -ndc_min.y),                                         // bottom plane
+        dplane(0.0, -1.0, 0.0, ndc_max.y)                                          // top plane
+    };
+
+    dmat4 pv = projectionMatrix * viewMatrix;
+
+    Polytope worldPolytope;
+    for (auto& pl : clipPolytope) worldPolytope.push_back(pl * pv);
+
+    _polytopeStack.push_back(worldPolytope);
+}
+
+PolytopeIntersector::Intersection::Intersection(const dvec3& in_localIntersection, const dvec3& in_worldIntersection, double in_distance, const dmat4& in_localToWorld, const NodePath& in_nodePath, const DataList& in_arrays, const IndexRatios& in_indexRatios, uint32_t in_instanceIndex) :
+    localIntersection(in_localIntersection),
+    worldIntersection(in_worldIntersection),
+    distance(in_distance),
+    localToWorld(in_localToWorld),
+    nodePath(in_nodePath),
+    arrays(in_arrays),
+    indexRatios(in_indexRatios),
+    instanceIndex(in_instanceIndex)
+{
+}
+
+ref_ptr<PolytopeIntersector::Intersection> PolytopeIntersector::add(const dvec3& coord, const IndexRatios& indexRatios, uint32_t instanceIndex)
+{
+    auto localToWorld = computeTransform(_nodePath);
+    auto worldCoord = localToWorld * coord;
+
+    const auto& worldPolytope = _polytopeStack.front();
+    double d = worldPolytope.empty() ? 0.0 : vsg::distance(worldPolytope.front(), worldCoord);
+
+    // avoid creating Intersection objects for hits that would be discarded
+    if (!recordHit(intersections, &Intersection::distance, d)) return {};
+
+    auto intersection = Intersection::create(coord, worldCoord, d, localToWorld, _nodePath, arrayStateStack.back()->arrays, indexRatios, instanceIndex);
+    intersections.emplace_back(intersection);
+
+    return intersection;
+}
+
+ref_ptr<Intersector> PolytopeIntersector::createSubgraphIntersector()
+{
+    auto subgraphIntersector = PolytopeIntersector::create(_polytopeStack.front());
+    subgraphIntersector->_polytopeStack = _polytopeStack;
+    return subgraphIntersector;
+}
+
+void PolytopeIntersector::mergeSubgraphIntersectors(const std::vector<ref_ptr<Intersector>>& subgraphIntersectors)
+{
+    mergeIntersections<PolytopeIntersector>(intersections, &Intersection::distance, subgraphIntersectors);
+}
+
+void PolytopeIntersector::pushTransform(const Transform& transform)
+{
+    auto& l2wStack = localToWorldStack();
+    auto& w2lStack = worldToLocalStack();
+
+    dmat4 localToWorld = l2wStack.empty() ? transform.transform(dmat4{}) : transform.transform(l2wStack.back());
+    dmat4 worldToLocal = inverse(localToWorld);
+
+    l2wStack.push_back(localToWorld);
+    w2lStack.push_back(worldToLocal);
+
+    // planes transform by the transpose of the localToWorld matrix, so no inverse is required
+    const auto& worldPolytope = _polytopeStack.front();
+    Polytope localPolytope;
+    localPolytope.reserve(worldPolytope.size());
+    for (auto& pl : worldPolytope) localPolytope.push_back(pl * localToWorld);
+
+    _polytopeStack.push_back(std::move(localPolytope));
+}
+
+void PolytopeIntersector::popTransform()
+{
+    _polytopeStack.pop_back();
+    localToWorldStack().pop_back();
+    worldToLocalStack().pop_back();
+}
+
+bool PolytopeIntersector::intersects(const dsphere& bs)
+{
+    if (!bs.valid()) return false;
+
+    return intersect(_polytopeStack.back(), bs);
+}
+
+bool PolytopeIntersector::_intersectTriangle(const vec3Array& vertices, uint32_t i0, uint32_t i1, uint32_t i2, uint32_t instanceIndex)
+{
+    const dvec3 v0(vertices.at(i0));
+    const dvec3 v1(vertices.at(i1));
+    const dvec3 v2(vertices.at(i2));
+
+    // clip the triangle against each plane in turn, representing the polygon by barycentric coordinates so the result maps directly to index ratios
+    _polygon.clear();
+    _polygon.emplace_back(1.0, 0.0, 0.0);
+    _polygon.emplace_back(0.0, 1.0, 0.0);
+    _polygon.emplace_back(0.0, 0.0, 1.0);
+
+    for (auto& pl : _polytopeStack.back())
+    {
+        auto distanceToPlane = [&](const dvec3& w) { return vsg::distance(pl, v0 * w.x + v1 * w.y + v2 * w.z); };
+
+        size_t numInside = 0;
+        for (auto& w : _polygon)
+        {
+            if (distanceToPlane(w) >= 0.0) ++numInside;
+        }
+
+        if (numInside == _polygon.size()) continue;
+        if (numInside == 0) return false;
+
+        _clippedPolygon.clear();
+        for (size_t i = 0; i < _polygon.size(); ++i)
+        {
+            const dvec3& a = _polygon[i];
+            const dvec3& b = _polygon[(i + 1) % _polygon.size()];
+            double da = distanceToPlane(a);
+            double db = distanceToPlane(b);
+
+            if (da >= 0.0) _clippedPolygon.push_back(a);
+            if ((da >= 0.0) != (db >= 0.0)) _clippedPolygon.push_back(a + (b - a) * (da / (da - db)));
+        }
+
+        _polygon.swap(_clippedPolygon);
+    }
+
+    dvec3 center;
+    for (auto& w : _polygon) center += w;
+    center /= static_cast<double>(_polygon.size());
+
+    return add(v0 * center.x + v1 * center.y + v2 * center.z, {{i0, center.x}, {i1, center.y}, {i2, center.z}}, instanceIndex).valid();
+}
+
+bool PolytopeIntersector::intersectDraw(uint32_t firstVertex, uint32_t vertexCount, uint32_t firstInstance, uint32_t instanceCount)
+{
+    auto& arrayState = *arrayStateStack.back();
+    if (arrayState.topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || vertexCount < 3) return false;
+
+    size_t previous_numRecordedHits = _numRecordedHits;
+    uint32_t lastIndex = instanceCount > 1 ? (firstInstance + instanceCount) : firstInstance + 1;
+    for (uint32_t instanceIndex = firstInstance; instanceIndex < lastIndex && !done(); ++instanceIndex)
+    {
+        auto vertices = arrayState.vertexArray(instanceIndex);
+        if (!vertices) return false;
+
+        uint32_t endVertex = int((firstVertex + vertexCount) / 3.0f) * 3;
+
+        for (uint32_t i = firstVertex; i < endVertex && !done(); i += 3)
+        {
+            _intersectTriangle(*vertices, i, i + 1, i + 2, instanceIndex);
+        }
+    }
+
+    return _numRecordedHits != previous_numRecordedHits;
+}
+
+bool PolytopeIntersector::intersectDrawIndexed(uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance, uint32_t instanceCount)
+{
+    auto& arrayState = *arrayStateStack.back();
+    if (arrayState.topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || indexCount < 3 || (!ushort_indices && !uint_indices)) return false;
+
+    auto intersectTriangle = [&](const vec3Array& vertices, uint32_t i, uint32_t instanceIndex) {
+        if (ushort_indices)
+            _intersectTriangle(vertices, ushort_indices->at(i), ushort_indices->at(i + 1), ushort_indices->at(i + 2), instanceIndex);
+        else
+            _intersectTriangle(vertices, uint_indices->at(i), uint_indices->at(i + 1), uint_indices->at(i + 2), instanceIndex);
+        return !done();
+    };
+
+    size_t previous_numRecordedHits = _numRecordedHits;
+    uint32_t lastIndex = instanceCount > 1 ? (firstInstance + instanceCount) : firstInstance + 1;
+    for (uint32_t instanceIndex = firstInstance; instanceIndex < lastIndex && !done(); ++instanceIndex)
+    {
+        auto vertices = arrayState.vertexArray(instanceIndex);
+        if (!vertices) continue;
+
+        auto bvh = (vertices == arrayState.vertices) ? getOrCreateTriangleBVH(vertices, firstIndex, indexCount) : ref_ptr<const TriangleBVH>();
+        if (bvh)
+        {
+            // a box is outside the polytope if its corner furthest along a plane's normal is behind the plane
+            const auto& polytope = _polytopeStack.back();
+            auto insidePolytope = [&](const TriangleBVH::BVHNode& node) {
+                for (auto& pl : polytope)
+                {
+                    dvec3 corner(pl.n.x >= 0.0 ? node.max.x : node.min.x, pl.n.y >= 0.0 ? node.max.y : node.min.y, pl.n.z >= 0.0 ? node.max.z : node.min.z);
+                    if (vsg::distance(pl, corner) < 0.0) return false;
+                }
+                return true;
+            };
+
+            bvh->traverse(insidePolytope, [&](uint32_t i) { return intersectTriangle(*vertices, i, instanceIndex); });
+            continue;
+        }
+
+        uint32_t endIndex = int((firstIndex + indexCount) / 3.0f) * 3;
+
+        for (uint32_t i = firstIndex; i < endIndex; i += 3)
+        {
+            if (!intersectTriangle(*vertices, i, instanceIndex)) break;
+        }
+    }
+
+    return _numRecordedHits != previous_numRecordedHits;
+}
@@ -0,0 +1,240 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/nodes/Transform.h>
+#include <vsg/utils/SphereIntersector.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace vsg;
+
+// return the barycentric coordinates of the point on triangle (a, b, c) closest to p, from Ericson's Real-Time Collision Detection
+static dvec3 closestPointOnTriangle(const dvec3& p, const dvec3& a, const dvec3& b, const dvec3& c)
+{
+    dvec3 ab = b - a;
+    dvec3 ac = c - a;
+    dvec3 ap = p - a;
+    double d1 = dot(ab, ap);
+    double d2 = dot(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0) return dvec3(1.0, 0.0, 0.0);
+
+    dvec3 bp = p - b;
+    double d3 = dot(ab, bp);
+    double d4 = dot(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3) return dvec3(0.0, 1.0, 0.0);
+
+    double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+        double v = d1 / (d1 - d3);
+        return dvec3(1.0 - v, v, 0.0);
+    }
+
+    dvec3 cp = p - c;
+    double d5 = dot(ab, cp);
+    double d6 = dot(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6) return dvec3(0.0, 0.0, 1.0);
+
+    double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+        double w = d2 / (d2 - d6);
+        return dvec3(1.0 - w, 0.0, w);
+    }
+
+    double va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+    {
+        double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return dvec3(0.0, 1.0 - w, w);
+    }
+
+    double denom = 1.0 / (va + vb + vc);
+    double v = vb * denom;
+    double w = vc * denom;
+    return dvec3(1.0 - v - w, v, w);
+}
+
+SphereIntersector::SphereIntersector(const dsphere& in_sphere, ref_ptr<ArrayState> initialArrayData) :
+    Inherit(initialArrayData),
+    _sphere(in_sphere)
+{
+    _localSphereStack.push_back(LocalSphere{in_sphere.center, 1.0, dmat4{}});
+}
+
+SphereIntersector::Intersection::Intersection(const dvec3& in_localIntersection, const dvec3& in_worldIntersection, double in_distance, const dmat4& in_localToWorld, const NodePath& in_nodePath, const DataList& in_arrays, const IndexRatios& in_indexRatios, uint32_t in_instanceIndex) :
+    localIntersection(in_localIntersection),
+    worldIntersection(in_worldIntersection),
+    distance(in_distance),
+    localToWorld(in_localToWorld),
+    nodePath(in_nodePath),
+    arrays(in_arrays),
+    indexRatios(in_indexRatios),
+    instanceIndex(in_instanceIndex)
+{
+}
+
+ref_ptr<SphereIntersector::Intersection> SphereIntersector::add(const dvec3& coord, double distance, const IndexRatios& indexRatios, uint32_t instanceIndex)
+{
+    // avoid creating Intersection objects for hits that would be discarded
+    if (!recordHit(intersections, &Intersection::distance, distance)) return {};
+
+    auto localToWorld = computeTransform(_nodePath);
+    auto intersection = Intersection::create(coord, localToWorld * coord, distance, localToWorld, _nodePath, arrayStateStack.back()->arrays, indexRatios, instanceIndex);
+    intersections.emplace_back(intersection);
+
+    return intersection;
+}
+
+ref_ptr<Intersector> SphereIntersector::createSubgraphIntersector()
+{
+    auto subgraphIntersector = SphereIntersector::create(_sphere);
+    subgraphIntersector->_localSphereStack = _localSphereStack;
+    return subgraphIntersector;
+}
+
+void SphereIntersector::mergeSubgraphIntersectors(const std::vector<ref_ptr<Intersector>>& subgraphIntersectors)
+{
+    mergeIntersections<SphereIntersector>(intersections, &Intersection::distance, subgraphIntersectors);
+}
+
+void SphereIntersector::pushTransform(const Transform& transform)
+{
+    auto& l2wStack = localToWorldStack();
+    auto& w2lStack = worldToLocalStack();
+
+    dmat4 localToWorld = l2wStack.empty() ? transform.transform(dmat4{}) : transform.transform(l2wStack.back());
+    dmat4 worldToLocal = inverse(localToWorld);
+
+    l2wStack.push_back(localToWorld);
+    w2lStack.push_back(worldToLocal);
+
+    // the Frobenius norm of the upper 3x3 bounds how much worldToLocal can stretch a distance, so it's a safe scale for culling
+    double scale2 = 0.0;
+    for (int c = 0; c < 3; ++c)
+    {
+        scale2 += worldToLocal[c][0] * worldToLocal[c][0] + worldToLocal[c][1] * worldToLocal[c][1] + worldToLocal[c][2] * worldToLocal[c][2];
+    }
+
+    _localSphereStack.push_back(LocalSphere{worldToLocal * _sphere.center, std::sqrt(scale2), localToWorld});
+}
+
+void SphereIntersector::popTransform()
+{
+    _localSphereStack.pop_back();
+    localToWorldStack().pop_back();
+    worldToLocalStack().pop_back();
+}
+
+double SphereIntersector::_searchRadius() const
+{
+    if (hitMode == CLOSEST_HIT) return std::min(_sphere.radius, closestHit(intersections, &Intersection::distance));
+    return _sphere.radius;
+}
+
+bool SphereIntersector::intersects(const dsphere& bs)
+{
+    if (!bs.valid()) return false;
+
+    const auto& localSphere = _localSphereStack.back();
+    double radius = _searchRadius() * localSphere.scale + bs.radius;
+    return length2(bs.center - localSphere.center) <= radius * radius;
+}
+
+bool SphereIntersector::_intersectTriangle(const vec3Array& vertices, uint32_t i0, uint32_t i1, uint32_t i2, uint32_t instanceIndex)
+{
+    const auto& localToWorld = _localSphereStack.back().localToWorld;
+
+    const dvec3 v0(vertices.at(i0));
+    const dvec3 v1(vertices.at(i1));
+    const dvec3 v2(vertices.at(i2));
+
+    dvec3 r = closestPointOnTriangle(_sphere.center, localToWorld * v0, localToWorld * v1, localToWorld * v2);
+    dvec3 local = v0 * r.x + v1 * r.y + v2 * r.z;
+
+    double d = length(localToWorld * local - _sphere.center);
+    if (d > _searchRadius()) return false;
+
+    return add(local, d, {{i0, r.x}, {i1, r.y}, {i2, r.z}}, instanceIndex).valid();
+}
+
+bool SphereIntersector::intersectDraw(uint32_t firstVertex, uint32_t vertexCount, uint32_t firstInstance, uint32_t instanceCount)
+{
+    auto& arrayState = *arrayStateStack.back();
+    if (arrayState.topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || vertexCount < 3) return false;
+
+    size_t previous_numRecordedHits = _numRecordedHits;
+    uint32_t lastIndex = instanceCount > 1 ? (firstInstance + instanceCount) : firstInstance + 1;
+    for (uint32_t instanceIndex = firstInstance; instanceIndex < lastIndex && !done(); ++instanceIndex)
+    {
+        auto vertices = arrayState.vertexArray(instanceIndex);
+        if (!vertices) return false;
+
+        uint32_t endVertex = int((firstVertex + vertexCount) / 3.0f) * 3;
+
+        for (uint32_t i = firstVertex; i < endVertex && !done(); i += 3)
+        {
+            _intersectTriangle(*vertices, i, i + 1, i + 2, instanceIndex);
+        }
+    }
+
+    return _numRecordedHits != previous_numRecordedHits;
+}
+
+bool SphereIntersector::intersectDrawIndexed(uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance, uint32_t instanceCount)
+{
+    auto& arrayState = *arrayStateStack.back();
+    if (arrayState.topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || indexCount < 3 || (!ushort_indices && !uint_indices)) return false;
+
+    auto intersectTriangle = [&](const vec3Array& vertices, uint32_t i, uint32_t instanceIndex) {
+        if (ushort_indices)
+            _intersectTriangle(vertices, ushort_indices->at(i), ushort_indices->at(i + 1), ushort_indices->at(i + 2), instanceIndex);
+        else
+            _intersectTriangle(vertices, uint_indices->at(i), uint_indices->at(i + 1), uint_indices->at(i + 2), instanceIndex);
+        return !done();
+    };
+
+    size_t previous_numRecordedHits = _numRecordedHits;
+    uint32_t lastIndex = instanceCount > 1 ? (firstInstance + instanceCount) : firstInstance + 1;
+    for (uint32_t instanceIndex = firstInstance; instanceIndex < lastIndex && !done(); ++instanceIndex)
+    {
+        auto vertices = arrayState.vertexArray(instanceIndex);
+        if (!vertices) continue;
+
+        auto bvh = (vertices == arrayState.vertices) ? getOrCreateTriangleBVH(vertices, firstIndex, indexCount) : ref_ptr<const TriangleBVH>();
+        if (bvh)
+        {
+            // a box intersects the sphere if the point in the box closest to the sphere's center is within the radius
+            const auto& localSphere = _localSphereStack.back();
+            auto insideSphere = [&](const TriangleBVH::BVHNode& node) {
+                dvec3 closest(std::clamp(localSphere.center.x, double(node.min.x), double(node.max.x)),
+                              std::clamp(localSphere.center.y, double(node.min.y), double(node.max.y)),
+                              std::clamp(localSphere.center.z, double(node.min.z), double(node.max.z)));
+                double radius = _searchRadius() * localSphere.scale;
+                return length2(closest - localSphere.center) <= radius * radius;
+            };
+
+            bvh->traverse(insideSphere, [&](uint32_t i) { return intersectTriangle(*vertices, i, instanceIndex); });
+            continue;
+        }
+
+        uint32_t endIndex = int((firstIndex + indexCount) / 3.0f) * 3;
+
+        for (uint32_t i = firstIndex; i < endIndex; i += 3)
+        {
+            if (!intersectTriangle(*vertices, i, instanceIndex)) break;
+        }
+    }
+
+    return _numRecordedHits != previous_numRecordedHits;
+}
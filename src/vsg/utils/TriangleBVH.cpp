@@ -0,0 +1,269 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2023 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/utils/TriangleBVH.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace vsg;
+
+namespace
+{
+    struct BuildContext
+    {
+        TriangleBVH& bvh;
+        std::vector<uint32_t> triangleIndices;
+        std::vector<vec3> mins;
+        std::vector<vec3> maxs;
+        std::vector<vec3> centroids;
+
+        // permutation of triangles, each leaf references a contiguous range of it
+        std::vector<uint32_t> order;
+
+        void subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count)
+        {
+            const float inf = std::numeric_limits<float>::max();
+            vec3 bmin(inf, inf, inf), bmax(-inf, -inf, -inf);
+            vec3 cmin(inf, inf, inf), cmax(-inf, -inf, -inf);
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                uint32_t t = order[i];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    bmin[axis] = std::min(bmin[axis], mins[t][axis]);
+                    bmax[axis] = std::max(bmax[axis], maxs[t][axis]);
+                    cmin[axis] = std::min(cmin[axis], centroids[t][axis]);
+                    cmax[axis] = std::max(cmax[axis], centroids[t][axis]);
+                }
+            }
+
+            bvh.nodes[nodeIndex].min = bmin;
+            bvh.nodes[nodeIndex].max = bmax;
+
+            if (count <= std::max(bvh.maxTrianglesPerLeaf, 1u))
+            {
+                bvh.nodes[nodeIndex].first = first;
+                bvh.nodes[nodeIndex].count = count;
+                return;
+            }
+
+            // split at the median centroid along the axis of greatest centroid extent
+            vec3 extent = cmax - cmin;
+            int axis = (extent.x > extent.y) ? ((extent.x > extent.z) ? 0 : 2) : ((extent.y > extent.z) ? 1 : 2);
+
+            uint32_t half = count / 2;
+            auto begin = order.begin() + first;
+            std::nth_element(begin, begin + half, begin + count, [&](uint32_t lhs, uint32_t rhs) { return centroids[lhs][axis] < centroids[rhs][axis]; });
+
+            // first child follows this node, the second child's index is recorded once the first child's subtree is complete
+            uint32_t leftIndex = static_cast<uint32_t>(bvh.nodes.size());
+            bvh.nodes.emplace_back();
+            subdivide(leftIndex, first, half);
+
+            uint32_t rightIndex = static_cast<uint32_t>(bvh.nodes.size());
+            bvh.nodes.emplace_back();
+            subdivide(rightIndex, first + half, count - half);
+
+            bvh.nodes[nodeIndex].first = rightIndex;
+            bvh.nodes[nodeIndex].count = 0;
+        }
+    };
+
+    template<typename A>
+    void collectTriangles(BuildContext& context, const vec3Array& vertices, const A& indices, uint32_t firstIndex, uint32_t indexCount)
+    {
+        uint32_t endIndex = std::min(firstIndex + (indexCount / 3) * 3, static_cast<uint32_t>(indices.size() / 3) * 3);
+        size_t numTriangles = endIndex > firstIndex ? (endIndex - firstIndex) / 3 : 0;
+
+        context.triangleIndices.reserve(numTriangles);
+        context.mins.reserve(numTriangles);
+        context.maxs.reserve(numTriangles);
+        context.centroids.reserve(numTriangles);
+
+        for (uint32_t i = firstIndex; i < endIndex; i += 3)
+        {
+            uint32_t i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+            if (i0 >= vertices.size() || i1 >= vertices.size() || i2 >= vertices.size()) continue;
+
+            const vec3& v0 = vertices[i0];
+            const vec3& v1 = vertices[i1];
+            const vec3& v2 = vertices[i2];
+
+            vec3 tmin, tmax;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                tmin[axis] = std::min(v0[axis], std::min(v1[axis], v2[axis]));
+                tmax[axis] = std::max(v0[axis], std::max(v1[axis], v2[axis]));
+            }
+
+            context.triangleIndices.push_back(i);
+            context.mins.push_back(tmin);
+            context.maxs.push_back(tmax);
+            context.centroids.push_back((tmin + tmax) * 0.5f);
+        }
+    }
+} // namespace
+
+TriangleBVH::TriangleBVH()
+{
+}
+
+TriangleBVH::~TriangleBVH()
+{
+}
+
+void TriangleBVH::build(ref_ptr<const vec3Array> in_vertices, ref_ptr<const Data> in_indices, uint32_t in_firstIndex, uint32_t in_indexCount)
+{
+    nodes.clear();
+    triangles.clear();
+
+    // observer_ptr<> needs non const objects to attach its Auxiliary to
+    _vertices = const_cast<vec3Array*>(in_vertices.get());
+    _indices = const_cast<Data*>(in_indices.get());
+    _firstIndex = in_firstIndex;
+    _indexCount = in_indexCount;
+    if (in_vertices) in_vertices->getModifiedCount(_verticesModifiedCount);
+    if (in_indices) in_indices->getModifiedCount(_indicesModifiedCount);
+
+    if (!in_vertices || !in_indices) return;
+
+    BuildContext context{*this, {}, {}, {}, {}, {}};
+    if (auto us_indices = in_indices.cast<const ushortArray>())
+        collectTriangles(context, *in_vertices, *us_indices, _firstIndex, _indexCount);
+    else if (auto ui_indices = in_indices.cast<const uintArray>())
+        collectTriangles(context, *in_vertices, *ui_indices, _firstIndex, _indexCount);
+
+    uint32_t numTriangles = static_cast<uint32_t>(context.triangleIndices.size());
+    if (numTriangles == 0) return;
+
+    context.order.resize(numTriangles);
+    for (uint32_t t = 0; t < numTriangles; ++t) context.order[t] = t;
+
+    nodes.reserve(2 * (numTriangles / std::max(maxTrianglesPerLeaf, 1u)) + 1);
+    nodes.emplace_back();
+    context.subdivide(0, 0, numTriangles);
+
+    triangles.resize(numTriangles);
+    for (uint32_t i = 0; i < numTriangles; ++i) triangles[i] = context.triangleIndices[context.order[i]];
+}
+
+bool TriangleBVH::orphaned() const
+{
+    return !_vertices.valid() || !_indices.valid();
+}
+
+bool TriangleBVH::valid(const vec3Array* in_vertices, const Data* in_indices, uint32_t in_firstIndex, uint32_t in_indexCount) const
+{
+    if (!in_vertices || !in_indices) return false;
+
+    // the observers must still be valid so that new arrays allocated at the addresses of deleted ones aren't mistaken for them
+    return _vertices.valid() && _indices.valid() && _vertices == in_vertices && _indices == in_indices && _firstIndex == in_firstIndex && _indexCount == in_indexCount &&
+           !in_vertices->differentModifiedCount(_verticesModifiedCount) && !in_indices->differentModifiedCount(_indicesModifiedCount);
+}
+
+TriangleBVHCache::TriangleBVHCache()
+{
+}
+
+TriangleBVHCache::~TriangleBVHCache()
+{
+}
+
+ref_ptr<TriangleBVHCache>& TriangleBVHCache::instance()
+{
+    static ref_ptr<TriangleBVHCache> s_triangleBVHCache = TriangleBVHCache::create();
+    return s_triangleBVHCache;
+}
+
+ref_ptr<const TriangleBVH> TriangleBVHCache::getOrCreate(ref_ptr<const vec3Array> vertices, ref_ptr<const Data> indices, uint32_t firstIndex, uint32_t indexCount)
+{
+    if (!vertices || !indices) return {};
+
+    std::shared_ptr<Entry> entry;
+    bool needsPruning = false;
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+
+        auto& slot = _entries[Key{vertices.get(), indices.get(), firstIndex, indexCount}];
+        if (!slot) slot = std::make_shared<Entry>();
+        slot->lastUsed = ++_lookupCount;
+        entry = slot;
+
+        // prune at a fixed interval so entries for deleted arrays are discarded however few there are
+        needsPruning = pruneInterval > 0 && (_lookupCount % pruneInterval) == 0;
+    }
+
+    // build outside of the cache lock so that intersections with other meshes aren't blocked
+    ref_ptr<const TriangleBVH> result;
+    {
+        std::scoped_lock<std::mutex> lock(entry->mutex);
+        if (!entry->bvh || !entry->bvh->valid(vertices, indices, firstIndex, indexCount))
+        {
+            auto bvh = TriangleBVH::create();
+            bvh->build(vertices, indices, firstIndex, indexCount);
+            entry->bvh = bvh;
+        }
+        result = entry->bvh;
+    }
+
+    if (needsPruning) prune();
+
+    return result;
+}
+
+void TriangleBVHCache::prune()
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    // entries being built are skipped
+    auto erase = [&](std::map<Key, std::shared_ptr<Entry>>::iterator itr, bool orphanedOnly) -> bool {
+        auto& entry = itr->second;
+        std::unique_lock<std::mutex> entry_lock(entry->mutex, std::try_to_lock);
+        if (!entry_lock.owns_lock()) return false;
+        if (orphanedOnly && entry->bvh && !entry->bvh->orphaned()) return false;
+        entry_lock.unlock();
+        _entries.erase(itr);
+        return true;
+    };
+
+    for (auto itr = _entries.begin(); itr != _entries.end();)
+    {
+        auto current = itr++;
+        erase(current, true);
+    }
+
+    if (_entries.size() <= maxEntries) return;
+
+    std::vector<std::map<Key, std::shared_ptr<Entry>>::iterator> leastRecentlyUsed;
+    leastRecentlyUsed.reserve(_entries.size());
+    for (auto itr = _entries.begin(); itr != _entries.end(); ++itr) leastRecentlyUsed.push_back(itr);
+    std::sort(leastRecentlyUsed.begin(), leastRecentlyUsed.end(), [](auto& lhs, auto& rhs) { return lhs->second->lastUsed < rhs->second->lastUsed; });
+
+    size_t numToErase = _entries.size() - maxEntries;
+    for (auto itr = leastRecentlyUsed.begin(); numToErase > 0 && itr != leastRecentlyUsed.end(); ++itr)
+    {
+        if (erase(*itr, false)) --numToErase;
+    }
+}
+
+void TriangleBVHCache::clear()
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _entries.clear();
+}
+
+size_t TriangleBVHCache::size() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _entries.size();
+}
@@ -13,6 +13,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/app/View.h>
 #include <vsg/commands/BindIndexBuffer.h>
 #include <vsg/commands/BindVertexBuffers.h>
+#include <vsg/commands/DrawIndexedIndirect.h>
 #include <vsg/nodes/Bin.h>
 #include <vsg/nodes/DepthSorted.h>
 #include <vsg/nodes/Geometry.h>
@@ -274,3 +275,8 @@ void CollectResourceRequirements::apply(const BindIndexBuffer& bib)
 {
     apply(bib.indices);
 }
+
+void CollectResourceRequirements::apply(const DrawIndexedIndirect& dii)
+{
+    apply(dii.bufferInfo);
+}